@@ -7,7 +7,8 @@ _comp_cmd_dmidecode() {
 	prev=${COMP_WORDS[COMP_CWORD - 1]}
 
 	case $prev in
-	-d | --dev-mem | --dump-bin | --from-dump)
+	-d | --dev-mem | --dump-bin | --from-dump | --from-dump-list | --serve | \
+	--state-file | --diff)
 		if [[ $prev == -d || $prev == --dev-mem ]]; then
 			: "${cur:=/dev/}"
 		fi
@@ -24,13 +25,28 @@ _comp_cmd_dmidecode() {
 		COMPREPLY=($(compgen -W '$("$1" --list-types)' -- "$cur"))
 		return 0
 		;;
+	--from-dump-dir)
+		local IFS=$'\n'
+		compopt -o filenames
+		COMPREPLY=($(compgen -d -- "$cur"))
+		return 0
+		;;
+	--format)
+		COMPREPLY=($(compgen -W 'text json cbor' -- "$cur"))
+		return 0
+		;;
+	--serve-group)
+		COMPREPLY=($(compgen -g -- "$cur"))
+		return 0
+		;;
 	--dump-bin | --from-dump)
 		local IFS=$'\n'
 		compopt -o filenames
 		COMPREPLY=($(compgen -f -- "$cur"))
 		return 0
 		;;
-	-[hVH] | --help | --version | --handle | --oem-string)
+	-[hVH] | --help | --version | --handle | --oem-string | --field | --query | \
+	--serve-mode)
 		return 0
 		;;
 	esac
@@ -46,10 +62,28 @@ _comp_cmd_dmidecode() {
 			--list-types
 			--handle
 			--dump
+			--dump-all
 			--dump-bin
 			--from-dump
+			--from-dump-list
+			--from-dump-dir
+			--diff
 			--no-sysfs
+			--serve
+			--serve-mode
+			--serve-group
+			--resolve-address
+			--event-log
+			--follow
+			--state-file
+			--stats
 			--oem-string
+			--field
+			--key-value
+			--format
+			--query
+			--annotate-handles
+			--list-attributes
 			--version
 		' -- "$cur"))
 		return 0
@@ -16,19 +16,41 @@
 #endif
 #endif
 
+/* Default polling interval of the event log, in seconds (--follow) */
+#define DEFAULT_FOLLOW_INTERVAL 60
+
+/* Default permissions of the socket of the daemon (--serve-mode) */
+#define DEFAULT_SOCKET_MODE 0600
+
 /* Use mmap or not */
 #ifndef __BEOS__
 #define USE_MMAP
 #endif
 
-/* Use memory alignment workaround or not */
-#if defined(__ia64__) || defined(__arm__)
-#define ALIGNMENT_WORKAROUND
-#endif
-
 /* Avoid unaligned memcpy on /dev/mem */
 #ifdef __aarch64__
 #define USE_SLOW_MEMCPY
 #endif
 
+/* Decoder state is per thread in dmidecode-batch */
+#ifdef DMI_BATCH
+#define DMI_THREAD __thread
+#else
+#define DMI_THREAD
+#endif
+
+/*
+ * In dmidecode-batch, messages written while decoding a file are kept
+ * with the output of that file (see dmibatch.c), so stderr is per thread
+ * too. It is the process stderr outside of the workers.
+ */
+#ifdef DMI_BATCH
+#include <stdio.h>
+extern __thread FILE *batch_stderr;
+void batch_perror(const char *s);
+#undef stderr
+#define stderr (batch_stderr != NULL ? batch_stderr : (stderr))
+#define perror(s) batch_perror(s)
+#endif
+
 #endif
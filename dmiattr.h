@@ -0,0 +1,415 @@
+/* Generated from dmidecode.c and dmioem.c, do not edit */
+"16-bit Entry Point Address",
+"32-bit Entry Point Address",
+"3G",
+"A0 Bay Count",
+"A2 Bay Count",
+"ACPI WMI Supported",
+"APIC ID",
+"Access Address",
+"Access Method",
+"Accuracy",
+"Address",
+"Address Type",
+"Administrator Password Status",
+"Advanced Thermal Margining",
+"Area Length",
+"Array Handle",
+"Asset Tag",
+"Associated Components",
+"Associated Device Record",
+"Associated Handle",
+"Associated Memory Slots",
+"Associated Real/Phys Handle",
+"Associated SMBus Record",
+"Associativity",
+"Attributes Defined/Set",
+"BIOS Revision",
+"BSP",
+"Backplane Name",
+"Bank Connections",
+"Bank Locator",
+"Base Address",
+"Bay",
+"Bays Filled",
+"Block Size",
+"Bluetooth",
+"Board Type",
+"Boot Option",
+"Boot Option On Limit",
+"Boot-up State",
+"Box Number",
+"Bus Address",
+"Buttons",
+"CMOS Checksum Byte Count",
+"CMOS Checksum Offset",
+"CMOS Checksum Start Offset",
+"CPLD Version",
+"CPU ID",
+"Cache Size",
+"Capable Speed",
+"Capacity",
+"Change Token",
+"Characteristics",
+"Chassis Handle",
+"Check Value Index",
+"Checked Range End Index",
+"Checked Range Start Index",
+"Checksum",
+"Chemistry",
+"Chinese Algorithm Supported",
+"Chip Identifier",
+"Command I/O Address",
+"Command I/O Code",
+"Communication Function Key Number",
+"Component Handle",
+"Configuration",
+"Configured Memory Speed",
+"Configured Voltage",
+"Contained Elements",
+"Contained Object Handles",
+"Cooling Device Handle",
+"Cooling Unit Group",
+"Core Count",
+"Core Enabled",
+"Count",
+"Credential Bootstrapping Handle",
+"Current Interleave",
+"Current Speed",
+"Current Usage",
+"Currently Installed Language",
+"DIMM Manufacture Date",
+"DIMM Manufacturer",
+"DIMM Manufacturer Part Number",
+"DIMM Vendor Serial Number",
+"Data",
+"Data Bus Width",
+"Data Bus Width (Base)",
+"Data Port",
+"Data Start Offset",
+"Data Width",
+"Date",
+"Description",
+"Design Capacity",
+"Design Voltage",
+"Designation",
+"Device Address",
+"Device Characteristics",
+"Device Instance",
+"Device Location",
+"Device Name",
+"Device Path",
+"Device Sub-Instance",
+"Device Type",
+"DeviceID",
+"Devices",
+"Diagnostics",
+"Disable Reason",
+"Embedded SD Card",
+"Enabled Error Correcting Capabilities",
+"Enabled Size",
+"Enclosure",
+"Enclosure Bays",
+"Enclosure Model",
+"Enclosure Name",
+"Enclosure Serial",
+"Encryption Status",
+"Ending Address",
+"Error Condition",
+"Error Correcting Capabilities",
+"Error Correction Type",
+"Error Detecting Method",
+"Error Information Handle",
+"Error Status",
+"Events",
+"External Clock",
+"External Connector Type",
+"External Reference Designator",
+"FIPS Certification",
+"FRU I2C Address",
+"Family",
+"Features",
+"Fingerprint Reader",
+"Firmware Component Name",
+"Firmware ID",
+"Firmware Name String",
+"Firmware Revision",
+"Firmware Type",
+"Firmware Version",
+"Firmware Version String",
+"Flags",
+"Floppy Disk Port",
+"Form Factor",
+"Front Panel Reset Status",
+"Function bitmap for Application Button",
+"Function bitmap for Communication Button",
+"Function bitmap for Display Button",
+"Function bitmap for Media Button",
+"Function bitmap for Others Button",
+"Granularity",
+"Handle",
+"Hard Drive Type",
+"Header Format",
+"Header Length",
+"Header Revision",
+"Header Start Offset",
+"Header and Data",
+"Health Status",
+"Height",
+"Hidden",
+"Host IP Address Format",
+"Host IP Assignment Type",
+"Host Interface Type",
+"Hot Replaceable",
+"Hotkey Mappings",
+"I2C Address",
+"I2C Bus Number",
+"I2C Segment Number",
+"I2C Slave Address",
+"ID",
+"Image Size",
+"Inbound Connection",
+"Index Port",
+"Input Current Probe Handle",
+"Input Voltage Probe Handle",
+"Input Voltage Range Switching",
+"Installable Languages",
+"Installed SRAM Type",
+"Installed Size",
+"Interconnect Speed",
+"Interface",
+"Interface Type",
+"Interleave Position",
+"Interleaved Data Depth",
+"Internal Connector Type",
+"Internal Reference Designator",
+"Interrupt Number",
+"Interrupt Polarity",
+"Interrupt Trigger Mode",
+"Items",
+"Keyboard Password Status",
+"L1 Cache Handle",
+"L2 Cache Handle",
+"L3 Cache Handle",
+"Language Description Format",
+"Length",
+"Location",
+"Location In Chassis",
+"Locator",
+"Lock",
+"Logical Size",
+"Lower Critical Threshold",
+"Lower Non-critical Threshold",
+"Lower Non-recoverable Threshold",
+"Lowest Supported Firmware Version",
+"Lowest Supported Version",
+"MAC Address",
+"Management Device Handle",
+"Management Port",
+"Manufacture Date",
+"Manufacturer",
+"Manufacturer Name",
+"Max Power Capacity",
+"Max Speed",
+"Maximal Load",
+"Maximum Capacity",
+"Maximum Error",
+"Maximum Memory Module Size",
+"Maximum Power",
+"Maximum Size",
+"Maximum Total Memory Size",
+"Maximum Value",
+"Maximum Voltage",
+"Memory Array Address",
+"Memory Array Mapped Address Handle",
+"Memory Module Voltage",
+"Memory Operating Mode Capability",
+"Memory Subsystem Controller Manufacturer ID",
+"Memory Subsystem Controller Product ID",
+"Memory Technology",
+"Minimum Value",
+"Minimum Voltage",
+"Misc. Features",
+"Model Number",
+"Model Part Number",
+"Module Manufacturer ID",
+"Module Product ID",
+"Multiple Event Count Increment",
+"Multiple Event Time Window",
+"NV Storage Device",
+"NV Storage Device Address",
+"NVRAM ID",
+"Name",
+"Negotiated Speed",
+"Next Scheduled Power-on",
+"Nominal Speed",
+"Nominal Value",
+"Non-Volatile Size",
+"Number Of Devices",
+"Number Of Power Cords",
+"OEM Information",
+"OEM-specific Information",
+"Omega Features",
+"Operation",
+"Operational Mode",
+"Option ROM Measuring",
+"Outbound Connection",
+"PCI Class Code",
+"PCI Device",
+"PCI Device ID",
+"PCI Device Info",
+"PCI Express Generation",
+"PCI Part Number",
+"PCI Sub Class Code",
+"PCI Sub Device ID",
+"PCI Sub Vendor ID",
+"PCI Vendor ID",
+"PMIC0",
+"PMIC0 Manufacturer ID",
+"POST Results",
+"Package Version",
+"Parallel Port",
+"Parent Handle",
+"Parent Hub Port Instance",
+"Part Number",
+"Partition Row Position",
+"Partition Width",
+"Patch",
+"Peer Bifurcated Device",
+"Peer Devices",
+"Physical Address",
+"Physical Array Handle",
+"Physical Device Handle",
+"Physical Slot",
+"Physical Socket",
+"Pitch",
+"Plugged",
+"Port Instance",
+"Port Speed Capability",
+"Port Type",
+"Power Features",
+"Power Supply State",
+"Power Unit Group",
+"Power Wattage",
+"Power-On Password Status",
+"Poweron",
+"Pre-boot Log Reset CMOS Address",
+"Pre-boot Log Reset CMOS Bit",
+"Product Name",
+"Protocol ID",
+"QDF/S-SPEC",
+"RCD",
+"RCD Manufacturer ID",
+"ROM Size",
+"Rack Name",
+"Range Size",
+"Rank",
+"Redfish Service Hostname",
+"Redfish Service IP Address Format",
+"Redfish Service IP Discovery Type",
+"Redfish Service Port",
+"Redfish Service Vlan",
+"Reference Designation",
+"Referenced Handle",
+"Referenced Offset",
+"Register Spacing",
+"Release Date",
+"Reset Count",
+"Reset Limit",
+"Resolution",
+"Revision",
+"Riser ID",
+"Riser Name",
+"Riser Position",
+"Rotational Speed",
+"Runtime Size",
+"SAS Expander WWID",
+"SBDS Chemistry",
+"SBDS Manufacture Date",
+"SBDS Serial Number",
+"SBDS Version",
+"SKU Number",
+"Security Status",
+"Segment Group Number",
+"Serial Number",
+"Serial Port A",
+"Serial Port B",
+"Server Bay",
+"Service UUID",
+"Set",
+"Signature",
+"Size",
+"Slot Physical Width",
+"Socket Designation",
+"Specification Version",
+"Speed",
+"Standard Algorithm Supported",
+"Starting Address",
+"State",
+"Status",
+"String",
+"Strings",
+"Structured Name",
+"SubDeviceID",
+"SubVendorID",
+"Supported Command Classes Bitmap",
+"Supported Interleave",
+"Supported Log Type Descriptors",
+"Supported Memory Types",
+"Supported SRAM Types",
+"Supported Speeds",
+"System Management Type",
+"System Type",
+"Temperature Probe Handle",
+"Thermal State",
+"Thread Count",
+"Thread Enabled",
+"Threshold Handle",
+"Timeout",
+"Timer Interval",
+"Tokens",
+"Tolerance",
+"Total SAS Bays",
+"Total Width",
+"Trusted Module Attributes",
+"Type",
+"Type Detail",
+"Type Instance",
+"UEFI",
+"UEFI Device Name",
+"UEFI Device Path",
+"UEFI Location",
+"USB Capacity",
+"USB Class",
+"USB Product ID",
+"USB Protocol",
+"USB SubClass",
+"USB Vendor ID",
+"UUID",
+"Unique ID",
+"Upgrade",
+"Upper Critical Threshold",
+"Upper Non-critical Threshold",
+"Upper Non-recoverable Threshold",
+"Upstream Device",
+"Use",
+"Value",
+"Vendor",
+"Vendor ID",
+"Vendor Syndrome",
+"VendorID",
+"Version",
+"Version ID",
+"Version String",
+"Virtual Serial Port",
+"Volatile Size",
+"Voltage",
+"Wake-up Type",
+"Watchdog Timer",
+"WiFi",
+"WiMAX",
+"iCRU",
+"idProduct",
+"idVendor",
+"x2APIC",
+"x2APIC ID",
@@ -0,0 +1,350 @@
+/*
+ * DMI Decode, batch mode
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * dmidecode-batch decodes the files given with --from-dump-list or
+ * --from-dump-dir, same as dmidecode would, but with a pool of worker
+ * threads. It is built from the same sources as dmidecode, with DMI_BATCH
+ * defined so that the decoder state is per thread.
+ *
+ * Files are dealt to the workers in turn, each worker having its own
+ * queue. A worker takes files from the front of its queue, and when it
+ * runs out, steals from the back of the others' queues. The output of
+ * each file is captured in memory by the worker, then written out by the
+ * main thread, either in input order (the default, the output is then
+ * the same as that of dmidecode) or as soon as it is available. Either
+ * way it is preceded by a record naming the file.
+ *
+ * Error messages are captured the same way, through a per-thread stderr
+ * stream (see config.h), and written out with the output of their file.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "version.h"
+#include "config.h"
+#include "types.h"
+#include "dmidecode.h"
+#include "dmiopt.h"
+#include "dmioutput.h"
+
+struct batch_queue
+{
+	pthread_mutex_t lock;
+	unsigned int first;	/* Queue holds files first + n * jobs */
+	unsigned int head;	/* n of the next file to take */
+	unsigned int tail;	/* n of the last file to take, plus one */
+};
+
+struct batch_result
+{
+	char *buf;
+	size_t len;
+	char *err;		/* Error messages, if not in buf */
+	size_t err_len;
+	int ret;
+	int done;
+};
+
+static struct
+{
+	const struct opt *opt;	/* Options of the main thread */
+	char **files;
+	unsigned int jobs;
+	struct batch_queue *queue;
+	struct batch_result *result;
+	int *completed;		/* Files in completion order */
+	int ncompleted;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} pool;
+
+__thread FILE *batch_stderr;
+
+static ssize_t batch_err_write(void *cookie, const char *buf, size_t len)
+{
+	(void)cookie;
+
+	pr_part_error(buf, len);
+	return len;
+}
+
+void batch_perror(const char *s)
+{
+	char buf[128];
+	const char *msg = strerror_r(errno, buf, sizeof(buf));
+
+	if (s != NULL && *s)
+		fprintf(stderr, "%s: %s\n", s, msg);
+	else
+		fprintf(stderr, "%s\n", msg);
+}
+
+static int batch_take(struct batch_queue *q, int steal)
+{
+	int i = -1;
+
+	pthread_mutex_lock(&q->lock);
+	if (q->head < q->tail)
+	{
+		if (steal)
+			q->tail--;
+		i = q->first + (steal ? q->tail : q->head++) * pool.jobs;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return i;
+}
+
+/* Returns the next file to decode, -1 if there are none left */
+static int batch_next(unsigned int self)
+{
+	unsigned int n;
+	int i;
+
+	if ((i = batch_take(&pool.queue[self], 0)) >= 0)
+		return i;
+
+	for (n = 1; n < pool.jobs; n++)
+		if ((i = batch_take(&pool.queue[(self + n) % pool.jobs], 1)) >= 0)
+			return i;
+
+	return -1;
+}
+
+static void *batch_worker(void *arg)
+{
+	unsigned int self = *(unsigned int *)arg;
+	cookie_io_functions_t err_io = { .write = batch_err_write };
+	struct batch_result *r;
+	int i;
+
+	opt = *pool.opt;
+	pr_init(opt.format);
+
+	/* If this fails, messages go to the process stderr */
+	batch_stderr = fopencookie(NULL, "w", err_io);
+	if (batch_stderr != NULL)
+		setvbuf(batch_stderr, NULL, _IONBF, 0);
+
+	while ((i = batch_next(self)) >= 0)
+	{
+		r = &pool.result[i];
+
+		pr_part_start();
+		r->ret = dmi_decode_file(pool.files[i]);
+		r->buf = pr_part_end(&r->len);
+		r->err = pr_part_errors(&r->err_len);
+
+		pthread_mutex_lock(&pool.lock);
+		r->done = 1;
+		pool.completed[pool.ncompleted++] = i;
+		pthread_cond_broadcast(&pool.cond);
+		pthread_mutex_unlock(&pool.lock);
+	}
+
+	if (batch_stderr != NULL)
+	{
+		fclose(batch_stderr);
+		batch_stderr = NULL;
+	}
+
+	return NULL;
+}
+
+static int batch_run(char **files, int count)
+{
+	pthread_t *thread;
+	unsigned int *id;
+	unsigned int w, started = 0;
+	struct batch_result *r;
+	int i, k;
+	int ret = 0;
+
+	pool.opt = &opt;
+	pool.files = files;
+	pool.jobs = opt.jobs;
+	if (pool.jobs == 0)
+	{
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+		pool.jobs = n > 0 ? n : 1;
+	}
+	if (pool.jobs > (unsigned int)count)
+		pool.jobs = count;
+
+	pool.queue = calloc(pool.jobs, sizeof(struct batch_queue));
+	pool.result = calloc(count, sizeof(struct batch_result));
+	pool.completed = calloc(count, sizeof(int));
+	thread = calloc(pool.jobs, sizeof(pthread_t));
+	id = calloc(pool.jobs, sizeof(unsigned int));
+	if (pool.queue == NULL || pool.result == NULL
+	 || pool.completed == NULL || thread == NULL || id == NULL)
+	{
+		perror("calloc");
+		ret = 1;
+		goto out;
+	}
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.cond, NULL);
+
+	for (w = 0; w < pool.jobs; w++)
+	{
+		pthread_mutex_init(&pool.queue[w].lock, NULL);
+		pool.queue[w].first = w;
+		pool.queue[w].tail = (count - w + pool.jobs - 1) / pool.jobs;
+	}
+
+	/* Queues of workers which failed to start get stolen from */
+	for (w = 0; w < pool.jobs; w++)
+	{
+		id[w] = w;
+		if (pthread_create(&thread[w], NULL, batch_worker, &id[w]) != 0)
+		{
+			perror("pthread_create");
+			ret = 1;
+			break;
+		}
+		started++;
+	}
+	if (started == 0)
+		goto out_destroy;
+
+	for (k = 0; k < count; k++)
+	{
+		pthread_mutex_lock(&pool.lock);
+		if (opt.unordered)
+		{
+			while (pool.ncompleted <= k)
+				pthread_cond_wait(&pool.cond, &pool.lock);
+			i = pool.completed[k];
+		}
+		else
+		{
+			i = k;
+			while (!pool.result[i].done)
+				pthread_cond_wait(&pool.cond, &pool.lock);
+		}
+		pthread_mutex_unlock(&pool.lock);
+
+		r = &pool.result[i];
+		pr_file(files[i]);
+		if (r->len)
+			pr_write(r->buf, r->len);
+		free(r->buf);
+		r->buf = NULL;
+		if (r->err_len)
+			fwrite(r->err, 1, r->err_len, stderr);
+		free(r->err);
+		r->err = NULL;
+		ret |= r->ret;
+	}
+
+	for (w = 0; w < started; w++)
+		pthread_join(thread[w], NULL);
+
+out_destroy:
+	for (w = 0; w < pool.jobs; w++)
+		pthread_mutex_destroy(&pool.queue[w].lock);
+	pthread_cond_destroy(&pool.cond);
+	pthread_mutex_destroy(&pool.lock);
+out:
+	free(id);
+	free(thread);
+	free(pool.completed);
+	free(pool.result);
+	free(pool.queue);
+	return ret;
+}
+
+int main(int argc, char * const argv[])
+{
+	int ret = 0;
+	char **files;
+	int count;
+
+	/* Set default option values */
+	opt.devmem = DEFAULT_MEM_DEV;
+	opt.flags = 0;
+	opt.handle = ~0U;
+	opt.format = PR_FORMAT_TEXT;
+	opt.sockmode = DEFAULT_SOCKET_MODE;
+
+	if (parse_command_line(argc, argv) < 0)
+	{
+		ret = 2;
+		goto exit_free;
+	}
+
+	if (opt.flags & FLAG_LIST)
+	{
+		/* Already handled in parse_command_line() */
+		goto exit_free;
+	}
+
+	if (opt.flags & FLAG_HELP)
+	{
+		print_help();
+		goto exit_free;
+	}
+
+	if (opt.flags & FLAG_VERSION)
+	{
+		printf("%s\n", VERSION);
+		goto exit_free;
+	}
+
+	if (opt.dumplist == NULL && opt.dumpdir == NULL)
+	{
+		fprintf(stderr, "Option --from-dump-list or --from-dump-dir is required\n");
+		ret = 2;
+		goto exit_free;
+	}
+
+	count = dmi_dump_files(&files);
+	if (count < 0)
+	{
+		ret = 1;
+		goto exit_free;
+	}
+
+	pr_init(opt.format);
+
+	if (!(opt.flags & FLAG_QUIET))
+		pr_comment("dmidecode %s", VERSION);
+
+	if (count)
+		ret = batch_run(files, count);
+
+	pr_end();
+	dmi_dump_files_free(files, count);
+exit_free:
+	free(opt.type);
+	free(opt.string);
+	free(opt.query);
+
+	return ret;
+}
@@ -62,7 +62,11 @@
  *    https://loongson.github.io/LoongArch-Documentation/LoongArch-Vol1-EN.html#_cpucfg
  */
 
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <stdio.h>
 #include <string.h>
 #include <strings.h>
@@ -70,9 +74,9 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 
 #if defined(__FreeBSD__) || defined(__DragonFly__)
-#include <errno.h>
 #include <kenv.h>
 #endif
 
@@ -81,13 +85,18 @@
 #include "types.h"
 #include "util.h"
 #include "dmidecode.h"
+#include "dmiindex.h"
+#include "dmiindexpriv.h"
 #include "dmiopt.h"
 #include "dmioem.h"
 #include "dmioutput.h"
+#include "dmiserve.h"
+#include "dmistats.h"
+#include "probes.h"
 
 static const char *bad_index = "<BAD INDEX>";
 
-enum cpuid_type cpuid_type = cpuid_none;
+DMI_THREAD enum cpuid_type cpuid_type = cpuid_none;
 
 #define SUPPORTED_SMBIOS_VER 0x030700
 
@@ -114,19 +123,83 @@ int is_printable(const u8 *data, int len)
 	return 1;
 }
 
-/* Replace non-ASCII characters with dots */
-static void ascii_filter(char *bp, size_t len)
+/*
+ * The table may be a read-only view of a file, so strings which need
+ * filtering are filtered into a shadow copy of the table, at the same
+ * offset. Each table has its own shadow copy, which is only allocated if
+ * a string needs it.
+ */
+struct dmi_shadow
+{
+	const u8 *table;
+	u32 len;
+	char *buf;
+};
+
+static void shadow_init(struct dmi_shadow *shadow, const u8 *table, u32 len)
 {
-	size_t i;
+	shadow->table = table;
+	shadow->len = len;
+	shadow->buf = NULL;
+}
+
+static void shadow_free(struct dmi_shadow *shadow)
+{
+	free(shadow->buf);
+	shadow->table = NULL;
+	shadow->buf = NULL;
+}
+
+/* Replace non-ASCII characters with dots, returns a filtered copy */
+static const char *ascii_filter(const struct dmi_header *dm, const char *bp,
+				size_t len)
+{
+	struct dmi_shadow *shadow = dm->shadow;
+	size_t off, i;
+	char *p;
+
+	if (is_printable((const u8 *)bp, len))
+		return bp;
+
+	/* Strings always come from the table of the structure */
+	if (shadow == NULL || shadow->table == NULL)
+		return bp;
+	off = (const u8 *)bp - shadow->table;
+	if (off + len >= shadow->len)
+		return bp;
+	if (shadow->buf == NULL && (shadow->buf = malloc(shadow->len)) == NULL)
+	{
+		perror("malloc");
+		return bp;
+	}
 
+	p = shadow->buf + off;
 	for (i = 0; i < len; i++)
-		if (bp[i] < 32 || bp[i] >= 127)
-			bp[i] = '.';
+		p[i] = (bp[i] < 32 || bp[i] >= 127) ? '.' : bp[i];
+	p[len] = '\0';
+
+	return p;
 }
 
-static char *_dmi_string(const struct dmi_header *dm, u8 s, int filter)
+static const char *_dmi_string(const struct dmi_header *dm, u8 s, int filter)
 {
-	char *bp = (char *)dm->data;
+	const char *bp = (const char *)dm->data;
+
+	/*
+	 * Use the string offsets recorded in the index, unless the length
+	 * of the structure was fixed up after the index was built.
+	 */
+	if (dm->entry != NULL && dm->entry->length == dm->length)
+	{
+		if (s == 0)
+			s = 1;
+		if (s > dm->entry->string_count)
+			return NULL;
+
+		bp += dm->index->string[dm->entry->string + s - 1]
+		    - dm->entry->offset;
+		goto found;
+	}
 
 	bp += dm->length;
 	while (s > 1 && *bp)
@@ -139,15 +212,16 @@ static char *_dmi_string(const struct dmi_header *dm, u8 s, int filter)
 	if (!*bp)
 		return NULL;
 
+found:
 	if (filter)
-		ascii_filter(bp, strlen(bp));
+		bp = ascii_filter(dm, bp, strlen(bp));
 
 	return bp;
 }
 
 const char *dmi_string(const struct dmi_header *dm, u8 s)
 {
-	char *bp;
+	const char *bp;
 
 	if (s == 0)
 		return "Not Specified";
@@ -229,45 +303,41 @@ static int dmi_bcd_range(u8 value, u8 low, u8 high)
 
 static void dmi_dump(const struct dmi_header *h)
 {
-	static char raw_data[48];
+	static DMI_THREAD char raw_data[48];
 	int row, i;
-	unsigned int off;
-	char *s;
+	const char *s;
 
 	pr_list_start("Header and Data", NULL);
 	for (row = 0; row < ((h->length - 1) >> 4) + 1; row++)
 	{
-		off = 0;
-		for (i = 0; i < 16 && i < h->length - (row << 4); i++)
-			off += sprintf(raw_data + off, i ? " %02X" : "%02X",
-			       (h->data)[(row << 4) + i]);
-		pr_list_item(raw_data);
+		i = h->length - (row << 4);
+		hex_bytes(raw_data, h->data + (row << 4), i < 16 ? i : 16);
+		pr_list_item_str(raw_data);
 	}
 	pr_list_end();
 
 	if ((h->data)[h->length] || (h->data)[h->length + 1])
 	{
 		pr_list_start("Strings", NULL);
-		i = 1;
-		while ((s = _dmi_string(h, i++, !(opt.flags & FLAG_DUMP))))
+		for (i = 1; i <= 255
+		  && (s = _dmi_string(h, i, !(opt.flags & FLAG_DUMP))); i++)
 		{
 			if (opt.flags & FLAG_DUMP)
 			{
-				int j, l = strlen(s) + 1;
+				int l = strlen(s) + 1;
 
 				for (row = 0; row < ((l - 1) >> 4) + 1; row++)
 				{
-					off = 0;
-					for (j = 0; j < 16 && j < l - (row << 4); j++)
-						off += sprintf(raw_data + off,
-						       j ? " %02X" : "%02X",
-						       (unsigned char)s[(row << 4) + j]);
-					pr_list_item(raw_data);
+					hex_bytes(raw_data,
+						  (const u8 *)s + (row << 4),
+						  l - (row << 4) < 16 ?
+						  l - (row << 4) : 16);
+					pr_list_item_str(raw_data);
 				}
 				/* String isn't filtered yet so do it now */
-				ascii_filter(s, l - 1);
+				s = ascii_filter(h, s, l - 1);
 			}
-			pr_list_item("%s", s);
+			pr_list_item_str(s);
 		}
 		pr_list_end();
 	}
@@ -314,7 +384,7 @@ void dmi_print_memory_size(const char *attr, u64 code, int shift)
 	else
 		capacity = split[i];
 
-	pr_attr(attr, "%lu %s", capacity, unit[i + shift]);
+	pr_attr_size(attr, capacity, unit[i + shift]);
 }
 
 /*
@@ -394,13 +464,13 @@ static void dmi_bios_characteristics(u64 code)
 	 */
 	if (code.l & (1 << 3))
 	{
-		pr_list_item("%s", characteristics[0]);
+		pr_list_item_str(characteristics[0]);
 		return;
 	}
 
 	for (i = 4; i <= 31; i++)
 		if (code.l & (1 << i))
-			pr_list_item("%s", characteristics[i - 3]);
+			pr_list_item_str(characteristics[i - 3]);
 }
 
 static void dmi_bios_characteristics_x1(u8 code)
@@ -420,7 +490,7 @@ static void dmi_bios_characteristics_x1(u8 code)
 
 	for (i = 0; i <= 7; i++)
 		if (code & (1 << i))
-			pr_list_item("%s", characteristics[i]);
+			pr_list_item_str(characteristics[i]);
 }
 
 static void dmi_bios_characteristics_x2(u8 code)
@@ -439,7 +509,7 @@ static void dmi_bios_characteristics_x2(u8 code)
 
 	for (i = 0; i <= 6; i++)
 		if (code & (1 << i))
-			pr_list_item("%s", characteristics[i]);
+			pr_list_item_str(characteristics[i]);
 }
 
 /*
@@ -463,7 +533,7 @@ static void dmi_system_uuid(void (*print_cb)(const char *name, const char *forma
 		if (print_cb)
 			print_cb(attr, "Not Present");
 		else
-			printf("Not Present\n");
+			pr_text("Not Present\n");
 		return;
 	}
 	if (only0x00)
@@ -471,7 +541,7 @@ static void dmi_system_uuid(void (*print_cb)(const char *name, const char *forma
 		if (print_cb)
 			print_cb(attr, "Not Settable");
 		else
-			printf("Not Settable\n");
+			pr_text("Not Settable\n");
 		return;
 	}
 
@@ -491,7 +561,7 @@ static void dmi_system_uuid(void (*print_cb)(const char *name, const char *forma
 				p[3], p[2], p[1], p[0], p[5], p[4], p[7], p[6],
 				p[8], p[9], p[10], p[11], p[12], p[13], p[14], p[15]);
 		else
-			printf("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x\n",
+			pr_text("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x\n",
 				p[3], p[2], p[1], p[0], p[5], p[4], p[7], p[6],
 				p[8], p[9], p[10], p[11], p[12], p[13], p[14], p[15]);
 	}
@@ -503,7 +573,7 @@ static void dmi_system_uuid(void (*print_cb)(const char *name, const char *forma
 				p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
 				p[8], p[9], p[10], p[11], p[12], p[13], p[14], p[15]);
 		else
-			printf("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x\n",
+			pr_text("%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x\n",
 				p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
 				p[8], p[9], p[10], p[11], p[12], p[13], p[14], p[15]);
 	}
@@ -553,7 +623,7 @@ static void dmi_base_board_features(u8 code)
 		pr_list_start("Features", NULL);
 		for (i = 0; i <= 4; i++)
 			if (code & (1 << i))
-				pr_list_item("%s", features[i]);
+				pr_list_item_str(features[i]);
 	}
 	pr_list_end();
 }
@@ -588,7 +658,8 @@ static void dmi_base_board_handles(u8 count, const u8 *p)
 
 	pr_list_start("Contained Object Handles", "%u", count);
 	for (i = 0; i < count; i++)
-		pr_list_item("0x%04X", WORD(p + sizeof(u16) * i));
+		pr_list_item("0x%04X%s", WORD(p + sizeof(u16) * i),
+			     dmi_handle_ref(WORD(p + sizeof(u16) * i)));
 	pr_list_end();
 }
 
@@ -691,7 +762,7 @@ static const char *dmi_chassis_security_status(u8 code)
 static void dmi_chassis_height(u8 code)
 {
 	if (code == 0x00)
-		pr_attr("Height", "Unspecified");
+		pr_attr_str("Height", "Unspecified");
 	else
 		pr_attr("Height", "%u U", code);
 }
@@ -699,9 +770,9 @@ static void dmi_chassis_height(u8 code)
 static void dmi_chassis_power_cords(u8 code)
 {
 	if (code == 0x00)
-		pr_attr("Number Of Power Cords", "Unspecified");
+		pr_attr_str("Number Of Power Cords", "Unspecified");
 	else
-		pr_attr("Number Of Power Cords", "%u", code);
+		pr_attr_u32("Number Of Power Cords", code);
 }
 
 static void dmi_chassis_elements(u8 count, u8 len, const u8 *p)
@@ -1288,6 +1359,9 @@ static void dmi_processor_id(const struct dmi_header *h)
 		pr_attr("ID", "%02X %02X %02X %02X %02X %02X %02X %02X",
 			p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7]);
 
+	if (!pr_wanted("Signature") && !pr_wanted("Flags"))
+		return;
+
 	dmi_print_cpuid(pr_attr, "Signature", sig, p);
 
 	if (sig != cpuid_x86_intel && sig != cpuid_x86_amd)
@@ -1303,7 +1377,7 @@ static void dmi_processor_id(const struct dmi_header *h)
 		pr_list_start("Flags", NULL);
 		for (i = 0; i <= 31; i++)
 			if (flags[i] != NULL && edx & (1 << i))
-				pr_list_item("%s", flags[i]);
+				pr_list_item_str(flags[i]);
 	}
 	pr_list_end();
 }
@@ -1321,7 +1395,7 @@ static void dmi_processor_voltage(const char *attr, u8 code)
 	if (code & 0x80)
 		pr_attr(attr, "%.1f V", (float)(code & 0x7f) / 10);
 	else if ((code & 0x07) == 0x00)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 	{
 		char voltage_str[18];
@@ -1351,14 +1425,14 @@ static void dmi_processor_frequency(const char *attr, const u8 *p)
 		if (attr)
 			pr_attr(attr, "%u MHz", code);
 		else
-			printf("%u MHz\n", code);
+			pr_text("%u MHz\n", code);
 	}
 	else
 	{
 		if (attr)
-			pr_attr(attr, "Unknown");
+			pr_attr_str(attr, "Unknown");
 		else
-			printf("Unknown\n");
+			pr_text("Unknown\n");
 	}
 }
 
@@ -1476,12 +1550,12 @@ static void dmi_processor_cache(const char *attr, u16 code, const char *level,
 	if (code == 0xFFFF)
 	{
 		if (ver >= 0x0203)
-			pr_attr(attr, "Not Provided");
+			pr_attr_str(attr, "Not Provided");
 		else
 			pr_attr(attr, "No %s Cache", level);
 	}
 	else
-		pr_attr(attr, "0x%04X", code);
+		pr_attr(attr, "0x%04X%s", code, dmi_handle_ref(code));
 }
 
 static void dmi_processor_characteristics(const char *attr, u16 code)
@@ -1499,7 +1573,7 @@ static void dmi_processor_characteristics(const char *attr, u16 code)
 	};
 
 	if ((code & 0x00FC) == 0)
-		pr_attr(attr, "None");
+		pr_attr_str(attr, "None");
 	else
 	{
 		int i;
@@ -1507,7 +1581,7 @@ static void dmi_processor_characteristics(const char *attr, u16 code)
 		pr_list_start(attr, NULL);
 		for (i = 2; i <= 9; i++)
 			if (code & (1 << i))
-				pr_list_item("%s", characteristics[i - 2]);
+				pr_list_item_str(characteristics[i - 2]);
 		pr_list_end();
 	}
 }
@@ -1548,7 +1622,7 @@ static void dmi_memory_controller_ec_capabilities(const char *attr, u8 code)
 	};
 
 	if ((code & 0x3F) == 0)
-		pr_attr(attr, "None");
+		pr_attr_str(attr, "None");
 	else
 	{
 		int i;
@@ -1556,7 +1630,7 @@ static void dmi_memory_controller_ec_capabilities(const char *attr, u8 code)
 		pr_list_start(attr, NULL);
 		for (i = 0; i <= 5; i++)
 			if (code & (1 << i))
-				pr_list_item("%s", capabilities[i]);
+				pr_list_item_str(capabilities[i]);
 		pr_list_end();
 	}
 }
@@ -1591,7 +1665,7 @@ static void dmi_memory_controller_speeds(const char *attr, u16 code)
 	};
 
 	if ((code & 0x001F) == 0)
-		pr_attr(attr, "None");
+		pr_attr_str(attr, "None");
 	else
 	{
 		int i;
@@ -1599,7 +1673,7 @@ static void dmi_memory_controller_speeds(const char *attr, u16 code)
 		pr_list_start(attr, NULL);
 		for (i = 0; i <= 4; i++)
 			if (code & (1 << i))
-				pr_list_item("%s", speeds[i]);
+				pr_list_item_str(speeds[i]);
 		pr_list_end();
 	}
 }
@@ -1610,7 +1684,8 @@ static void dmi_memory_controller_slots(u8 count, const u8 *p)
 
 	pr_list_start("Associated Memory Slots", "%u", count);
 	for (i = 0; i < count; i++)
-		pr_list_item("0x%04X", WORD(p + sizeof(u16) * i));
+		pr_list_item("0x%04X%s", WORD(p + sizeof(u16) * i),
+			     dmi_handle_ref(WORD(p + sizeof(u16) * i)));
 	pr_list_end();
 }
 
@@ -1636,7 +1711,7 @@ static void dmi_memory_module_types(const char *attr, u16 code, int flat)
 	};
 
 	if ((code & 0x07FF) == 0)
-		pr_attr(attr, "None");
+		pr_attr_str(attr, "None");
 	else if (flat)
 	{
 		char type_str[68];
@@ -1662,7 +1737,7 @@ static void dmi_memory_module_types(const char *attr, u16 code, int flat)
 		pr_list_start(attr, NULL);
 		for (i = 0; i <= 10; i++)
 			if (code & (1 << i))
-				pr_list_item("%s", types[i]);
+				pr_list_item_str(types[i]);
 		pr_list_end();
 	}
 }
@@ -1670,11 +1745,11 @@ static void dmi_memory_module_types(const char *attr, u16 code, int flat)
 static void dmi_memory_module_connections(u8 code)
 {
 	if (code == 0xFF)
-		pr_attr("Bank Connections", "None");
+		pr_attr_str("Bank Connections", "None");
 	else if ((code & 0xF0) == 0xF0)
-		pr_attr("Bank Connections", "%u", code & 0x0F);
+		pr_attr_u32("Bank Connections", code & 0x0F);
 	else if ((code & 0x0F) == 0x0F)
-		pr_attr("Bank Connections", "%u", code >> 4);
+		pr_attr_u32("Bank Connections", code >> 4);
 	else
 		pr_attr("Bank Connections", "%u %u", code >> 4, code & 0x0F);
 }
@@ -1682,7 +1757,7 @@ static void dmi_memory_module_connections(u8 code)
 static void dmi_memory_module_speed(const char *attr, u8 code)
 {
 	if (code == 0)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "%u ns", code);
 }
@@ -1706,7 +1781,7 @@ static void dmi_memory_module_size(const char *attr, u8 code)
 			pr_attr(attr, "Disabled%s", connection);
 			break;
 		case 0x7F:
-			pr_attr(attr, "Not Installed");
+			pr_attr_str(attr, "Not Installed");
 			return;
 		default:
 			pr_attr(attr, "%u MB%s", 1 << (code & 0x7F),
@@ -1724,9 +1799,9 @@ static void dmi_memory_module_error(u8 code)
 	};
 
 	if (code & (1 << 2))
-		pr_attr("Error Status", "See Event Log");
+		pr_attr_str("Error Status", "See Event Log");
 	else
-		pr_attr("Error Status", "%s", status[code & 0x03]);
+		pr_attr_str("Error Status", status[code & 0x03]);
 }
 
 /*
@@ -1798,7 +1873,7 @@ static void dmi_cache_types(const char *attr, u16 code, int flat)
 	};
 
 	if ((code & 0x007F) == 0)
-		pr_attr(attr, "None");
+		pr_attr_str(attr, "None");
 	else if (flat)
 	{
 		char type_str[70];
@@ -1824,7 +1899,7 @@ static void dmi_cache_types(const char *attr, u16 code, int flat)
 		pr_list_start(attr, NULL);
 		for (i = 0; i <= 6; i++)
 			if (code & (1 << i))
-				pr_list_item("%s", types[i]);
+				pr_list_item_str(types[i]);
 		pr_list_end();
 	}
 }
@@ -2175,10 +2250,10 @@ static void dmi_slot_id(u8 code1, u8 code2, u8 type)
 	switch (type)
 	{
 		case 0x04: /* MCA */
-			pr_attr("ID", "%u", code1);
+			pr_attr_u32("ID", code1);
 			break;
 		case 0x05: /* EISA */
-			pr_attr("ID", "%u", code1);
+			pr_attr_u32("ID", code1);
 			break;
 		case 0x06: /* PCI */
 		case 0x0E: /* PCI */
@@ -2223,7 +2298,7 @@ static void dmi_slot_id(u8 code1, u8 code2, u8 type)
 		case 0xC2: /* PCI Express 5 */
 		case 0xC3: /* PCI Express 5 */
 		case 0xC4: /* PCI Express 6+ */
-			pr_attr("ID", "%u", code1);
+			pr_attr_u32("ID", code1);
 			break;
 		case 0x07: /* PCMCIA */
 			pr_attr("ID", "Adapter %u, Socket %u", code1, code2);
@@ -2256,9 +2331,9 @@ static void dmi_slot_characteristics(const char *attr, u8 code1, u8 code2)
 	};
 
 	if (code1 & (1 << 0))
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else if ((code1 & 0xFE) == 0 && code2 == 0)
-		pr_attr(attr, "None");
+		pr_attr_str(attr, "None");
 	else
 	{
 		int i;
@@ -2266,10 +2341,10 @@ static void dmi_slot_characteristics(const char *attr, u8 code1, u8 code2)
 		pr_list_start(attr, NULL);
 		for (i = 1; i <= 7; i++)
 			if (code1 & (1 << i))
-				pr_list_item("%s", characteristics1[i - 1]);
+				pr_list_item_str(characteristics1[i - 1]);
 		for (i = 0; i <= 7; i++)
 			if (code2 & (1 << i))
-				pr_list_item("%s", characteristics2[i]);
+				pr_list_item_str(characteristics2[i]);
 		pr_list_end();
 	}
 }
@@ -2337,7 +2412,7 @@ static void dmi_slot_information(u8 type, u8 code)
 		case 0xC3: /* PCI Express 5 */
 		case 0xC4: /* PCI Express 6+ */
 			if (code)
-				pr_attr("PCI Express Generation", "%u", code);
+				pr_attr_u32("PCI Express Generation", code);
 			break;
 	}
 }
@@ -2345,7 +2420,7 @@ static void dmi_slot_information(u8 type, u8 code)
 static void dmi_slot_physical_width(u8 code)
 {
 	if (code)
-		pr_attr("Slot Physical Width", "%s",
+		pr_attr_str("Slot Physical Width",
 			dmi_slot_bus_width(code));
 }
 
@@ -2404,7 +2479,7 @@ static const char *dmi_on_board_devices_type(u8 code)
 
 static void dmi_on_board_devices(const struct dmi_header *h)
 {
-	u8 *p = h->data + 4;
+	const u8 *p = h->data + 4;
 	u8 count = (h->length - 0x04) / 2;
 	int i;
 
@@ -2415,11 +2490,11 @@ static void dmi_on_board_devices(const struct dmi_header *h)
 		else
 			pr_handle_name("On Board Device %d Information",
 				       i + 1);
-		pr_attr("Type", "%s",
+		pr_attr_str("Type",
 			dmi_on_board_devices_type(p[2 * i] & 0x7F));
-		pr_attr("Status", "%s",
+		pr_attr_str("Status",
 			p[2 * i] & 0x80 ? "Enabled" : "Disabled");
-		pr_attr("Description", "%s", dmi_string(h, p[2 * i + 1]));
+		pr_attr_str("Description", dmi_string(h, p[2 * i + 1]));
 	}
 }
 
@@ -2430,14 +2505,14 @@ static void dmi_on_board_devices(const struct dmi_header *h)
 static void dmi_oem_strings(const struct dmi_header *h)
 {
 	char attr[11];
-	u8 *p = h->data + 4;
+	const u8 *p = h->data + 4;
 	u8 count = p[0x00];
 	int i;
 
 	for (i = 1; i <= count; i++)
 	{
 		sprintf(attr, "String %hhu", (u8)i);
-		pr_attr(attr, "%s",dmi_string(h, i));
+		pr_attr_str(attr,dmi_string(h, i));
 	}
 }
 
@@ -2448,14 +2523,14 @@ static void dmi_oem_strings(const struct dmi_header *h)
 static void dmi_system_configuration_options(const struct dmi_header *h)
 {
 	char attr[11];
-	u8 *p = h->data + 4;
+	const u8 *p = h->data + 4;
 	u8 count = p[0x00];
 	int i;
 
 	for (i = 1; i <= count; i++)
 	{
 		sprintf(attr, "Option %hhu", (u8)i);
-		pr_attr(attr, "%s",dmi_string(h, i));
+		pr_attr_str(attr,dmi_string(h, i));
 	}
 }
 
@@ -2465,12 +2540,12 @@ static void dmi_system_configuration_options(const struct dmi_header *h)
 
 static void dmi_bios_languages(const struct dmi_header *h)
 {
-	u8 *p = h->data + 4;
+	const u8 *p = h->data + 4;
 	u8 count = p[0x00];
 	int i;
 
 	for (i = 1; i <= count; i++)
-		pr_list_item("%s", dmi_string(h, i));
+		pr_list_item_str(dmi_string(h, i));
 }
 
 static const char *dmi_bios_language_format(u8 code)
@@ -2491,9 +2566,15 @@ static void dmi_group_associations_items(u8 count, const u8 *p)
 
 	for (i = 0; i < count; i++)
 	{
-		pr_list_item("0x%04X (%s)",
-			WORD(p + 3 * i + 1),
-			dmi_smbios_structure_type(p[3 * i]));
+		/* The annotation tells the actual type */
+		if (opt.flags & FLAG_ANNOTATE)
+			pr_list_item("0x%04X%s", WORD(p + 3 * i + 1),
+				dmi_handle_ref(WORD(p + 3 * i + 1)));
+		else
+			pr_list_item("0x%04X%s (%s)",
+				WORD(p + 3 * i + 1),
+				dmi_handle_ref(WORD(p + 3 * i + 1)),
+				dmi_smbios_structure_type(p[3 * i]));
 	}
 }
 
@@ -2545,13 +2626,13 @@ static void dmi_event_log_address(u8 method, const u8 *p)
 				WORD(p), WORD(p + 2));
 			break;
 		case 0x03:
-			pr_attr("Access Address", "0x%08X", DWORD(p));
+			pr_attr_hex32("Access Address", DWORD(p));
 			break;
 		case 0x04:
-			pr_attr("Access Address", "0x%04X", WORD(p));
+			pr_attr_hex16("Access Address", WORD(p));
 			break;
 		default:
-			pr_attr("Access Address", "Unknown");
+			pr_attr_str("Access Address", "Unknown");
 	}
 }
 
@@ -2639,15 +2720,153 @@ static void dmi_event_log_descriptors(u8 count, u8 len, const u8 *p)
 		if (len >= 0x02)
 		{
 			sprintf(attr, "Descriptor %d", i + 1);
-			pr_attr(attr, "%s",
+			pr_attr_str(attr,
 				dmi_event_log_descriptor_type(p[i * len]));
 			sprintf(attr, "Data Format %d", i + 1);
-			pr_attr(attr, "%s",
+			pr_attr_str(attr,
 				dmi_event_log_descriptor_format(p[i * len + 1]));
 		}
 	}
 }
 
+static void dmi_event_log_header(const u8 *p)
+{
+	/* 7.16.5.1 */
+	pr_attr("Multiple Event Time Window", "%u minute%s",
+		p[0x05], p[0x05] > 1 ? "s" : "");
+	pr_attr_u32("Multiple Event Count Increment", p[0x06]);
+	pr_attr_hex8("Pre-boot Log Reset CMOS Address", p[0x07]);
+	pr_attr_u32("Pre-boot Log Reset CMOS Bit", p[0x08]);
+	if (p[0x0A])
+	{
+		pr_attr_hex8("CMOS Checksum Start Offset", p[0x09]);
+		pr_attr_u32("CMOS Checksum Byte Count", p[0x0A]);
+		pr_attr_hex8("CMOS Checksum Offset", p[0x0B]);
+	}
+	pr_attr_u32("Header Revision", p[0x0F]);
+}
+
+/* Data format of an event type, from the supported descriptors */
+static int dmi_event_log_format(u8 type, u8 count, u8 len, const u8 *p)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		if (p[i * len] == type)
+			return p[i * len + 1];
+
+	return -1;
+}
+
+static void dmi_event_log_record(const u8 *p, int format)
+{
+	/* 7.16.6 */
+	u8 len = p[0x01] & 0x7F;
+	char data[3 * 0x80];
+	int i;
+
+	/* Years 80 to 99 are 1980 to 1999, dates are BCD */
+	pr_subattr("Date", "%s%02X-%02X-%02X %02X:%02X:%02X",
+		p[0x02] >= 0x80 ? "19" : "20",
+		p[0x02], p[0x03], p[0x04], p[0x05], p[0x06], p[0x07]);
+	pr_subattr_str("Status", (p[0x01] & 0x80) ? "Unread" : "Read");
+
+	/* 7.16.6.2 */
+	switch (format)
+	{
+		case 0x00:
+			return;
+		case 0x01:
+			if (len < 0x0A) break;
+			pr_subattr("Handle", "0x%04X%s",
+				WORD(p + 0x08), dmi_handle_ref(WORD(p + 0x08)));
+			return;
+		case 0x02:
+			if (len < 0x0C) break;
+			pr_subattr_u32("Count", DWORD(p + 0x08));
+			return;
+		case 0x03:
+			if (len < 0x0E) break;
+			pr_subattr("Handle", "0x%04X%s",
+				WORD(p + 0x08), dmi_handle_ref(WORD(p + 0x08)));
+			pr_subattr_u32("Count", DWORD(p + 0x0A));
+			return;
+		case 0x04:
+			if (len < 0x10) break;
+			pr_subattr("POST Results", "0x%08X 0x%08X",
+				DWORD(p + 0x08), DWORD(p + 0x0C));
+			return;
+		case 0x05:
+			if (len < 0x0C) break;
+			pr_subattr("System Management Type", "0x%08X",
+				DWORD(p + 0x08));
+			return;
+		case 0x06:
+			if (len < 0x10) break;
+			pr_subattr("System Management Type", "0x%08X",
+				DWORD(p + 0x08));
+			pr_subattr_u32("Count", DWORD(p + 0x0C));
+			return;
+	}
+
+	/* OEM-specific or unknown format, or record too short */
+	if (len <= 0x08)
+		return;
+	for (i = 0; i < len - 0x08; i++)
+		sprintf(data + 3 * i, "%02X ", p[0x08 + i]);
+	data[3 * i - 1] = '\0';
+	pr_subattr_str("Data", data);
+}
+
+/* Whether there is no log record at offset off, before offset end */
+static int dmi_event_log_end(const u8 *log, u32 off, u32 end)
+{
+	/* Unused log space is normally 0xFF */
+	return off + 0x02 > end || log[off] == 0xFF || log[off + 1] == 0x00;
+}
+
+/*
+ * Decode the log records found from offset start to offset end of the
+ * log area, and return the offset where the log ends. The number of
+ * records is added to n, and the beginning of the last one is copied
+ * to last.
+ */
+static u32 dmi_event_log_records(const struct dmi_header *h, const u8 *log,
+				 u32 start, u32 end, unsigned int *n, u8 *last)
+{
+	const u8 *data = h->data;
+	char attr[24];
+	u32 off = start;
+	u8 count = 0, len;
+
+	/* Without descriptors, the data format of records is unknown */
+	if (h->length >= 0x17 && data[0x16] >= 0x02
+	 && h->length >= 0x17 + data[0x15] * data[0x16])
+		count = data[0x15];
+
+	while (!dmi_event_log_end(log, off, end))
+	{
+		len = log[off + 1] & 0x7F;
+		if (len < 0x08 || off + len > end)
+		{
+			pr_sync();
+			fprintf(stderr, "Invalid event log record at offset "
+				"0x%04X.\n", off);
+			break;
+		}
+
+		sprintf(attr, "Event %u", ++*n);
+		pr_attr_str(attr, dmi_event_log_descriptor_type(log[off]));
+		dmi_event_log_record(log + off,
+			dmi_event_log_format(log[off], count, data[0x16],
+					     data + 0x17));
+		memcpy(last, log + off, 8);
+		off += len;
+	}
+
+	return off;
+}
+
 /*
  * 7.17 Physical Memory Array (Type 16)
  */
@@ -2721,11 +2940,12 @@ static const char *dmi_memory_array_ec_type(u8 code)
 static void dmi_memory_array_error_handle(u16 code)
 {
 	if (code == 0xFFFE)
-		pr_attr("Error Information Handle", "Not Provided");
+		pr_attr_str("Error Information Handle", "Not Provided");
 	else if (code == 0xFFFF)
-		pr_attr("Error Information Handle", "No Error");
+		pr_attr_str("Error Information Handle", "No Error");
 	else
-		pr_attr("Error Information Handle", "0x%04X", code);
+		pr_attr("Error Information Handle", "0x%04X%s", code,
+			dmi_handle_ref(code));
 }
 
 /*
@@ -2738,7 +2958,7 @@ static void dmi_memory_device_width(const char *attr, u16 code)
 	 * If no memory module is present, width may be 0
 	 */
 	if (code == 0xFFFF || (code == 0 && !(opt.flags & FLAG_NO_QUIRKS)))
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "%u bits", code);
 }
@@ -2746,9 +2966,9 @@ static void dmi_memory_device_width(const char *attr, u16 code)
 static void dmi_memory_device_size(u16 code)
 {
 	if (code == 0)
-		pr_attr("Size", "No Module Installed");
+		pr_attr_str("Size", "No Module Installed");
 	else if (code == 0xFFFF)
-		pr_attr("Size", "Unknown");
+		pr_attr_str("Size", "Unknown");
 	else
 	{
 		u64 s = { .l = code & 0x7FFF };
@@ -2777,7 +2997,7 @@ static void dmi_memory_device_extended_size(u32 code)
 static void dmi_memory_voltage_value(const char *attr, u16 code)
 {
 	if (code == 0)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, code % 100 ? "%g V" : "%.1f V",
 			(float)code / 1000);
@@ -2813,11 +3033,11 @@ static const char *dmi_memory_device_form_factor(u8 code)
 static void dmi_memory_device_set(u8 code)
 {
 	if (code == 0)
-		pr_attr("Set", "None");
+		pr_attr_str("Set", "None");
 	else if (code == 0xFF)
-		pr_attr("Set", "Unknown");
+		pr_attr_str("Set", "Unknown");
 	else
-		pr_attr("Set", "%u", code);
+		pr_attr_u32("Set", code);
 }
 
 static const char *dmi_memory_device_type(u8 code)
@@ -2890,7 +3110,7 @@ static void dmi_memory_device_type_detail(u16 code)
 	char list[172];		/* Update length if you touch the array above */
 
 	if ((code & 0xFFFE) == 0)
-		pr_attr("Type Detail", "None");
+		pr_attr_str("Type Detail", "None");
 	else
 	{
 		int i, off = 0;
@@ -2909,14 +3129,14 @@ static void dmi_memory_device_speed(const char *attr, u16 code1, u32 code2)
 	if (code1 == 0xFFFF)
 	{
 		if (code2 == 0)
-			pr_attr(attr, "Unknown");
+			pr_attr_str(attr, "Unknown");
 		else
 			pr_attr(attr, "%lu MT/s", code2);
 	}
 	else
 	{
 		if (code1 == 0)
-			pr_attr(attr, "Unknown");
+			pr_attr_str(attr, "Unknown");
 		else
 			pr_attr(attr, "%u MT/s", code1);
 	}
@@ -2935,9 +3155,9 @@ static void dmi_memory_technology(u8 code)
 		"Intel Optane DC persistent memory" /* 0x07 */
 	};
 	if (code >= 0x01 && code <= 0x07)
-		pr_attr("Memory Technology", "%s", technology[code - 0x01]);
+		pr_attr_str("Memory Technology", technology[code - 0x01]);
 	else
-		pr_attr("Memory Technology", "%s", out_of_spec);
+		pr_attr_str("Memory Technology", out_of_spec);
 }
 
 static void dmi_memory_operating_mode_capability(u16 code)
@@ -2953,7 +3173,7 @@ static void dmi_memory_operating_mode_capability(u16 code)
 	char list[99];		/* Update length if you touch the array above */
 
 	if ((code & 0xFFFE) == 0)
-		pr_attr("Memory Operating Mode Capability", "None");
+		pr_attr_str("Memory Operating Mode Capability", "None");
 	else {
 		int i, off = 0;
 
@@ -2974,7 +3194,7 @@ static void dmi_memory_manufacturer_id(const char *attr, u16 code)
 	/* 7.17.17 */
 	/* LSB is 7-bit Odd Parity number of continuation codes */
 	if (code == 0)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "Bank %d, Hex 0x%02X",
 			(code & 0x7F) + 1, code >> 8);
@@ -2985,9 +3205,9 @@ static void dmi_memory_product_id(const char *attr, u16 code)
 	/* 7.18.9 */
 	/* 7.18.11 */
 	if (code == 0)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
-		pr_attr(attr, "0x%04X", code);
+		pr_attr_hex16(attr, code);
 }
 
 static void dmi_memory_size(const char *attr, u64 code)
@@ -2995,9 +3215,9 @@ static void dmi_memory_size(const char *attr, u64 code)
 	/* 7.18.12 */
 	/* 7.18.13 */
 	if (code.h == 0xFFFFFFFF && code.l == 0xFFFFFFFF)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else if (code.h == 0x0 && code.l == 0x0)
-		pr_attr(attr, "None");
+		pr_attr_str(attr, "None");
 	else
 		dmi_print_memory_size(attr, code, 0);
 }
@@ -3011,7 +3231,7 @@ static void dmi_memory_revision(const char *attr_type, u16 code, u8 mem_type)
 	if (code == 0xFF00)
 	{
 		snprintf(attr, sizeof(attr), "%s Revision Number", attr_type);
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	}
 	else if (mem_type == 0x22 || mem_type == 0x23)	/* DDR5 */
 	{
@@ -3031,7 +3251,7 @@ static void dmi_memory_revision(const char *attr_type, u16 code, u8 mem_type)
 		{
 			snprintf(attr, sizeof(attr), "%s Device Type",
 				 attr_type);
-			pr_attr(attr, "Not Installed");
+			pr_attr_str(attr, "Not Installed");
 		}
 	}
 	else						/* Generic fallback */
@@ -3104,17 +3324,17 @@ static const char *dmi_memory_error_operation(u8 code)
 static void dmi_memory_error_syndrome(u32 code)
 {
 	if (code == 0x00000000)
-		pr_attr("Vendor Syndrome", "Unknown");
+		pr_attr_str("Vendor Syndrome", "Unknown");
 	else
-		pr_attr("Vendor Syndrome", "0x%08X", code);
+		pr_attr_hex32("Vendor Syndrome", code);
 }
 
 static void dmi_32bit_memory_error_address(const char *attr, u32 code)
 {
 	if (code == 0x80000000)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
-		pr_attr(attr, "0x%08X", code);
+		pr_attr_hex32(attr, code);
 }
 
 /*
@@ -3124,7 +3344,7 @@ static void dmi_32bit_memory_error_address(const char *attr, u32 code)
 static void dmi_mapped_address_size(u32 code)
 {
 	if (code == 0)
-		pr_attr("Range Size", "Invalid");
+		pr_attr_str("Range Size", "Invalid");
 	else
 	{
 		u64 size;
@@ -3138,7 +3358,7 @@ static void dmi_mapped_address_size(u32 code)
 static void dmi_mapped_address_extended_size(u64 start, u64 end)
 {
 	if (start.h == end.h && start.l == end.l)
-		pr_attr("Range Size", "Invalid");
+		pr_attr_str("Range Size", "Invalid");
 	else
 		dmi_print_memory_size("Range Size", u64_range(start, end), 0);
 }
@@ -3150,11 +3370,11 @@ static void dmi_mapped_address_extended_size(u64 start, u64 end)
 static void dmi_mapped_address_row_position(u8 code)
 {
 	if (code == 0)
-		pr_attr("Partition Row Position", "%s", out_of_spec);
+		pr_attr_str("Partition Row Position", out_of_spec);
 	else if (code == 0xFF)
-		pr_attr("Partition Row Position", "Unknown");
+		pr_attr_str("Partition Row Position", "Unknown");
 	else
-		pr_attr("Partition Row Position", "%u", code);
+		pr_attr_u32("Partition Row Position", code);
 }
 
 static void dmi_mapped_address_interleave_position(u8 code)
@@ -3162,9 +3382,9 @@ static void dmi_mapped_address_interleave_position(u8 code)
 	if (code != 0)
 	{
 		if (code == 0xFF)
-			pr_attr("Interleave Position", "Unknown");
+			pr_attr_str("Interleave Position", "Unknown");
 		else
-			pr_attr("Interleave Position", "%u", code);
+			pr_attr_u32("Interleave Position", code);
 	}
 }
 
@@ -3173,9 +3393,9 @@ static void dmi_mapped_address_interleaved_data_depth(u8 code)
 	if (code != 0)
 	{
 		if (code == 0xFF)
-			pr_attr("Interleaved Data Depth", "Unknown");
+			pr_attr_str("Interleaved Data Depth", "Unknown");
 		else
-			pr_attr("Interleaved Data Depth", "%u", code);
+			pr_attr_u32("Interleaved Data Depth", code);
 	}
 }
 
@@ -3257,7 +3477,7 @@ static const char *dmi_battery_chemistry(u8 code)
 static void dmi_battery_capacity(u16 code, u8 multiplier)
 {
 	if (code == 0)
-		pr_attr("Design Capacity", "Unknown");
+		pr_attr_str("Design Capacity", "Unknown");
 	else
 		pr_attr("Design Capacity", "%u mWh", code * multiplier);
 }
@@ -3265,7 +3485,7 @@ static void dmi_battery_capacity(u16 code, u8 multiplier)
 static void dmi_battery_voltage(u16 code)
 {
 	if (code == 0)
-		pr_attr("Design Voltage", "Unknown");
+		pr_attr_str("Design Voltage", "Unknown");
 	else
 		pr_attr("Design Voltage", "%u mV", code);
 }
@@ -3273,7 +3493,7 @@ static void dmi_battery_voltage(u16 code)
 static void dmi_battery_maximum_error(u8 code)
 {
 	if (code == 0xFF)
-		pr_attr("Maximum Error", "Unknown");
+		pr_attr_str("Maximum Error", "Unknown");
 	else
 		pr_attr("Maximum Error", "%u%%", code);
 }
@@ -3298,15 +3518,15 @@ static const char *dmi_system_reset_boot_option(u8 code)
 static void dmi_system_reset_count(const char *attr, u16 code)
 {
 	if (code == 0xFFFF)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
-		pr_attr(attr, "%u", code);
+		pr_attr_u32(attr, code);
 }
 
 static void dmi_system_reset_timer(const char *attr, u16 code)
 {
 	if (code == 0xFFFF)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "%u min", code);
 }
@@ -3407,7 +3627,7 @@ static const char *dmi_probe_status(u8 code)
 static void dmi_voltage_probe_value(const char *attr, u16 code)
 {
 	if (code == 0x8000)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "%.3f V", (float)(i16)code / 1000);
 }
@@ -3415,7 +3635,7 @@ static void dmi_voltage_probe_value(const char *attr, u16 code)
 static void dmi_voltage_probe_resolution(u16 code)
 {
 	if (code == 0x8000)
-		pr_attr("Resolution", "Unknown");
+		pr_attr_str("Resolution", "Unknown");
 	else
 		pr_attr("Resolution", "%.1f mV", (float)code / 10);
 }
@@ -3423,7 +3643,7 @@ static void dmi_voltage_probe_resolution(u16 code)
 static void dmi_probe_accuracy(u16 code)
 {
 	if (code == 0x8000)
-		pr_attr("Accuracy", "Unknown");
+		pr_attr_str("Accuracy", "Unknown");
 	else
 		pr_attr("Accuracy", "%.2f%%", (float)code / 100);
 }
@@ -3461,7 +3681,7 @@ static const char *dmi_cooling_device_type(u8 code)
 static void dmi_cooling_device_speed(u16 code)
 {
 	if (code == 0x8000)
-		pr_attr("Nominal Speed", "Unknown Or Non-rotating");
+		pr_attr_str("Nominal Speed", "Unknown Or Non-rotating");
 	else
 		pr_attr("Nominal Speed", "%u rpm", code);
 }
@@ -3499,7 +3719,7 @@ static const char *dmi_temperature_probe_location(u8 code)
 static void dmi_temperature_probe_value(const char *attr, u16 code)
 {
 	if (code == 0x8000)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "%.1f deg C", (float)(i16)code / 10);
 }
@@ -3507,7 +3727,7 @@ static void dmi_temperature_probe_value(const char *attr, u16 code)
 static void dmi_temperature_probe_resolution(u16 code)
 {
 	if (code == 0x8000)
-		pr_attr("Resolution", "Unknown");
+		pr_attr_str("Resolution", "Unknown");
 	else
 		pr_attr("Resolution", "%.3f deg C", (float)code / 1000);
 }
@@ -3519,7 +3739,7 @@ static void dmi_temperature_probe_resolution(u16 code)
 static void dmi_current_probe_value(const char *attr, u16 code)
 {
 	if (code == 0x8000)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "%.3f A", (float)(i16)code / 1000);
 }
@@ -3527,7 +3747,7 @@ static void dmi_current_probe_value(const char *attr, u16 code)
 static void dmi_current_probe_resolution(u16 code)
 {
 	if (code == 0x8000)
-		pr_attr("Resolution", "Unknown");
+		pr_attr_str("Resolution", "Unknown");
 	else
 		pr_attr("Resolution", "%.1f mA", (float)code / 10);
 }
@@ -3566,7 +3786,7 @@ static const char *dmi_system_boot_status(u8 code)
 static void dmi_64bit_memory_error_address(const char *attr, u64 code)
 {
 	if (code.h == 0x80000000 && code.l == 0x00000000)
-		pr_attr(attr, "Unknown");
+		pr_attr_str(attr, "Unknown");
 	else
 		pr_attr(attr, "0x%08X%08X", code.h, code.l);
 }
@@ -3583,16 +3803,19 @@ static void dmi_64bit_memory_error_address(const char *attr, u64 code)
  */
 static void dmi_fixup_type_34(struct dmi_header *h, int display)
 {
-	u8 *p = h->data;
+	const u8 *p = h->data;
 
 	/* Make sure the hidden data is ASCII only */
 	if (h->length == 0x10
 	 && is_printable(p + 0x0B, 0x10 - 0x0B))
 	{
 		if (!(opt.flags & FLAG_QUIET) && display)
+		{
+			pr_sync();
 			fprintf(stderr,
 				"Invalid entry length (%u). Fixed up to %u.\n",
 				0x10, 0x0B);
+		}
 		h->length = 0x0B;
 	}
 }
@@ -3664,11 +3887,12 @@ static void dmi_memory_channel_devices(u8 count, const u8 *p)
 	for (i = 1; i <= count; i++)
 	{
 		sprintf(attr, "Device %hhu Load", (u8)i);
-		pr_attr(attr, "%u", p[3 * i]);
+		pr_attr_u32(attr, p[3 * i]);
 		if (!(opt.flags & FLAG_QUIET))
 		{
 			sprintf(attr, "Device %hhu Handle", (u8)i);
-			pr_attr(attr, "0x%04X", WORD(p + 3 * i + 1));
+			pr_attr(attr, "0x%04X%s", WORD(p + 3 * i + 1),
+				dmi_handle_ref(WORD(p + 3 * i + 1)));
 		}
 	}
 }
@@ -3729,7 +3953,7 @@ static const char *dmi_ipmi_register_spacing(u8 code)
 static void dmi_power_supply_power(u16 code)
 {
 	if (code == 0x8000)
-		pr_attr("Max Power Capacity", "Unknown");
+		pr_attr_str("Max Power Capacity", "Unknown");
 	else
 		pr_attr("Max Power Capacity", "%u W", (unsigned int)code);
 }
@@ -3796,7 +4020,7 @@ static const char *dmi_power_supply_range_switching(u8 code)
 
 static void dmi_additional_info(const struct dmi_header *h)
 {
-	u8 *p = h->data + 4;
+	const u8 *p = h->data + 4;
 	u8 count = *p++;
 	u8 length;
 	int i, offset = 5;
@@ -3810,11 +4034,11 @@ static void dmi_additional_info(const struct dmi_header *h)
 		length = p[0x00];
 		if (length < 0x05 || h->length < offset + length) break;
 
-		pr_attr("Referenced Handle", "0x%04x",
-			WORD(p + 0x01));
+		pr_attr("Referenced Handle", "0x%04x%s",
+			WORD(p + 0x01), dmi_handle_ref(WORD(p + 0x01)));
 		pr_attr("Referenced Offset", "0x%02x",
 			p[0x03]);
-		pr_attr("String", "%s",
+		pr_attr_str("String",
 			dmi_string(h, p[0x04]));
 
 		switch (length - 0x05)
@@ -3829,7 +4053,7 @@ static void dmi_additional_info(const struct dmi_header *h)
 				pr_attr("Value", "0x%08x", DWORD(p + 0x05));
 				break;
 			default:
-				pr_attr("Value", "Unexpected size");
+				pr_attr_str("Value", "Unexpected size");
 				break;
 		}
 
@@ -3923,7 +4147,7 @@ static const char *dmi_address_type(u8 type)
 /*
  *  DSP0270: 8.4.3 Protocol Address decode
  */
-static const char *dmi_address_decode(u8 *data, char *storage, u8 addrtype)
+static const char *dmi_address_decode(const u8 *data, char *storage, u8 addrtype)
 {
 	if (addrtype == 0x1) /* IPv4 */
 		return inet_ntop(AF_INET, data, storage, 64);
@@ -3935,11 +4159,11 @@ static const char *dmi_address_decode(u8 *data, char *storage, u8 addrtype)
 /*
  * DSP0270: 8.4: Parse the protocol record format
  */
-static void dmi_parse_protocol_record(u8 *rec)
+static void dmi_parse_protocol_record(const u8 *rec)
 {
 	u8 rid;
 	u8 rlen;
-	u8 *rdata;
+	const u8 *rdata;
 	char buf[64];
 	u8 assign_val;
 	u8 addrtype;
@@ -3993,13 +4217,13 @@ static void dmi_parse_protocol_record(u8 *rec)
 	 * uses decimal, so as to make it more comparable
 	 */
 	assign_val = rdata[16];
-	pr_subattr("Host IP Assignment Type", "%s",
+	pr_subattr_str("Host IP Assignment Type",
 		dmi_protocol_assignment_type(assign_val));
 
 	/* DSP0270: 8.4.1: Redfish Over IP Host Address format */
 	addrtype = rdata[17];
 	addrstr = dmi_address_type(addrtype);
-	pr_subattr("Host IP Address Format", "%s",
+	pr_subattr_str("Host IP Address Format",
 		addrstr);
 
 	/* DSP0270: 8.4.1 IP Assignment types */
@@ -4008,25 +4232,25 @@ static void dmi_parse_protocol_record(u8 *rec)
 	{
 		/* DSP0270: 8.4.1: the Host IPv[4|6] Address */
 		sprintf(attr, "%s Address", addrstr);
-		pr_subattr(attr, "%s",
+		pr_subattr_str(attr,
 			dmi_address_decode(&rdata[18], buf, addrtype));
 
 		/* DSP0270: 8.4.1: Prints the Host IPv[4|6] Mask */
 		sprintf(attr, "%s Mask", addrstr);
-		pr_subattr(attr, "%s",
+		pr_subattr_str(attr,
 			dmi_address_decode(&rdata[34], buf, addrtype));
 	}
 
 	/* DSP0270: 8.4.1: Get the Redfish Service IP Discovery Type */
 	assign_val = rdata[50];
 	/* Redfish Service IP Discovery type mirrors Host IP Assignment type */
-	pr_subattr("Redfish Service IP Discovery Type", "%s",
+	pr_subattr_str("Redfish Service IP Discovery Type",
 		dmi_protocol_assignment_type(assign_val));
 
 	/* DSP0270: 8.4.1: Get the Redfish Service IP Address Format */
 	addrtype = rdata[51];
 	addrstr = dmi_address_type(addrtype);
-	pr_subattr("Redfish Service IP Address Format", "%s",
+	pr_subattr_str("Redfish Service IP Address Format",
 		addrstr);
 
 	if (assign_val == 0x1 || assign_val == 0x3)
@@ -4036,13 +4260,13 @@ static void dmi_parse_protocol_record(u8 *rec)
 
 		/* DSP0270: 8.4.1: Prints the Redfish IPv[4|6] Service Address */
 		sprintf(attr, "%s Redfish Service Address", addrstr);
-		pr_subattr(attr, "%s",
+		pr_subattr_str(attr,
 			dmi_address_decode(&rdata[52], buf,
 			addrtype));
 
 		/* DSP0270: 8.4.1: Prints the Redfish IPv[4|6] Service Mask */
 		sprintf(attr, "%s Redfish Service Mask", addrstr);
-		pr_subattr(attr, "%s",
+		pr_subattr_str(attr,
 			dmi_address_decode(&rdata[68], buf,
 			addrtype));
 
@@ -4050,7 +4274,7 @@ static void dmi_parse_protocol_record(u8 *rec)
 		port = WORD(&rdata[84]);
 		vlan = DWORD(&rdata[86]);
 		pr_subattr("Redfish Service Port", "%hu", port);
-		pr_subattr("Redfish Service Vlan", "%u", vlan);
+		pr_subattr_u32("Redfish Service Vlan", vlan);
 	}
 
 	/* DSP0270: 8.4.1: Redfish host length and name */
@@ -4107,14 +4331,14 @@ static void dmi_device_characteristics(u16 code)
 
 		for (i = 0; i < 1; i++)
 			if (code & (1 << i))
-				pr_list_item("%s", characteristics[i]);
+				pr_list_item_str(characteristics[i]);
 	}
 }
 
 static void dmi_parse_controller_structure(const struct dmi_header *h)
 {
 	int i;
-	u8 *data = h->data;
+	const u8 *data = h->data;
 	/* Host interface type */
 	u8 type;
 	/* Host Interface specific data length */
@@ -4141,7 +4365,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 		return;
 
 	type = data[0x4];
-	pr_attr("Host Interface Type", "%s",
+	pr_attr_str("Host Interface Type",
 		dmi_management_controller_host_type(type));
 
 	/*
@@ -4156,12 +4380,12 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 		/* DSP0270: 8.3.1 Table 3: Device Type values */
 		type = data[0x6];
 
-		pr_attr("Device Type", "%s",
+		pr_attr_str("Device Type",
 			dmi_parse_device_type(type));
 		if (type == 0x2 && len >= 5)
 		{
 			/* USB Device Type - need at least 6 bytes */
-			u8 *usbdata = &data[0x7];
+			const u8 *usbdata = &data[0x7];
 			/* USB Device Descriptor: idVendor */
 			pr_attr("idVendor", "0x%04x",
 				WORD(&usbdata[0x0]));
@@ -4176,7 +4400,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 		else if (type == 0x3 && len >= 9)
 		{
 			/* PCI Device Type - Need at least 8 bytes */
-			u8 *pcidata = &data[0x7];
+			const u8 *pcidata = &data[0x7];
 			/* PCI Device Descriptor: VendorID */
 			pr_attr("VendorID", "0x%04x",
 				WORD(&pcidata[0x0]));
@@ -4193,7 +4417,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 		else if (type == 0x4 && len >= 0x0d)
 		{
 			/* USB Device Type v2 - need at least 12 bytes */
-			u8 *usbdata = &data[7];
+			const u8 *usbdata = &data[7];
 			/* USB Device Descriptor v2: idVendor */
 			pr_attr("idVendor", "0x%04x",
 				WORD(&usbdata[0x1]));
@@ -4230,7 +4454,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 		else if (type == 0x5 && len >= 0x14)
 		{
 			/* PCI Device Type v2 - Need at least 19 bytes */
-			u8 *pcidata = &data[0x7];
+			const u8 *pcidata = &data[0x7];
 			/* PCI Device Descriptor v2: VendorID */
 			pr_attr("VendorID", "0x%04x",
 				WORD(&pcidata[0x1]));
@@ -4270,7 +4494,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 		else if (type >= 0x80 && len >= 5)
 		{
 			/* OEM Device Type - Need at least 4 bytes */
-			u8 *oemdata = &data[0x7];
+			const u8 *oemdata = &data[0x7];
 			/* OEM Device Descriptor: IANA */
 			pr_attr("Vendor ID", "0x%02x:0x%02x:0x%02x:0x%02x",
 				oemdata[0x0], oemdata[0x1],
@@ -4292,6 +4516,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 	total_read++;
 	if (total_read > h->length)
 	{
+		pr_sync();
 		fprintf(stderr,
 			"Total read length %d exceeds total structure length %d (handle 0x%04hx)\n",
 			total_read, h->length, h->handle);
@@ -4302,7 +4527,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 	count = data[0x0];
 	if (count)
 	{
-		u8 *rec = &data[0x1];
+		const u8 *rec = &data[0x1];
 		for (i = 0; i < count; i++)
 		{
 			/*
@@ -4314,6 +4539,7 @@ static void dmi_parse_controller_structure(const struct dmi_header *h)
 			total_read += rec[1] + 2;
 			if (total_read > h->length)
 			{
+				pr_sync();
 				fprintf(stderr,
 					"Total read length %d exceeds total structure length %d (handle 0x%04hx, record %d)\n",
 					total_read, h->length, h->handle, i + 1);
@@ -4356,7 +4582,7 @@ static void dmi_tpm_vendor_id(const u8 *p)
 	/* Terminate the string */
 	vendor_id[i] = '\0';
 
-	pr_attr("Vendor ID", "%s", vendor_id);
+	pr_attr_str("Vendor ID", vendor_id);
 }
 
 static void dmi_tpm_characteristics(u64 code)
@@ -4375,13 +4601,13 @@ static void dmi_tpm_characteristics(u64 code)
 	 */
 	if (code.l & (1 << 2))
 	{
-		pr_list_item("%s", characteristics[0]);
+		pr_list_item_str(characteristics[0]);
 		return;
 	}
 
 	for (i = 3; i <= 5; i++)
 		if (code.l & (1 << i))
-			pr_list_item("%s", characteristics[i - 2]);
+			pr_list_item_str(characteristics[i - 2]);
 }
 
 /*
@@ -4427,7 +4653,8 @@ static void dmi_firmware_components(u8 count, const u8 *p)
 
 	pr_list_start("Associated Components", "%u", count);
 	for (i = 0; i < count; i++)
-		pr_list_item("0x%04X", WORD(p + sizeof(u16) * i));
+		pr_list_item("0x%04X%s", WORD(p + sizeof(u16) * i),
+			     dmi_handle_ref(WORD(p + sizeof(u16) * i)));
 	pr_list_end();
 }
 
@@ -4447,11 +4674,11 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 0: /* 7.1 BIOS Information */
 			pr_handle_name("BIOS Information");
 			if (h->length < 0x12) break;
-			pr_attr("Vendor", "%s",
+			pr_attr_str("Vendor",
 				dmi_string(h, data[0x04]));
-			pr_attr("Version", "%s",
+			pr_attr_str("Version",
 				dmi_string(h, data[0x05]));
-			pr_attr("Release Date", "%s",
+			pr_attr_str("Release Date",
 				dmi_string(h, data[0x08]));
 			/*
 			 * On IA-64 and UEFI-based systems, the BIOS base
@@ -4484,48 +4711,49 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 1: /* 7.2 System Information */
 			pr_handle_name("System Information");
 			if (h->length < 0x08) break;
-			pr_attr("Manufacturer", "%s",
+			pr_attr_str("Manufacturer",
 				dmi_string(h, data[0x04]));
-			pr_attr("Product Name", "%s",
+			pr_attr_str("Product Name",
 				dmi_string(h, data[0x05]));
-			pr_attr("Version", "%s",
+			pr_attr_str("Version",
 				dmi_string(h, data[0x06]));
-			pr_attr("Serial Number", "%s",
+			pr_attr_str("Serial Number",
 				dmi_string(h, data[0x07]));
 			if (h->length < 0x19) break;
 			dmi_system_uuid(pr_attr, "UUID", data + 0x08, ver);
-			pr_attr("Wake-up Type", "%s",
+			pr_attr_str("Wake-up Type",
 				dmi_system_wake_up_type(data[0x18]));
 			if (h->length < 0x1B) break;
-			pr_attr("SKU Number", "%s",
+			pr_attr_str("SKU Number",
 				dmi_string(h, data[0x19]));
-			pr_attr("Family", "%s",
+			pr_attr_str("Family",
 				dmi_string(h, data[0x1A]));
 			break;
 
 		case 2: /* 7.3 Base Board Information */
 			pr_handle_name("Base Board Information");
 			if (h->length < 0x08) break;
-			pr_attr("Manufacturer", "%s",
+			pr_attr_str("Manufacturer",
 				dmi_string(h, data[0x04]));
-			pr_attr("Product Name", "%s",
+			pr_attr_str("Product Name",
 				dmi_string(h, data[0x05]));
-			pr_attr("Version", "%s",
+			pr_attr_str("Version",
 				dmi_string(h, data[0x06]));
-			pr_attr("Serial Number", "%s",
+			pr_attr_str("Serial Number",
 				dmi_string(h, data[0x07]));
 			if (h->length < 0x09) break;
-			pr_attr("Asset Tag", "%s",
+			pr_attr_str("Asset Tag",
 				dmi_string(h, data[0x08]));
 			if (h->length < 0x0A) break;
 			dmi_base_board_features(data[0x09]);
 			if (h->length < 0x0E) break;
-			pr_attr("Location In Chassis", "%s",
+			pr_attr_str("Location In Chassis",
 				dmi_string(h, data[0x0A]));
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Chassis Handle", "0x%04X",
-					WORD(data + 0x0B));
-			pr_attr("Type", "%s",
+				pr_attr("Chassis Handle", "0x%04X%s",
+					WORD(data + 0x0B),
+					dmi_handle_ref(WORD(data + 0x0B)));
+			pr_attr_str("Type",
 				dmi_base_board_type(data[0x0D]));
 			if (h->length < 0x0F) break;
 			if (h->length < 0x0F + data[0x0E] * sizeof(u16)) break;
@@ -4536,29 +4764,29 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 3: /* 7.4 Chassis Information */
 			pr_handle_name("Chassis Information");
 			if (h->length < 0x09) break;
-			pr_attr("Manufacturer", "%s",
+			pr_attr_str("Manufacturer",
 				dmi_string(h, data[0x04]));
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_chassis_type(data[0x05]));
-			pr_attr("Lock", "%s",
+			pr_attr_str("Lock",
 				dmi_chassis_lock(data[0x05] >> 7));
-			pr_attr("Version", "%s",
+			pr_attr_str("Version",
 				dmi_string(h, data[0x06]));
-			pr_attr("Serial Number", "%s",
+			pr_attr_str("Serial Number",
 				dmi_string(h, data[0x07]));
-			pr_attr("Asset Tag", "%s",
+			pr_attr_str("Asset Tag",
 				dmi_string(h, data[0x08]));
 			if (h->length < 0x0D) break;
-			pr_attr("Boot-up State", "%s",
+			pr_attr_str("Boot-up State",
 				dmi_chassis_state(data[0x09]));
-			pr_attr("Power Supply State", "%s",
+			pr_attr_str("Power Supply State",
 				dmi_chassis_state(data[0x0A]));
-			pr_attr("Thermal State", "%s",
+			pr_attr_str("Thermal State",
 				dmi_chassis_state(data[0x0B]));
-			pr_attr("Security Status", "%s",
+			pr_attr_str("Security Status",
 				dmi_chassis_security_status(data[0x0C]));
 			if (h->length < 0x11) break;
-			pr_attr("OEM Information", "0x%08X",
+			pr_attr_hex32("OEM Information",
 				DWORD(data + 0x0D));
 			if (h->length < 0x13) break;
 			dmi_chassis_height(data[0x11]);
@@ -4567,87 +4795,96 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			if (h->length < 0x15 + data[0x13] * data[0x14]) break;
 			dmi_chassis_elements(data[0x13], data[0x14], data + 0x15);
 			if (h->length < 0x16 + data[0x13] * data[0x14]) break;
-			pr_attr("SKU Number", "%s",
+			pr_attr_str("SKU Number",
 				dmi_string(h, data[0x15 + data[0x13] * data[0x14]]));
 			break;
 
 		case 4: /* 7.5 Processor Information */
 			pr_handle_name("Processor Information");
 			if (h->length < 0x1A) break;
-			pr_attr("Socket Designation", "%s",
+			pr_attr_str("Socket Designation",
 				dmi_string(h, data[0x04]));
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_processor_type(data[0x05]));
-			pr_attr("Family", "%s",
-				dmi_processor_family(h, ver));
-			pr_attr("Manufacturer", "%s",
+			if (pr_wanted("Family"))
+				pr_attr_str("Family",
+					dmi_processor_family(h, ver));
+			pr_attr_str("Manufacturer",
 				dmi_string(h, data[0x07]));
 			dmi_processor_id(h);
-			pr_attr("Version", "%s",
+			pr_attr_str("Version",
 				dmi_string(h, data[0x10]));
-			dmi_processor_voltage("Voltage", data[0x11]);
-			dmi_processor_frequency("External Clock", data + 0x12);
-			dmi_processor_frequency("Max Speed", data + 0x14);
-			dmi_processor_frequency("Current Speed", data + 0x16);
+			if (pr_wanted("Voltage"))
+				dmi_processor_voltage("Voltage", data[0x11]);
+			if (pr_wanted("External Clock"))
+				dmi_processor_frequency("External Clock", data + 0x12);
+			if (pr_wanted("Max Speed"))
+				dmi_processor_frequency("Max Speed", data + 0x14);
+			if (pr_wanted("Current Speed"))
+				dmi_processor_frequency("Current Speed", data + 0x16);
 			if (data[0x18] & (1 << 6))
 				pr_attr("Status", "Populated, %s",
 					dmi_processor_status(data[0x18] & 0x07));
 			else
-				pr_attr("Status", "Unpopulated");
-			pr_attr("Upgrade", "%s",
+				pr_attr_str("Status", "Unpopulated");
+			pr_attr_str("Upgrade",
 				dmi_processor_upgrade(data[0x19]));
 			if (h->length < 0x20) break;
 			if (!(opt.flags & FLAG_QUIET))
 			{
-				dmi_processor_cache("L1 Cache Handle",
-						    WORD(data + 0x1A), "L1", ver);
-				dmi_processor_cache("L2 Cache Handle",
-						    WORD(data + 0x1C), "L2", ver);
-				dmi_processor_cache("L3 Cache Handle",
-						    WORD(data + 0x1E), "L3", ver);
+				if (pr_wanted("L1 Cache Handle"))
+					dmi_processor_cache("L1 Cache Handle",
+							    WORD(data + 0x1A), "L1", ver);
+				if (pr_wanted("L2 Cache Handle"))
+					dmi_processor_cache("L2 Cache Handle",
+							    WORD(data + 0x1C), "L2", ver);
+				if (pr_wanted("L3 Cache Handle"))
+					dmi_processor_cache("L3 Cache Handle",
+							    WORD(data + 0x1E), "L3", ver);
 			}
 			if (h->length < 0x23) break;
-			pr_attr("Serial Number", "%s",
+			pr_attr_str("Serial Number",
 				dmi_string(h, data[0x20]));
-			pr_attr("Asset Tag", "%s",
+			pr_attr_str("Asset Tag",
 				dmi_string(h, data[0x21]));
-			pr_attr("Part Number", "%s",
+			pr_attr_str("Part Number",
 				dmi_string(h, data[0x22]));
 			if (h->length < 0x28) break;
 			if (data[0x23] != 0)
-				pr_attr("Core Count", "%u",
+				pr_attr_u32("Core Count",
 					h->length >= 0x2C && data[0x23] == 0xFF ?
 					WORD(data + 0x2A) : data[0x23]);
 			if (data[0x24] != 0)
-				pr_attr("Core Enabled", "%u",
+				pr_attr_u32("Core Enabled",
 					h->length >= 0x2E && data[0x24] == 0xFF ?
 					WORD(data + 0x2C) : data[0x24]);
 			if (data[0x25] != 0)
-				pr_attr("Thread Count", "%u",
+				pr_attr_u32("Thread Count",
 					h->length >= 0x30 && data[0x25] == 0xFF ?
 					WORD(data + 0x2E) : data[0x25]);
 			if (h->length >= 0x32 && WORD(data + 0x30) != 0)
-				pr_attr("Thread Enabled", "%u",
+				pr_attr_u32("Thread Enabled",
 					WORD(data + 0x30));
-			dmi_processor_characteristics("Characteristics",
-						      WORD(data + 0x26));
+			if (pr_wanted("Characteristics"))
+				dmi_processor_characteristics("Characteristics",
+							      WORD(data + 0x26));
 			break;
 
 		case 5: /* 7.6 Memory Controller Information */
 			pr_handle_name("Memory Controller Information");
 			if (h->length < 0x0F) break;
-			pr_attr("Error Detecting Method", "%s",
+			pr_attr_str("Error Detecting Method",
 				dmi_memory_controller_ed_method(data[0x04]));
 			dmi_memory_controller_ec_capabilities("Error Correcting Capabilities",
 							      data[0x05]);
-			pr_attr("Supported Interleave", "%s",
+			pr_attr_str("Supported Interleave",
 				dmi_memory_controller_interleave(data[0x06]));
-			pr_attr("Current Interleave", "%s",
+			pr_attr_str("Current Interleave",
 				dmi_memory_controller_interleave(data[0x07]));
-			pr_attr("Maximum Memory Module Size", "%u MB",
-				1 << data[0x08]);
-			pr_attr("Maximum Total Memory Size", "%u MB",
-				data[0x0E] * (1 << data[0x08]));
+			pr_attr_size("Maximum Memory Module Size",
+				     1 << data[0x08], "MB");
+			pr_attr_size("Maximum Total Memory Size",
+				     data[0x0E] * (1 << data[0x08]), "MB");
 			dmi_memory_controller_speeds("Supported Speeds",
 						     WORD(data + 0x09));
 			dmi_memory_module_types("Supported Memory Types",
@@ -4663,7 +4900,7 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 6: /* 7.7 Memory Module Information */
 			pr_handle_name("Memory Module Information");
 			if (h->length < 0x0C) break;
-			pr_attr("Socket Designation", "%s",
+			pr_attr_str("Socket Designation",
 				dmi_string(h, data[0x04]));
 			dmi_memory_module_connections(data[0x05]);
 			dmi_memory_module_speed("Current Speed", data[0x06]);
@@ -4676,15 +4913,15 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 7: /* 7.8 Cache Information */
 			pr_handle_name("Cache Information");
 			if (h->length < 0x0F) break;
-			pr_attr("Socket Designation", "%s",
+			pr_attr_str("Socket Designation",
 				dmi_string(h, data[0x04]));
 			pr_attr("Configuration", "%s, %s, Level %u",
 				WORD(data + 0x05) & 0x0080 ? "Enabled" : "Disabled",
 				WORD(data + 0x05) & 0x0008 ? "Socketed" : "Not Socketed",
 				(WORD(data + 0x05) & 0x0007) + 1);
-			pr_attr("Operational Mode", "%s",
+			pr_attr_str("Operational Mode",
 				dmi_cache_mode((WORD(data + 0x05) >> 8) & 0x0003));
-			pr_attr("Location", "%s",
+			pr_attr_str("Location",
 				dmi_cache_location((WORD(data + 0x05) >> 5) & 0x0003));
 			if (h->length >= 0x1B)
 				dmi_cache_size_2("Installed Size", DWORD(data + 0x17));
@@ -4698,39 +4935,39 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			dmi_cache_types("Installed SRAM Type", WORD(data + 0x0D), 1);
 			if (h->length < 0x13) break;
 			dmi_memory_module_speed("Speed", data[0x0F]);
-			pr_attr("Error Correction Type", "%s",
+			pr_attr_str("Error Correction Type",
 				dmi_cache_ec_type(data[0x10]));
-			pr_attr("System Type", "%s",
+			pr_attr_str("System Type",
 				dmi_cache_type(data[0x11]));
-			pr_attr("Associativity", "%s",
+			pr_attr_str("Associativity",
 				dmi_cache_associativity(data[0x12]));
 			break;
 
 		case 8: /* 7.9 Port Connector Information */
 			pr_handle_name("Port Connector Information");
 			if (h->length < 0x09) break;
-			pr_attr("Internal Reference Designator", "%s",
+			pr_attr_str("Internal Reference Designator",
 				dmi_string(h, data[0x04]));
-			pr_attr("Internal Connector Type", "%s",
+			pr_attr_str("Internal Connector Type",
 				dmi_port_connector_type(data[0x05]));
-			pr_attr("External Reference Designator", "%s",
+			pr_attr_str("External Reference Designator",
 				dmi_string(h, data[0x06]));
-			pr_attr("External Connector Type", "%s",
+			pr_attr_str("External Connector Type",
 				dmi_port_connector_type(data[0x07]));
-			pr_attr("Port Type", "%s",
+			pr_attr_str("Port Type",
 				dmi_port_type(data[0x08]));
 			break;
 
 		case 9: /* 7.10 System Slots */
 			pr_handle_name("System Slot Information");
 			if (h->length < 0x0C) break;
-			pr_attr("Designation", "%s",
+			pr_attr_str("Designation",
 				dmi_string(h, data[0x04]));
-			pr_attr("Type", "%s", dmi_slot_type(data[0x05]));
-			pr_attr("Data Bus Width", "%s", dmi_slot_bus_width(data[0x06]));
-			pr_attr("Current Usage", "%s",
+			pr_attr_str("Type", dmi_slot_type(data[0x05]));
+			pr_attr_str("Data Bus Width", dmi_slot_bus_width(data[0x06]));
+			pr_attr_str("Current Usage",
 				dmi_slot_current_usage(data[0x07]));
-			pr_attr("Length", "%s",
+			pr_attr_str("Length",
 				dmi_slot_length(data[0x08]));
 			dmi_slot_id(data[0x09], data[0x0A], data[0x05]);
 			if (h->length < 0x0D)
@@ -4740,8 +4977,8 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			if (h->length < 0x11) break;
 			dmi_slot_segment_bus_func(WORD(data + 0x0D), data[0x0F], data[0x10]);
 			if (h->length < 0x13) break;
-			pr_attr("Data Bus Width (Base)", "%u", data[0x11]);
-			pr_attr("Peer Devices", "%u", data[0x12]);
+			pr_attr_u32("Data Bus Width (Base)", data[0x11]);
+			pr_attr_u32("Peer Devices", data[0x12]);
 			if (h->length < 0x13 + data[0x12] * 5) break;
 			dmi_slot_peers(data[0x12], data + 0x13);
 			if (h->length < 0x17 + data[0x12] * 5) break;
@@ -4749,7 +4986,7 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			dmi_slot_physical_width(data[0x14 + data[0x12] * 5]);
 			dmi_slot_pitch(WORD(data + 0x15 + data[0x12] * 5));
 			if (h->length < 0x18 + data[0x12] * 5) break;
-			pr_attr("Height", "%s",
+			pr_attr_str("Height",
 				dmi_slot_height(data[0x17 + data[0x12] * 5]));
 			break;
 
@@ -4774,20 +5011,20 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			if (h->length < 0x16) break;
 			if (ver >= 0x0201)
 			{
-				pr_attr("Language Description Format", "%s",
+				pr_attr_str("Language Description Format",
 					dmi_bios_language_format(data[0x05]));
 			}
 			pr_list_start("Installable Languages", "%u", data[0x04]);
 			dmi_bios_languages(h);
 			pr_list_end();
-			pr_attr("Currently Installed Language", "%s",
+			pr_attr_str("Currently Installed Language",
 				dmi_string(h, data[0x15]));
 			break;
 
 		case 14: /* 7.15 Group Associations */
 			pr_handle_name("Group Associations");
 			if (h->length < 0x05) break;
-			pr_attr("Name", "%s",
+			pr_attr_str("Name",
 				dmi_string(h, data[0x04]));
 			pr_list_start("Items", "%u",
 				(h->length - 0x05) / 3);
@@ -4800,24 +5037,24 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			if (h->length < 0x14) break;
 			pr_attr("Area Length", "%u bytes",
 				WORD(data + 0x04));
-			pr_attr("Header Start Offset", "0x%04X",
+			pr_attr_hex16("Header Start Offset",
 				WORD(data + 0x06));
 			if (WORD(data + 0x08) - WORD(data + 0x06))
 				pr_attr("Header Length", "%u byte%s",
 					WORD(data + 0x08) - WORD(data + 0x06),
 					WORD(data + 0x08) - WORD(data + 0x06) > 1 ? "s" : "");
-			pr_attr("Data Start Offset", "0x%04X",
+			pr_attr_hex16("Data Start Offset",
 				WORD(data + 0x08));
-			pr_attr("Access Method", "%s",
+			pr_attr_str("Access Method",
 				dmi_event_log_method(data[0x0A]));
 			dmi_event_log_address(data[0x0A], data + 0x10);
 			dmi_event_log_status(data[0x0B]);
-			pr_attr("Change Token", "0x%08X",
+			pr_attr_hex32("Change Token",
 				DWORD(data + 0x0C));
 			if (h->length < 0x17) break;
-			pr_attr("Header Format", "%s",
+			pr_attr_str("Header Format",
 				dmi_event_log_header_type(data[0x14]));
-			pr_attr("Supported Log Type Descriptors", "%u",
+			pr_attr_u32("Supported Log Type Descriptors",
 				data[0x15]);
 			if (h->length < 0x17 + data[0x15] * data[0x16]) break;
 			dmi_event_log_descriptors(data[0x15], data[0x16], data + 0x17);
@@ -4826,16 +5063,16 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 16: /* 7.17 Physical Memory Array */
 			pr_handle_name("Physical Memory Array");
 			if (h->length < 0x0F) break;
-			pr_attr("Location", "%s",
+			pr_attr_str("Location",
 				dmi_memory_array_location(data[0x04]));
-			pr_attr("Use", "%s",
+			pr_attr_str("Use",
 				dmi_memory_array_use(data[0x05]));
-			pr_attr("Error Correction Type", "%s",
+			pr_attr_str("Error Correction Type",
 				dmi_memory_array_ec_type(data[0x06]));
 			if (DWORD(data + 0x07) == 0x80000000)
 			{
 				if (h->length < 0x17)
-					pr_attr("Maximum Capacity", "Unknown");
+					pr_attr_str("Maximum Capacity", "Unknown");
 				else
 					dmi_print_memory_size("Maximum Capacity",
 							      QWORD(data + 0x0F), 0);
@@ -4851,7 +5088,7 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			}
 			if (!(opt.flags & FLAG_QUIET))
 				dmi_memory_array_error_handle(WORD(data + 0x0B));
-			pr_attr("Number Of Devices", "%u",
+			pr_attr_u32("Number Of Devices",
 				WORD(data + 0x0D));
 			break;
 
@@ -4860,87 +5097,114 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			if (h->length < 0x15) break;
 			if (!(opt.flags & FLAG_QUIET))
 			{
-				pr_attr("Array Handle", "0x%04X",
-					WORD(data + 0x04));
-				dmi_memory_array_error_handle(WORD(data + 0x06));
+				if (pr_wanted("Array Handle"))
+					pr_attr("Array Handle", "0x%04X%s",
+						WORD(data + 0x04),
+						dmi_handle_ref(WORD(data + 0x04)));
+				if (pr_wanted("Error Information Handle"))
+					dmi_memory_array_error_handle(WORD(data + 0x06));
 			}
-			dmi_memory_device_width("Total Width", WORD(data + 0x08));
-			dmi_memory_device_width("Data Width", WORD(data + 0x0A));
-			if (h->length >= 0x20 && WORD(data + 0x0C) == 0x7FFF)
-				dmi_memory_device_extended_size(DWORD(data + 0x1C));
-			else
-				dmi_memory_device_size(WORD(data + 0x0C));
-			pr_attr("Form Factor", "%s",
+			if (pr_wanted("Total Width"))
+				dmi_memory_device_width("Total Width", WORD(data + 0x08));
+			if (pr_wanted("Data Width"))
+				dmi_memory_device_width("Data Width", WORD(data + 0x0A));
+			if (pr_wanted("Size"))
+			{
+				if (h->length >= 0x20 && WORD(data + 0x0C) == 0x7FFF)
+					dmi_memory_device_extended_size(DWORD(data + 0x1C));
+				else
+					dmi_memory_device_size(WORD(data + 0x0C));
+			}
+			pr_attr_str("Form Factor",
 				dmi_memory_device_form_factor(data[0x0E]));
-			dmi_memory_device_set(data[0x0F]);
-			pr_attr("Locator", "%s",
+			if (pr_wanted("Set"))
+				dmi_memory_device_set(data[0x0F]);
+			pr_attr_str("Locator",
 				dmi_string(h, data[0x10]));
-			pr_attr("Bank Locator", "%s",
+			pr_attr_str("Bank Locator",
 				dmi_string(h, data[0x11]));
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_memory_device_type(data[0x12]));
-			dmi_memory_device_type_detail(WORD(data + 0x13));
+			if (pr_wanted("Type Detail"))
+				dmi_memory_device_type_detail(WORD(data + 0x13));
 			if (h->length < 0x17) break;
 			/* If no module is present, the remaining fields are irrelevant */
 			if (WORD(data + 0x0C) == 0 && !(opt.flags & FLAG_NO_QUIRKS))
 				break;
-			dmi_memory_device_speed("Speed", WORD(data + 0x15),
-						h->length >= 0x5C ?
-						DWORD(data + 0x54) : 0);
+			if (pr_wanted("Speed"))
+				dmi_memory_device_speed("Speed", WORD(data + 0x15),
+							h->length >= 0x5C ?
+							DWORD(data + 0x54) : 0);
 			if (h->length < 0x1B) break;
-			pr_attr("Manufacturer", "%s",
+			pr_attr_str("Manufacturer",
 				dmi_string(h, data[0x17]));
-			pr_attr("Serial Number", "%s",
+			pr_attr_str("Serial Number",
 				dmi_string(h, data[0x18]));
-			pr_attr("Asset Tag", "%s",
+			pr_attr_str("Asset Tag",
 				dmi_string(h, data[0x19]));
-			pr_attr("Part Number", "%s",
+			pr_attr_str("Part Number",
 				dmi_string(h, data[0x1A]));
 			if (h->length < 0x1C) break;
 			if ((data[0x1B] & 0x0F) == 0)
-				pr_attr("Rank", "Unknown");
+				pr_attr_str("Rank", "Unknown");
 			else
-				pr_attr("Rank", "%u", data[0x1B] & 0x0F);
+				pr_attr_u32("Rank", data[0x1B] & 0x0F);
 			if (h->length < 0x22) break;
-			dmi_memory_device_speed("Configured Memory Speed",
-						WORD(data + 0x20),
-						h->length >= 0x5C ?
-						DWORD(data + 0x58) : 0);
+			if (pr_wanted("Configured Memory Speed"))
+				dmi_memory_device_speed("Configured Memory Speed",
+							WORD(data + 0x20),
+							h->length >= 0x5C ?
+							DWORD(data + 0x58) : 0);
 			if (h->length < 0x28) break;
-			dmi_memory_voltage_value("Minimum Voltage",
-						 WORD(data + 0x22));
-			dmi_memory_voltage_value("Maximum Voltage",
-						 WORD(data + 0x24));
-			dmi_memory_voltage_value("Configured Voltage",
-						 WORD(data + 0x26));
+			if (pr_wanted("Minimum Voltage"))
+				dmi_memory_voltage_value("Minimum Voltage",
+							 WORD(data + 0x22));
+			if (pr_wanted("Maximum Voltage"))
+				dmi_memory_voltage_value("Maximum Voltage",
+							 WORD(data + 0x24));
+			if (pr_wanted("Configured Voltage"))
+				dmi_memory_voltage_value("Configured Voltage",
+							 WORD(data + 0x26));
 			if (h->length < 0x34) break;
-			dmi_memory_technology(data[0x28]);
-			dmi_memory_operating_mode_capability(WORD(data + 0x29));
-			pr_attr("Firmware Version", "%s",
+			if (pr_wanted("Memory Technology"))
+				dmi_memory_technology(data[0x28]);
+			if (pr_wanted("Memory Operating Mode Capability"))
+				dmi_memory_operating_mode_capability(WORD(data + 0x29));
+			pr_attr_str("Firmware Version",
 				dmi_string(h, data[0x2B]));
-			dmi_memory_manufacturer_id("Module Manufacturer ID",
-						   WORD(data + 0x2C));
-			dmi_memory_product_id("Module Product ID",
-					      WORD(data + 0x2E));
-			dmi_memory_manufacturer_id("Memory Subsystem Controller Manufacturer ID",
-						   WORD(data + 0x30));
-			dmi_memory_product_id("Memory Subsystem Controller Product ID",
-					      WORD(data + 0x32));
+			if (pr_wanted("Module Manufacturer ID"))
+				dmi_memory_manufacturer_id("Module Manufacturer ID",
+							   WORD(data + 0x2C));
+			if (pr_wanted("Module Product ID"))
+				dmi_memory_product_id("Module Product ID",
+						      WORD(data + 0x2E));
+			if (pr_wanted("Memory Subsystem Controller Manufacturer ID"))
+				dmi_memory_manufacturer_id("Memory Subsystem Controller Manufacturer ID",
+							   WORD(data + 0x30));
+			if (pr_wanted("Memory Subsystem Controller Product ID"))
+				dmi_memory_product_id("Memory Subsystem Controller Product ID",
+						      WORD(data + 0x32));
 			if (h->length < 0x3C) break;
-			dmi_memory_size("Non-Volatile Size", QWORD(data + 0x34));
+			if (pr_wanted("Non-Volatile Size"))
+				dmi_memory_size("Non-Volatile Size", QWORD(data + 0x34));
 			if (h->length < 0x44) break;
-			dmi_memory_size("Volatile Size", QWORD(data + 0x3C));
+			if (pr_wanted("Volatile Size"))
+				dmi_memory_size("Volatile Size", QWORD(data + 0x3C));
 			if (h->length < 0x4C) break;
-			dmi_memory_size("Cache Size", QWORD(data + 0x44));
+			if (pr_wanted("Cache Size"))
+				dmi_memory_size("Cache Size", QWORD(data + 0x44));
 			if (h->length < 0x54) break;
-			dmi_memory_size("Logical Size", QWORD(data + 0x4C));
+			if (pr_wanted("Logical Size"))
+				dmi_memory_size("Logical Size", QWORD(data + 0x4C));
 			if (h->length < 0x64) break;
-			dmi_memory_manufacturer_id("PMIC0 Manufacturer ID",
-						   WORD(data + 0x5C));
+			if (pr_wanted("PMIC0 Manufacturer ID"))
+				dmi_memory_manufacturer_id("PMIC0 Manufacturer ID",
+							   WORD(data + 0x5C));
 			dmi_memory_revision("PMIC0", WORD(data + 0x5E),
 					    data[0x12]);
-			dmi_memory_manufacturer_id("RCD Manufacturer ID",
-						   WORD(data + 0x60));
+			if (pr_wanted("RCD Manufacturer ID"))
+				dmi_memory_manufacturer_id("RCD Manufacturer ID",
+							   WORD(data + 0x60));
 			dmi_memory_revision("RCD", WORD(data + 0x62),
 					    data[0x12]);
 			break;
@@ -4948,11 +5212,11 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 18: /* 7.19 32-bit Memory Error Information */
 			pr_handle_name("32-bit Memory Error Information");
 			if (h->length < 0x17) break;
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_memory_error_type(data[0x04]));
-			pr_attr("Granularity", "%s",
+			pr_attr_str("Granularity",
 				dmi_memory_error_granularity(data[0x05]));
-			pr_attr("Operation", "%s",
+			pr_attr_str("Operation",
 				dmi_memory_error_operation(data[0x06]));
 			dmi_memory_error_syndrome(DWORD(data + 0x07));
 			dmi_32bit_memory_error_address("Memory Array Address",
@@ -4977,7 +5241,8 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 					start.h, start.l);
 				pr_attr("Ending Address", "0x%08X%08Xk",
 					end.h, end.l);
-				dmi_mapped_address_extended_size(start, end);
+				if (pr_wanted("Range Size"))
+					dmi_mapped_address_extended_size(start, end);
 			}
 			else
 			{
@@ -4987,12 +5252,15 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 				pr_attr("Ending Address", "0x%08X%03X",
 					DWORD(data + 0x08) >> 2,
 					((DWORD(data + 0x08) & 0x3) << 10) + 0x3FF);
-				dmi_mapped_address_size(DWORD(data + 0x08) - DWORD(data + 0x04) + 1);
+				if (pr_wanted("Range Size"))
+					dmi_mapped_address_size(DWORD(data + 0x08) - DWORD(data + 0x04) + 1);
 			}
-			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Physical Array Handle", "0x%04X",
-					WORD(data + 0x0C));
-			pr_attr("Partition Width", "%u",
+			if (!(opt.flags & FLAG_QUIET)
+			 && pr_wanted("Physical Array Handle"))
+				pr_attr("Physical Array Handle", "0x%04X%s",
+					WORD(data + 0x0C),
+					dmi_handle_ref(WORD(data + 0x0C)));
+			pr_attr_u32("Partition Width",
 				data[0x0E]);
 			break;
 
@@ -5010,7 +5278,8 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 					start.h, start.l);
 				pr_attr("Ending Address", "0x%08X%08Xk",
 					end.h, end.l);
-				dmi_mapped_address_extended_size(start, end);
+				if (pr_wanted("Range Size"))
+					dmi_mapped_address_extended_size(start, end);
 			}
 			else
 			{
@@ -5020,55 +5289,63 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 				pr_attr("Ending Address", "0x%08X%03X",
 					DWORD(data + 0x08) >> 2,
 					((DWORD(data + 0x08) & 0x3) << 10) + 0x3FF);
-				dmi_mapped_address_size(DWORD(data + 0x08) - DWORD(data + 0x04) + 1);
+				if (pr_wanted("Range Size"))
+					dmi_mapped_address_size(DWORD(data + 0x08) - DWORD(data + 0x04) + 1);
 			}
 			if (!(opt.flags & FLAG_QUIET))
 			{
-				pr_attr("Physical Device Handle", "0x%04X",
-					WORD(data + 0x0C));
-				pr_attr("Memory Array Mapped Address Handle", "0x%04X",
-					WORD(data + 0x0E));
+				if (pr_wanted("Physical Device Handle"))
+					pr_attr("Physical Device Handle", "0x%04X%s",
+						WORD(data + 0x0C),
+						dmi_handle_ref(WORD(data + 0x0C)));
+				if (pr_wanted("Memory Array Mapped Address Handle"))
+					pr_attr("Memory Array Mapped Address Handle", "0x%04X%s",
+						WORD(data + 0x0E),
+						dmi_handle_ref(WORD(data + 0x0E)));
 			}
-			dmi_mapped_address_row_position(data[0x10]);
-			dmi_mapped_address_interleave_position(data[0x11]);
-			dmi_mapped_address_interleaved_data_depth(data[0x12]);
+			if (pr_wanted("Partition Row Position"))
+				dmi_mapped_address_row_position(data[0x10]);
+			if (pr_wanted("Interleave Position"))
+				dmi_mapped_address_interleave_position(data[0x11]);
+			if (pr_wanted("Interleaved Data Depth"))
+				dmi_mapped_address_interleaved_data_depth(data[0x12]);
 			break;
 
 		case 21: /* 7.22 Built-in Pointing Device */
 			pr_handle_name("Built-in Pointing Device");
 			if (h->length < 0x07) break;
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_pointing_device_type(data[0x04]));
-			pr_attr("Interface", "%s",
+			pr_attr_str("Interface",
 				dmi_pointing_device_interface(data[0x05]));
-			pr_attr("Buttons", "%u",
+			pr_attr_u32("Buttons",
 				data[0x06]);
 			break;
 
 		case 22: /* 7.23 Portable Battery */
 			pr_handle_name("Portable Battery");
 			if (h->length < 0x10) break;
-			pr_attr("Location", "%s",
+			pr_attr_str("Location",
 				dmi_string(h, data[0x04]));
-			pr_attr("Manufacturer", "%s",
+			pr_attr_str("Manufacturer",
 				dmi_string(h, data[0x05]));
 			if (data[0x06] || h->length < 0x1A)
-				pr_attr("Manufacture Date", "%s",
+				pr_attr_str("Manufacture Date",
 					dmi_string(h, data[0x06]));
 			if (data[0x07] || h->length < 0x1A)
-				pr_attr("Serial Number", "%s",
+				pr_attr_str("Serial Number",
 					dmi_string(h, data[0x07]));
-			pr_attr("Name", "%s",
+			pr_attr_str("Name",
 				dmi_string(h, data[0x08]));
 			if (data[0x09] != 0x02 || h->length < 0x1A)
-				pr_attr("Chemistry", "%s",
+				pr_attr_str("Chemistry",
 					dmi_battery_chemistry(data[0x09]));
 			if (h->length < 0x16)
 				dmi_battery_capacity(WORD(data + 0x0A), 1);
 			else
 				dmi_battery_capacity(WORD(data + 0x0A), data[0x15]);
 			dmi_battery_voltage(WORD(data + 0x0C));
-			pr_attr("SBDS Version", "%s",
+			pr_attr_str("SBDS Version",
 				dmi_string(h, data[0x0E]));
 			dmi_battery_maximum_error(data[0x0F]);
 			if (h->length < 0x1A) break;
@@ -5081,24 +5358,24 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 					(WORD(data + 0x12) >> 5) & 0x0F,
 					WORD(data + 0x12) & 0x1F);
 			if (data[0x09] == 0x02)
-				pr_attr("SBDS Chemistry", "%s",
+				pr_attr_str("SBDS Chemistry",
 					dmi_string(h, data[0x14]));
-			pr_attr("OEM-specific Information", "0x%08X",
+			pr_attr_hex32("OEM-specific Information",
 				DWORD(data + 0x16));
 			break;
 
 		case 23: /* 7.24 System Reset */
 			pr_handle_name("System Reset");
 			if (h->length < 0x0D) break;
-			pr_attr("Status", "%s",
+			pr_attr_str("Status",
 				data[0x04] & (1 << 0) ? "Enabled" : "Disabled");
-			pr_attr("Watchdog Timer", "%s",
+			pr_attr_str("Watchdog Timer",
 				data[0x04] & (1 << 5) ? "Present" : "Not Present");
 			if (!(data[0x04] & (1 << 5)))
 				break;
-			pr_attr("Boot Option", "%s",
+			pr_attr_str("Boot Option",
 				dmi_system_reset_boot_option((data[0x04] >> 1) & 0x3));
-			pr_attr("Boot Option On Limit", "%s",
+			pr_attr_str("Boot Option On Limit",
 				dmi_system_reset_boot_option((data[0x04] >> 3) & 0x3));
 			dmi_system_reset_count("Reset Count", WORD(data + 0x05));
 			dmi_system_reset_count("Reset Limit", WORD(data + 0x07));
@@ -5109,13 +5386,13 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 24: /* 7.25 Hardware Security */
 			pr_handle_name("Hardware Security");
 			if (h->length < 0x05) break;
-			pr_attr("Power-On Password Status", "%s",
+			pr_attr_str("Power-On Password Status",
 				dmi_hardware_security_status(data[0x04] >> 6));
-			pr_attr("Keyboard Password Status", "%s",
+			pr_attr_str("Keyboard Password Status",
 				dmi_hardware_security_status((data[0x04] >> 4) & 0x3));
-			pr_attr("Administrator Password Status", "%s",
+			pr_attr_str("Administrator Password Status",
 				dmi_hardware_security_status((data[0x04] >> 2) & 0x3));
-			pr_attr("Front Panel Reset Status", "%s",
+			pr_attr_str("Front Panel Reset Status",
 				dmi_hardware_security_status(data[0x04] & 0x3));
 			break;
 
@@ -5128,18 +5405,18 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 26: /* 7.27 Voltage Probe */
 			pr_handle_name("Voltage Probe");
 			if (h->length < 0x14) break;
-			pr_attr("Description", "%s",
+			pr_attr_str("Description",
 				dmi_string(h, data[0x04]));
-			pr_attr("Location", "%s",
+			pr_attr_str("Location",
 				dmi_voltage_probe_location(data[0x05] & 0x1f));
-			pr_attr("Status", "%s",
+			pr_attr_str("Status",
 				dmi_probe_status(data[0x05] >> 5));
 			dmi_voltage_probe_value("Maximum Value", WORD(data + 0x06));
 			dmi_voltage_probe_value("Minimum Value", WORD(data + 0x08));
 			dmi_voltage_probe_resolution(WORD(data + 0x0A));
 			dmi_voltage_probe_value("Tolerance", WORD(data + 0x0C));
 			dmi_probe_accuracy(WORD(data + 0x0E));
-			pr_attr("OEM-specific Information", "0x%08X",
+			pr_attr_hex32("OEM-specific Information",
 				DWORD(data + 0x10));
 			if (h->length < 0x16) break;
 			dmi_voltage_probe_value("Nominal Value", WORD(data + 0x14));
@@ -5149,31 +5426,32 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			pr_handle_name("Cooling Device");
 			if (h->length < 0x0C) break;
 			if (!(opt.flags & FLAG_QUIET) && WORD(data + 0x04) != 0xFFFF)
-				pr_attr("Temperature Probe Handle", "0x%04X",
-					WORD(data + 0x04));
-			pr_attr("Type", "%s",
+				pr_attr("Temperature Probe Handle", "0x%04X%s",
+					WORD(data + 0x04),
+					dmi_handle_ref(WORD(data + 0x04)));
+			pr_attr_str("Type",
 				dmi_cooling_device_type(data[0x06] & 0x1f));
-			pr_attr("Status", "%s",
+			pr_attr_str("Status",
 				dmi_probe_status(data[0x06] >> 5));
 			if (data[0x07] != 0x00)
-				pr_attr("Cooling Unit Group", "%u",
+				pr_attr_u32("Cooling Unit Group",
 					data[0x07]);
-			pr_attr("OEM-specific Information", "0x%08X",
+			pr_attr_hex32("OEM-specific Information",
 				DWORD(data + 0x08));
 			if (h->length < 0x0E) break;
 			dmi_cooling_device_speed(WORD(data + 0x0C));
 			if (h->length < 0x0F) break;
-			pr_attr("Description", "%s", dmi_string(h, data[0x0E]));
+			pr_attr_str("Description", dmi_string(h, data[0x0E]));
 			break;
 
 		case 28: /* 7.29 Temperature Probe */
 			pr_handle_name("Temperature Probe");
 			if (h->length < 0x14) break;
-			pr_attr("Description", "%s",
+			pr_attr_str("Description",
 				dmi_string(h, data[0x04]));
-			pr_attr("Location", "%s",
+			pr_attr_str("Location",
 				dmi_temperature_probe_location(data[0x05] & 0x1F));
-			pr_attr("Status", "%s",
+			pr_attr_str("Status",
 				dmi_probe_status(data[0x05] >> 5));
 			dmi_temperature_probe_value("Maximum Value",
 						    WORD(data + 0x06));
@@ -5183,7 +5461,7 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			dmi_temperature_probe_value("Tolerance",
 						    WORD(data + 0x0C));
 			dmi_probe_accuracy(WORD(data + 0x0E));
-			pr_attr("OEM-specific Information", "0x%08X",
+			pr_attr_hex32("OEM-specific Information",
 				DWORD(data + 0x10));
 			if (h->length < 0x16) break;
 			dmi_temperature_probe_value("Nominal Value",
@@ -5193,11 +5471,11 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 29: /* 7.30 Electrical Current Probe */
 			pr_handle_name("Electrical Current Probe");
 			if (h->length < 0x14) break;
-			pr_attr("Description", "%s",
+			pr_attr_str("Description",
 				dmi_string(h, data[0x04]));
-			pr_attr("Location", "%s",
+			pr_attr_str("Location",
 				dmi_voltage_probe_location(data[5] & 0x1F));
-			pr_attr("Status", "%s",
+			pr_attr_str("Status",
 				dmi_probe_status(data[0x05] >> 5));
 			dmi_current_probe_value("Maximum Value",
 						WORD(data + 0x06));
@@ -5207,7 +5485,7 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			dmi_current_probe_value("Tolerance",
 						WORD(data + 0x0C));
 			dmi_probe_accuracy(WORD(data + 0x0E));
-			pr_attr("OEM-specific Information", "0x%08X",
+			pr_attr_hex32("OEM-specific Information",
 				DWORD(data + 0x10));
 			if (h->length < 0x16) break;
 			dmi_current_probe_value("Nominal Value",
@@ -5217,41 +5495,41 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 30: /* 7.31 Out-of-band Remote Access */
 			pr_handle_name("Out-of-band Remote Access");
 			if (h->length < 0x06) break;
-			pr_attr("Manufacturer Name", "%s",
+			pr_attr_str("Manufacturer Name",
 				dmi_string(h, data[0x04]));
-			pr_attr("Inbound Connection", "%s",
+			pr_attr_str("Inbound Connection",
 				data[0x05] & (1 << 0) ? "Enabled" : "Disabled");
-			pr_attr("Outbound Connection", "%s",
+			pr_attr_str("Outbound Connection",
 				data[0x05] & (1 << 1) ? "Enabled" : "Disabled");
 			break;
 
 		case 31: /* 7.32 Boot Integrity Services Entry Point */
 			pr_handle_name("Boot Integrity Services Entry Point");
 			if (h->length < 0x1C) break;
-			pr_attr("Checksum", "%s",
+			pr_attr_str("Checksum",
 				checksum(data, h->length) ? "OK" : "Invalid");
 			pr_attr("16-bit Entry Point Address", "%04X:%04X",
 				DWORD(data + 0x08) >> 16,
 				DWORD(data + 0x08) & 0xFFFF);
-			pr_attr("32-bit Entry Point Address", "0x%08X",
+			pr_attr_hex32("32-bit Entry Point Address",
 				DWORD(data + 0x0C));
 			break;
 
 		case 32: /* 7.33 System Boot Information */
 			pr_handle_name("System Boot Information");
 			if (h->length < 0x0B) break;
-			pr_attr("Status", "%s",
+			pr_attr_str("Status",
 				dmi_system_boot_status(data[0x0A]));
 			break;
 
 		case 33: /* 7.34 64-bit Memory Error Information */
 			pr_handle_name("64-bit Memory Error Information");
 			if (h->length < 0x1F) break;
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_memory_error_type(data[0x04]));
-			pr_attr("Granularity", "%s",
+			pr_attr_str("Granularity",
 				dmi_memory_error_granularity(data[0x05]));
-			pr_attr("Operation", "%s",
+			pr_attr_str("Operation",
 				dmi_memory_error_operation(data[0x06]));
 			dmi_memory_error_syndrome(DWORD(data + 0x07));
 			dmi_64bit_memory_error_address("Memory Array Address",
@@ -5265,30 +5543,33 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 34: /* 7.35 Management Device */
 			pr_handle_name("Management Device");
 			if (h->length < 0x0B) break;
-			pr_attr("Description", "%s",
+			pr_attr_str("Description",
 				dmi_string(h, data[0x04]));
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_management_device_type(data[0x05]));
-			pr_attr("Address", "0x%08X",
+			pr_attr_hex32("Address",
 				DWORD(data + 0x06));
-			pr_attr("Address Type", "%s",
+			pr_attr_str("Address Type",
 				dmi_management_device_address_type(data[0x0A]));
 			break;
 
 		case 35: /* 7.36 Management Device Component */
 			pr_handle_name("Management Device Component");
 			if (h->length < 0x0B) break;
-			pr_attr("Description", "%s",
+			pr_attr_str("Description",
 				dmi_string(h, data[0x04]));
 			if (!(opt.flags & FLAG_QUIET))
 			{
-				pr_attr("Management Device Handle", "0x%04X",
-					WORD(data + 0x05));
-				pr_attr("Component Handle", "0x%04X",
-					WORD(data + 0x07));
+				pr_attr("Management Device Handle", "0x%04X%s",
+					WORD(data + 0x05),
+					dmi_handle_ref(WORD(data + 0x05)));
+				pr_attr("Component Handle", "0x%04X%s",
+					WORD(data + 0x07),
+					dmi_handle_ref(WORD(data + 0x07)));
 				if (WORD(data + 0x09) != 0xFFFF)
-					pr_attr("Threshold Handle", "0x%04X",
-						WORD(data + 0x09));
+					pr_attr("Threshold Handle", "0x%04X%s",
+						WORD(data + 0x09),
+						dmi_handle_ref(WORD(data + 0x09)));
 			}
 			break;
 
@@ -5318,11 +5599,11 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 37: /* 7.38 Memory Channel */
 			pr_handle_name("Memory Channel");
 			if (h->length < 0x07) break;
-			pr_attr("Type", "%s",
+			pr_attr_str("Type",
 				dmi_memory_channel_type(data[0x04]));
-			pr_attr("Maximal Load", "%u",
+			pr_attr_u32("Maximal Load",
 				data[0x05]);
-			pr_attr("Devices", "%u",
+			pr_attr_u32("Devices",
 				data[0x06]);
 			if (h->length < 0x07 + 3 * data[0x06]) break;
 			dmi_memory_channel_devices(data[0x06], data + 0x07);
@@ -5335,35 +5616,35 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			 */
 			pr_handle_name("IPMI Device Information");
 			if (h->length < 0x10) break;
-			pr_attr("Interface Type", "%s",
+			pr_attr_str("Interface Type",
 				dmi_ipmi_interface_type(data[0x04]));
 			pr_attr("Specification Version", "%u.%u",
 				data[0x05] >> 4, data[0x05] & 0x0F);
 			pr_attr("I2C Slave Address", "0x%02x",
 				data[0x06] >> 1);
 			if (data[0x07] != 0xFF)
-				pr_attr("NV Storage Device Address", "%u",
+				pr_attr_u32("NV Storage Device Address",
 					data[0x07]);
 			else
-				pr_attr("NV Storage Device", "Not Present");
+				pr_attr_str("NV Storage Device", "Not Present");
 			dmi_ipmi_base_address(data[0x04], data + 0x08,
 				h->length < 0x11 ? 0 : (data[0x10] >> 4) & 1);
 			if (h->length < 0x12) break;
 			if (data[0x04] != 0x04)
 			{
-				pr_attr("Register Spacing", "%s",
+				pr_attr_str("Register Spacing",
 					dmi_ipmi_register_spacing(data[0x10] >> 6));
 				if (data[0x10] & (1 << 3))
 				{
-					pr_attr("Interrupt Polarity", "%s",
+					pr_attr_str("Interrupt Polarity",
 						data[0x10] & (1 << 1) ? "Active High" : "Active Low");
-					pr_attr("Interrupt Trigger Mode", "%s",
+					pr_attr_str("Interrupt Trigger Mode",
 						data[0x10] & (1 << 0) ? "Level" : "Edge");
 				}
 			}
 			if (data[0x11] != 0x00)
 			{
-				pr_attr("Interrupt Number", "%u",
+				pr_attr_u32("Interrupt Number",
 					data[0x11]);
 			}
 			break;
@@ -5372,48 +5653,51 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			pr_handle_name("System Power Supply");
 			if (h->length < 0x10) break;
 			if (data[0x04] != 0x00)
-				pr_attr("Power Unit Group", "%u",
+				pr_attr_u32("Power Unit Group",
 					data[0x04]);
-			pr_attr("Location", "%s",
+			pr_attr_str("Location",
 				dmi_string(h, data[0x05]));
-			pr_attr("Name", "%s",
+			pr_attr_str("Name",
 				dmi_string(h, data[0x06]));
-			pr_attr("Manufacturer", "%s",
+			pr_attr_str("Manufacturer",
 				dmi_string(h, data[0x07]));
-			pr_attr("Serial Number", "%s",
+			pr_attr_str("Serial Number",
 				dmi_string(h, data[0x08]));
-			pr_attr("Asset Tag", "%s",
+			pr_attr_str("Asset Tag",
 				dmi_string(h, data[0x09]));
-			pr_attr("Model Part Number", "%s",
+			pr_attr_str("Model Part Number",
 				dmi_string(h, data[0x0A]));
-			pr_attr("Revision", "%s",
+			pr_attr_str("Revision",
 				dmi_string(h, data[0x0B]));
 			dmi_power_supply_power(WORD(data + 0x0C));
 			if (WORD(data + 0x0E) & (1 << 1))
 				pr_attr("Status", "Present, %s",
 					dmi_power_supply_status((WORD(data + 0x0E) >> 7) & 0x07));
 			else
-				pr_attr("Status", "Not Present");
-			pr_attr("Type", "%s",
+				pr_attr_str("Status", "Not Present");
+			pr_attr_str("Type",
 				dmi_power_supply_type((WORD(data + 0x0E) >> 10) & 0x0F));
-			pr_attr("Input Voltage Range Switching", "%s",
+			pr_attr_str("Input Voltage Range Switching",
 				dmi_power_supply_range_switching((WORD(data + 0x0E) >> 3) & 0x0F));
-			pr_attr("Plugged", "%s",
+			pr_attr_str("Plugged",
 				WORD(data + 0x0E) & (1 << 2) ? "No" : "Yes");
-			pr_attr("Hot Replaceable", "%s",
+			pr_attr_str("Hot Replaceable",
 				WORD(data + 0x0E) & (1 << 0) ? "Yes" : "No");
 			if (h->length < 0x16) break;
 			if (!(opt.flags & FLAG_QUIET))
 			{
 				if (WORD(data + 0x10) != 0xFFFF)
-					pr_attr("Input Voltage Probe Handle", "0x%04X",
-						WORD(data + 0x10));
+					pr_attr("Input Voltage Probe Handle", "0x%04X%s",
+						WORD(data + 0x10),
+						dmi_handle_ref(WORD(data + 0x10)));
 				if (WORD(data + 0x12) != 0xFFFF)
-					pr_attr("Cooling Device Handle", "0x%04X",
-						WORD(data + 0x12));
+					pr_attr("Cooling Device Handle", "0x%04X%s",
+						WORD(data + 0x12),
+						dmi_handle_ref(WORD(data + 0x12)));
 				if (WORD(data + 0x14) != 0xFFFF)
-					pr_attr("Input Current Probe Handle", "0x%04X",
-						WORD(data + 0x14));
+					pr_attr("Input Current Probe Handle", "0x%04X%s",
+						WORD(data + 0x14),
+						dmi_handle_ref(WORD(data + 0x14)));
 			}
 			break;
 
@@ -5427,12 +5711,12 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 		case 41: /* 7.42 Onboard Device Extended Information */
 			pr_handle_name("Onboard Device");
 			if (h->length < 0x0B) break;
-			pr_attr("Reference Designation", "%s", dmi_string(h, data[0x04]));
-			pr_attr("Type", "%s",
+			pr_attr_str("Reference Designation", dmi_string(h, data[0x04]));
+			pr_attr_str("Type",
 				dmi_on_board_devices_type(data[0x05] & 0x7F));
-			pr_attr("Status", "%s",
+			pr_attr_str("Status",
 				data[0x05] & 0x80 ? "Enabled" : "Disabled");
-			pr_attr("Type Instance", "%u", data[0x06]);
+			pr_attr_u32("Type Instance", data[0x06]);
 			dmi_slot_segment_bus_func(WORD(data + 0x07), data[0x09], data[0x0A]);
 			break;
 
@@ -5441,7 +5725,7 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 			if (ver < 0x0302)
 			{
 				if (h->length < 0x05) break;
-				pr_attr("Interface Type", "%s",
+				pr_attr_str("Interface Type",
 					dmi_management_controller_host_type(data[0x04]));
 				/*
 				 * There you have a type-dependent, variable-length
@@ -5488,32 +5772,32 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 					 */
 					break;
 			}
-			pr_attr("Description", "%s", dmi_string(h, data[0x12]));
+			pr_attr_str("Description", dmi_string(h, data[0x12]));
 			pr_list_start("Characteristics", NULL);
 			dmi_tpm_characteristics(QWORD(data + 0x13));
 			pr_list_end();
 			if (h->length < 0x1F) break;
-			pr_attr("OEM-specific Information", "0x%08X",
+			pr_attr_hex32("OEM-specific Information",
 				DWORD(data + 0x1B));
 			break;
 
 		case 45: /* 7.46 Firmware Inventory Information */
 			pr_handle_name("Firmware Inventory Information");
 			if (h->length < 0x18) break;
-			pr_attr("Firmware Component Name", "%s",
+			pr_attr_str("Firmware Component Name",
 				dmi_string(h, data[0x04]));
-			pr_attr("Firmware Version", "%s",
+			pr_attr_str("Firmware Version",
 				dmi_string(h, data[0x05]));
-			pr_attr("Firmware ID", "%s", dmi_string(h, data[0x07]));
-			pr_attr("Release Date", "%s", dmi_string(h, data[0x09]));
-			pr_attr("Manufacturer", "%s", dmi_string(h, data[0x0A]));
-			pr_attr("Lowest Supported Firmware Version", "%s",
+			pr_attr_str("Firmware ID", dmi_string(h, data[0x07]));
+			pr_attr_str("Release Date", dmi_string(h, data[0x09]));
+			pr_attr_str("Manufacturer", dmi_string(h, data[0x0A]));
+			pr_attr_str("Lowest Supported Firmware Version",
 				dmi_string(h, data[0x0B]));
 			dmi_memory_size("Image Size", QWORD(data + 0x0C));
 			pr_list_start("Characteristics", NULL);
 			dmi_firmware_characteristics(WORD(data + 0x14));
 			pr_list_end();
-			pr_attr("State", "%s", dmi_firmware_state(data[0x16]));
+			pr_attr_str("State", dmi_firmware_state(data[0x16]));
 			if (h->length < 0x18 + data[0x17] * 2) break;
 			if (!(opt.flags & FLAG_QUIET))
 				dmi_firmware_components(data[0x17], data + 0x18);
@@ -5539,258 +5823,1837 @@ static void dmi_decode(const struct dmi_header *h, u16 ver)
 	pr_sep();
 }
 
-static void to_dmi_header(struct dmi_header *h, u8 *data)
+/* A table in memory, along with its index */
+struct dmi_table
+{
+	const u8 *buf;
+	u32 len;
+	u16 num;
+	u16 ver;
+	const struct dmi_index *idx;
+	struct dmi_shadow *shadow;
+	off_t base;		/* Where the table was read from */
+	const char *devmem;
+	u32 flags;
+};
+
+static void to_dmi_header(struct dmi_header *h, const u8 *data)
 {
 	h->type = data[0];
 	h->length = data[1];
 	h->handle = WORD(data + 2);
 	h->data = data;
+	h->index = NULL;
+	h->entry = NULL;
+	h->shadow = NULL;
+}
+
+static void entry_to_dmi_header(struct dmi_header *h, const struct dmi_table *t,
+				const struct dmi_index_entry *e)
+{
+	to_dmi_header(h, t->buf + e->offset);
+	h->index = t->idx;
+	h->entry = e;
+	h->shadow = t->shadow;
+}
+
+/*
+ * Handle references (--annotate-handles, --diff)
+ *
+ * References to other structures are looked up in the index of the table
+ * being decoded, and annotated with the type of the target, along with
+ * its designation if it has one. --diff also needs to know where they
+ * are, both in the raw data and in the decoded output.
+ */
+
+static DMI_THREAD const struct dmi_table *ref_table;
+static DMI_THREAD int ref_mark;		/* Mark references, see diff_decode() */
+
+#define DMI_REF_MARK	'\001'
+
+/* The string which tells structures of the same type apart, if any */
+static const char *dmi_designation(const struct dmi_header *h)
+{
+	u8 offset;
+
+	switch (h->type)
+	{
+		case 4: /* Socket Designation */
+		case 7:
+		case 8: /* Internal Reference Designator */
+		case 9: /* Slot Designation */
+		case 26: /* Description */
+		case 28:
+		case 29:
+		case 34:
+		case 35:
+		case 41: /* Reference Designation */
+			offset = 0x04;
+			break;
+		case 17: /* Locator */
+			offset = 0x10;
+			break;
+		case 27: /* Description */
+			offset = 0x0E;
+			break;
+		case 39: /* Location */
+			offset = 0x05;
+			break;
+		default:
+			return NULL;
+	}
+
+	if (h->length <= offset || h->data[offset] == 0)
+		return NULL;
+	return dmi_string(h, h->data[offset]);
+}
+
+/*
+ * Offsets of the references to other structures in the formatted area of
+ * a structure, in increasing order. Returns their number.
+ */
+#define DMI_MAX_REFS	128
+
+static int dmi_ref_add(const struct dmi_header *h, u8 *off, int n,
+		       unsigned int offset)
+{
+	if (offset + 2 <= h->length && n < DMI_MAX_REFS)
+		off[n++] = offset;
+	return n;
+}
+
+static int dmi_handle_refs(const struct dmi_header *h, u8 *off)
+{
+	const u8 *data = h->data;
+	unsigned int offset;
+	int i, n = 0;
+
+	switch (h->type)
+	{
+		case 2: /* Chassis Handle, Contained Object Handles */
+			n = dmi_ref_add(h, off, n, 0x0B);
+			if (h->length < 0x0F) break;
+			for (i = 0; i < data[0x0E]; i++)
+				n = dmi_ref_add(h, off, n, 0x0F + 2 * i);
+			break;
+		case 4: /* L1, L2 and L3 Cache Handles */
+			n = dmi_ref_add(h, off, n, 0x1A);
+			n = dmi_ref_add(h, off, n, 0x1C);
+			n = dmi_ref_add(h, off, n, 0x1E);
+			break;
+		case 5: /* Associated Memory Slots */
+			if (h->length < 0x0F) break;
+			for (i = 0; i < data[0x0E]; i++)
+				n = dmi_ref_add(h, off, n, 0x0F + 2 * i);
+			break;
+		case 14: /* Items */
+			for (i = 0; 0x05 + 3 * i + 3 <= h->length; i++)
+				n = dmi_ref_add(h, off, n, 0x06 + 3 * i);
+			break;
+		case 16: /* Error Information Handle */
+			n = dmi_ref_add(h, off, n, 0x0B);
+			break;
+		case 17: /* Array Handle, Error Information Handle */
+			n = dmi_ref_add(h, off, n, 0x04);
+			n = dmi_ref_add(h, off, n, 0x06);
+			break;
+		case 19: /* Physical Array Handle */
+			n = dmi_ref_add(h, off, n, 0x0C);
+			break;
+		case 20: /* Physical Device Handle, Mapped Address Handle */
+			n = dmi_ref_add(h, off, n, 0x0C);
+			n = dmi_ref_add(h, off, n, 0x0E);
+			break;
+		case 27: /* Temperature Probe Handle */
+		case 44: /* Referenced Handle */
+			n = dmi_ref_add(h, off, n, 0x04);
+			break;
+		case 35: /* Management Device, Component, Threshold Handles */
+			n = dmi_ref_add(h, off, n, 0x05);
+			n = dmi_ref_add(h, off, n, 0x07);
+			n = dmi_ref_add(h, off, n, 0x09);
+			break;
+		case 37: /* Memory Device Handles */
+			if (h->length < 0x07) break;
+			for (i = 0; i < data[0x06]; i++)
+				n = dmi_ref_add(h, off, n, 0x08 + 3 * i);
+			break;
+		case 39: /* Voltage Probe, Cooling Device, Current Probe Handles */
+			n = dmi_ref_add(h, off, n, 0x10);
+			n = dmi_ref_add(h, off, n, 0x12);
+			n = dmi_ref_add(h, off, n, 0x14);
+			break;
+		case 40: /* Referenced Handles, one per entry */
+			if (h->length < 0x05) break;
+			offset = 0x05;
+			for (i = 0; i < data[0x04]; i++)
+			{
+				if (offset >= h->length || data[offset] < 0x05)
+					break;
+				n = dmi_ref_add(h, off, n, offset + 1);
+				offset += data[offset];
+			}
+			break;
+		case 45: /* Associated Components */
+			if (h->length < 0x18) break;
+			for (i = 0; i < data[0x17]; i++)
+				n = dmi_ref_add(h, off, n, 0x18 + 2 * i);
+			break;
+		default:
+			if (h->type >= 128)
+				n = dmi_oem_handle_refs(h, off, DMI_MAX_REFS);
+	}
+
+	return n;
+}
+
+/*
+ * Annotation to display after a handle, empty unless requested. While
+ * decoding for --diff, it starts with DMI_REF_MARK.
+ */
+const char *dmi_handle_ref(u16 handle)
+{
+	static DMI_THREAD char buf[320];
+	const struct dmi_index_entry *e;
+	struct dmi_header h;
+	const char *s;
+	int n = 0;
+
+	if (ref_mark)
+		buf[n++] = DMI_REF_MARK;
+	buf[n] = '\0';
+
+	if (!(opt.flags & FLAG_ANNOTATE) || ref_table == NULL)
+		return buf;
+
+	e = dmi_index_handle(ref_table->idx, handle);
+	if (e == NULL)
+	{
+		snprintf(buf + n, sizeof(buf) - n, " (Not Found)");
+		return buf;
+	}
+
+	entry_to_dmi_header(&h, ref_table, e);
+	s = dmi_designation(&h);
+	if (s != NULL)
+		snprintf(buf + n, sizeof(buf) - n, " (%s, %s)",
+			 dmi_smbios_structure_type(h.type), s);
+	else
+		snprintf(buf + n, sizeof(buf) - n, " (%s)",
+			 dmi_smbios_structure_type(h.type));
+
+	return buf;
+}
+
+/* With --key-value, each value is preceded by its keyword */
+static void dmi_string_key(const struct opt_string *s)
+{
+	if (!(opt.flags & FLAG_KEY_VALUE))
+		return;
+
+	if (s->keyword != NULL)
+		pr_text("%s=", s->keyword);
+	else if (s->offset)
+		pr_text("oem-string-%u=", s->offset);
+	else
+		pr_text("oem-string-count=");
+}
+
+/* Raw value of a field, for --field */
+static void dmi_table_field(const struct opt_string *s,
+			    const struct dmi_header *h, const u8 *data, u16 ver)
+{
+	static const u8 size[] = {
+		[FIELD_BYTE] = 1,
+		[FIELD_WORD] = 2,
+		[FIELD_DWORD] = 4,
+		[FIELD_QWORD] = 8,
+		[FIELD_STRING] = 1,
+		[FIELD_UUID] = 16,
+	};
+	const u8 *p = data + s->offset;
+	u64 code;
+
+	if (s->offset + size[s->field] > h->length)
+		return;
+
+	dmi_string_key(s);
+	switch (s->field)
+	{
+		case FIELD_BYTE:
+			pr_text("0x%02X\n", p[0]);
+			break;
+		case FIELD_WORD:
+			pr_text("0x%04X\n", WORD(p));
+			break;
+		case FIELD_DWORD:
+			pr_text("0x%08X\n", DWORD(p));
+			break;
+		case FIELD_QWORD:
+			code = QWORD(p);
+			pr_text("0x%08X%08X\n", code.h, code.l);
+			break;
+		case FIELD_STRING:
+			pr_text("%s\n", dmi_string(h, p[0]));
+			break;
+		case FIELD_UUID:
+			dmi_system_uuid(NULL, NULL, p, ver);
+			break;
+	}
 }
 
-static void dmi_table_string(const struct dmi_header *h, const u8 *data, u16 ver)
+static void dmi_table_string(const struct opt_string *s,
+			     const struct dmi_header *h, const u8 *data, u16 ver)
 {
 	int key;
-	u8 offset = opt.string->offset;
+	u8 offset = s->offset;
+
+	if (s->field)
+	{
+		dmi_table_field(s, h, data, ver);
+		return;
+	}
 
-	if (opt.string->type == 11) /* OEM strings */
+	if (s->type == 11) /* OEM strings */
 	{
 		if (h->length < 5 || offset > data[4])
 		{
+			pr_sync();
 			fprintf(stderr, "No OEM string number %u\n", offset);
 			return;
 		}
 
+		dmi_string_key(s);
 		if (offset)
-			printf("%s\n", dmi_string(h, offset));
+			pr_text("%s\n", dmi_string(h, offset));
 		else
-			printf("%u\n", data[4]);	/* count */
+			pr_text("%u\n", data[4]);	/* count */
 		return;
 	}
 
 	if (offset >= h->length)
 		return;
 
-	key = (opt.string->type << 8) | offset;
+	key = (s->type << 8) | offset;
 	switch (key)
 	{
 		case 0x015: /* -s bios-revision */
-			if (data[offset - 1] != 0xFF && data[offset] != 0xFF)
-				printf("%u.%u\n", data[offset - 1], data[offset]);
-			break;
 		case 0x017: /* -s firmware-revision */
 			if (data[offset - 1] != 0xFF && data[offset] != 0xFF)
-				printf("%u.%u\n", data[offset - 1], data[offset]);
+			{
+				dmi_string_key(s);
+				pr_text("%u.%u\n", data[offset - 1], data[offset]);
+			}
 			break;
 		case 0x108:
+			dmi_string_key(s);
 			dmi_system_uuid(NULL, NULL, data + offset, ver);
 			break;
 		case 0x305:
-			printf("%s\n", dmi_chassis_type(data[offset]));
+			dmi_string_key(s);
+			pr_text("%s\n", dmi_chassis_type(data[offset]));
 			break;
 		case 0x406:
-			printf("%s\n", dmi_processor_family(h, ver));
+			dmi_string_key(s);
+			pr_text("%s\n", dmi_processor_family(h, ver));
 			break;
 		case 0x416:
+			dmi_string_key(s);
 			dmi_processor_frequency(NULL, data + offset);
 			break;
 		default:
-			printf("%s\n", dmi_string(h, data[offset]));
+			dmi_string_key(s);
+			pr_text("%s\n", dmi_string(h, data[offset]));
 	}
 }
 
-static int dmi_table_dump(const u8 *ep, u32 ep_len, const u8 *table,
-			  u32 table_len)
+static int entry_handle_cmp(const void *a, const void *b)
 {
-	int fd;
-	FILE *f;
+	const struct dmi_index_entry *ea = *(const struct dmi_index_entry * const *)a;
+	const struct dmi_index_entry *eb = *(const struct dmi_index_entry * const *)b;
 
-	fd = open(opt.dumpfile, O_WRONLY|O_CREAT|O_EXCL, 0666);
-	if (fd == -1)
-	{
-		fprintf(stderr, "%s: ", opt.dumpfile);
-		perror("open");
-		return -1;
-	}
+	if (ea->handle != eb->handle)
+		return ea->handle < eb->handle ? -1 : 1;
+	return ea < eb ? -1 : ea > eb;
+}
 
-	f = fdopen(fd, "wb");
-	if (!f)
-	{
-		fprintf(stderr, "%s: ", opt.dumpfile);
-		perror("fdopen");
-		return -1;
-	}
+/*
+ * Display all the requested strings, from the same table. Entries of a
+ * given type are taken in table order, or in handle order for the
+ * keywords of multi-instance types. Handle order is almost always the
+ * table order, so they are only sorted if needed.
+ */
+static void dmi_table_strings(const struct dmi_table *t, u32 count)
+{
+	const struct dmi_index *idx = t->idx;
+	const struct dmi_index_entry *e, **list = NULL;
+	struct dmi_header h;
+	unsigned int k;
+	u32 i, n, size = 0;
+	int sorted;
 
-	if (!(opt.flags & FLAG_QUIET))
-		pr_comment("Writing %d bytes to %s.", ep_len, opt.dumpfile);
-	if (fwrite(ep, ep_len, 1, f) != 1)
+	for (k = 0; k < opt.string_count; k++)
 	{
-		fprintf(stderr, "%s: ", opt.dumpfile);
-		perror("fwrite");
-		goto err_close;
-	}
+		n = 0;
+		sorted = 1;
+		for (e = dmi_index_type(idx, opt.string[k].type);
+		     e != NULL && (u32)(e - idx->entry) < count;
+		     e = dmi_index_next(idx, e))
+		{
+			if (n == size)
+			{
+				const struct dmi_index_entry **p;
 
-	if (fseek(f, 32, SEEK_SET) != 0)
-	{
-		fprintf(stderr, "%s: ", opt.dumpfile);
-		perror("fseek");
-		goto err_close;
-	}
+				size = size ? 2 * size : 16;
+				p = realloc(list, size * sizeof(*list));
+				if (p == NULL)
+				{
+					perror("realloc");
+					goto out;
+				}
+				list = p;
+			}
+			if (n && e->handle < list[n - 1]->handle)
+				sorted = 0;
+			list[n++] = e;
+		}
 
-	if (!(opt.flags & FLAG_QUIET))
-		pr_comment("Writing %d bytes to %s.", table_len, opt.dumpfile);
-	if (fwrite(table, table_len, 1, f) != 1)
-	{
-		fprintf(stderr, "%s: ", opt.dumpfile);
-		perror("fwrite");
-		goto err_close;
-	}
+		if (!sorted && opt.string[k].ordered)
+			qsort(list, n, sizeof(*list), entry_handle_cmp);
 
-	if (fclose(f))
-	{
-		fprintf(stderr, "%s: ", opt.dumpfile);
-		perror("fclose");
-		return -1;
+		for (i = 0; i < n; i++)
+		{
+			entry_to_dmi_header(&h, t, list[i]);
+			dmi_table_string(&opt.string[k], &h, h.data, t->ver);
+		}
 	}
 
-	return 0;
+out:
+	free(list);
+}
 
-err_close:
+/*
+ * Physical address resolution (--resolve-address)
+ *
+ * The address ranges of memory devices (type 20) and memory arrays
+ * (type 19) are sorted by starting address. Ranges may overlap (if
+ * memory is interleaved), so each range also records the highest ending
+ * address of the ranges up to it, which tells when to stop looking back.
+ */
+
+struct addr_range
+{
+	unsigned long long start;	/* In bytes */
+	unsigned long long end;		/* In bytes, inclusive */
+	unsigned long long max_end;
+	const struct dmi_index_entry *device;	/* Type 17, NULL if unknown */
+};
+
+static int addr_range_cmp(const void *a, const void *b)
+{
+	const struct addr_range *ra = a, *rb = b;
+
+	if (ra->start != rb->start)
+		return ra->start < rb->start ? -1 : 1;
+	return ra->end < rb->end ? -1 : ra->end > rb->end;
+}
+
+static unsigned long long u64_to_ull(u64 v)
+{
+	return ((unsigned long long)v.h << 32) | v.l;
+}
+
+/*
+ * The memory device which an array range belongs to, if there's no
+ * doubt: the array must have a single installed device.
+ */
+static const struct dmi_index_entry *addr_array_device(const struct dmi_table *t,
+	u32 count, u16 array)
+{
+	const struct dmi_index *idx = t->idx;
+	const struct dmi_index_entry *e, *device = NULL;
+	struct dmi_header h;
+
+	for (e = dmi_index_type(idx, 17); e != NULL && (u32)(e - idx->entry) < count;
+	     e = dmi_index_next(idx, e))
+	{
+		if (e->length < 0x15)
+			continue;
+		entry_to_dmi_header(&h, t, e);
+		if (WORD(h.data + 0x04) != array || WORD(h.data + 0x0C) == 0)
+			continue;
+		if (device != NULL)
+			return NULL;
+		device = e;
+	}
+
+	return device;
+}
+
+/*
+ * Collect the address ranges of the given type (19 or 20), sorted.
+ * Returns the number of ranges, -1 on error.
+ */
+static int addr_ranges(const struct dmi_table *t, u32 count, u8 type,
+		       struct addr_range **list)
+{
+	const struct dmi_index *idx = t->idx;
+	const struct dmi_index_entry *e, *device;
+	struct dmi_header h;
+	struct addr_range *r;
+	unsigned long long start, end;
+	u8 ext = type == 19 ? 0x0F : 0x13;	/* Extended addresses */
+	int i, n = 0, size = 0;
+
+	*list = NULL;
+	for (e = dmi_index_type(idx, type); e != NULL && (u32)(e - idx->entry) < count;
+	     e = dmi_index_next(idx, e))
+	{
+		if (e->length < ext)
+			continue;
+		entry_to_dmi_header(&h, t, e);
+
+		if (h.length >= ext + 0x10 && DWORD(h.data + 0x04) == 0xFFFFFFFF)
+		{
+			start = u64_to_ull(QWORD(h.data + ext));
+			end = u64_to_ull(QWORD(h.data + ext + 0x08));
+			if (end == start)
+				continue;
+		}
+		else
+		{
+			start = (unsigned long long)DWORD(h.data + 0x04) << 10;
+			end = ((unsigned long long)DWORD(h.data + 0x08) << 10) + 0x3FF;
+		}
+		if (end < start)
+			continue;
+
+		if (type == 20)
+		{
+			device = dmi_index_handle(idx, WORD(h.data + 0x0C));
+			if (device != NULL && device->type != 17)
+				device = NULL;
+		}
+		else
+			device = addr_array_device(t, count, WORD(h.data + 0x0C));
+
+		if (n == size)
+		{
+			size = size ? 2 * size : 16;
+			r = realloc(*list, size * sizeof(struct addr_range));
+			if (r == NULL)
+			{
+				perror("realloc");
+				free(*list);
+				*list = NULL;
+				return -1;
+			}
+			*list = r;
+		}
+		r = &(*list)[n++];
+		r->start = start;
+		r->end = end;
+		r->device = device;
+	}
+
+	if (n == 0)
+		return 0;
+
+	r = *list;
+	qsort(r, n, sizeof(struct addr_range), addr_range_cmp);
+	r[0].max_end = r[0].end;
+	for (i = 1; i < n; i++)
+		r[i].max_end = r[i].end > r[i - 1].max_end ? r[i].end : r[i - 1].max_end;
+
+	return n;
+}
+
+/* Display the devices of the ranges holding addr, returns how many */
+static int addr_lookup(const struct dmi_table *t, const struct addr_range *r,
+		       int n, unsigned long long addr)
+{
+	struct dmi_header h;
+	int lo = 0, hi = n, mid, found = 0;
+
+	/* Find the first range starting after addr */
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (r[mid].start <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	while (--lo >= 0 && r[lo].max_end >= addr)
+	{
+		if (r[lo].end < addr || r[lo].device == NULL)
+			continue;
+
+		entry_to_dmi_header(&h, t, r[lo].device);
+		pr_text("0x%016llX\t%s\t%s\t%s\n", addr,
+			dmi_string(&h, h.data[0x10]),
+			dmi_string(&h, h.data[0x11]),
+			h.length >= 0x19 ? dmi_string(&h, h.data[0x18]) : "Not Specified");
+		found++;
+	}
+
+	return found;
+}
+
+static void dmi_resolve_line(const struct dmi_table *t,
+			     const struct addr_range *dev, int ndev,
+			     const struct addr_range *arr, int narr, char *line)
+{
+	unsigned long long addr;
+	char *next;
+
+	while (*line == ' ' || *line == '\t')
+		line++;
+	if (*line == '\0' || *line == '#')
+		return;
+
+	errno = 0;
+	addr = strtoull(line, &next, 16);
+	while (*next == ' ' || *next == '\t' || *next == '\r')
+		next++;
+	if (next == line || *next != '\0' || errno != 0)
+	{
+		pr_sync();
+		fprintf(stderr, "Invalid address: %s\n", line);
+		return;
+	}
+
+	/* Fall back to the array if no device range holds the address */
+	if (addr_lookup(t, dev, ndev, addr) == 0
+	 && addr_lookup(t, arr, narr, addr) == 0)
+		pr_text("0x%016llX\tUnknown\tUnknown\tUnknown\n", addr);
+}
+
+/*
+ * Read physical addresses from stdin, and display the memory device
+ * holding each of them. Output is written out every time input runs dry,
+ * so that it can be used at the end of a pipe.
+ */
+static void dmi_table_resolve(const struct dmi_table *t, u32 count)
+{
+	struct addr_range *dev, *arr = NULL;
+	int ndev, narr;
+	char *in, *line, *nl;
+	size_t len = 0, size = 64 * 1024;
+	ssize_t n;
+
+	if ((ndev = addr_ranges(t, count, 20, &dev)) < 0
+	 || (narr = addr_ranges(t, count, 19, &arr)) < 0)
+		goto out;
+
+	in = malloc(size);
+	if (in == NULL)
+	{
+		perror("malloc");
+		goto out;
+	}
+
+	for (;;)
+	{
+		pr_flush();
+		n = read(STDIN_FILENO, in + len, size - 1 - len);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("read");
+			break;
+		}
+		if (n == 0)
+		{
+			/* Last line, without a new line */
+			in[len] = '\0';
+			dmi_resolve_line(t, dev, ndev, arr, narr, in);
+			break;
+		}
+		len += n;
+
+		line = in;
+		while ((nl = memchr(line, '\n', in + len - line)) != NULL)
+		{
+			*nl = '\0';
+			dmi_resolve_line(t, dev, ndev, arr, narr, line);
+			line = nl + 1;
+		}
+		len -= line - in;
+		memmove(in, line, len);
+
+		if (len == size - 1)
+		{
+			pr_sync();
+			fprintf(stderr, "Input line too long\n");
+			len = 0;
+		}
+	}
+
+	free(in);
+out:
+	free(arr);
+	free(dev);
+}
+
+/*
+ * Display the whole table, structures, strings and anything past the end
+ * of table marker, in the layout of xxd(1). Offsets are relative to the
+ * start of the table, xxd -r turns the output back into binary.
+ */
+static void dmi_table_dump_all(const u8 *buf, u32 len)
+{
+	char rows[64 * HEX_XXD_ROW];
+	size_t n = 0;
+	u32 off;
+
+	for (off = 0; off < len; off += 16)
+	{
+		n += hex_xxd_row(rows + n, off, buf + off,
+				 len - off < 16 ? len - off : 16);
+		if (n > sizeof(rows) - HEX_XXD_ROW)
+		{
+			pr_write(rows, n);
+			n = 0;
+		}
+	}
+	if (n)
+		pr_write(rows, n);
+}
+
+/* Save specific values needed to decode OEM types */
+static void dmi_table_vendor(const struct dmi_table *t, u32 count)
+{
+	const struct dmi_index *idx = t->idx;
+	const struct dmi_index_entry *e;
+	struct dmi_header h;
+
+	for (e = dmi_index_type(idx, 1); e != NULL && (u32)(e - idx->entry) < count;
+	     e = dmi_index_next(idx, e))
+	{
+		/* Assign vendor for vendor-specific decodes later */
+		if (e->length >= 6)
+		{
+			entry_to_dmi_header(&h, t, e);
+			dmi_set_vendor(_dmi_string(&h, h.data[0x04], 0),
+				       _dmi_string(&h, h.data[0x05], 0));
+		}
+	}
+	for (e = dmi_index_type(idx, 4); e != NULL && (u32)(e - idx->entry) < count;
+	     e = dmi_index_next(idx, e))
+	{
+		/* Remember CPUID type for HPE type 199 */
+		if (e->length >= 0x1A && cpuid_type == cpuid_none)
+		{
+			entry_to_dmi_header(&h, t, e);
+			cpuid_type = dmi_get_cpuid_type(&h);
+		}
+	}
+}
+
+/*
+ * Read part of the table again from where it was read, to catch up with
+ * changes made by the firmware since. Returns NULL on error.
+ */
+static u8 *dmi_table_reread(const struct dmi_table *t, u32 offset, u32 len)
+{
+	size_t size = len;
+	u8 *p;
+
+	if ((t->flags & FLAG_NO_FILE_OFFSET) || (opt.flags & FLAG_FROM_DUMP))
+	{
+		p = read_file((t->flags & FLAG_NO_FILE_OFFSET ? 0 : t->base)
+			      + offset, &size, t->devmem);
+		if (p != NULL && size != len)
+		{
+			free(p);
+			p = NULL;
+		}
+	}
+	else
+		p = mem_chunk(t->base + offset, len, t->devmem);
+	if (p != NULL)
+		dmi_stats_read(len);
+
+	return p;
+}
+
+/*
+ * System event log reading (--event-log)
+ *
+ * Each log has a cursor telling which records were already displayed,
+ * so that only the records added since are displayed when following the
+ * log (--follow) or across runs (--state-file). The log area is only read
+ * again if the change token of the log changed.
+ */
+
+struct event_log_cursor
+{
+	u16 handle;
+	u32 token;		/* Change token when the log was last read */
+	u32 offset;		/* Of the next record, 0 if never read */
+	unsigned int count;	/* Records displayed so far */
+	u8 last[8];		/* Header and date of the last record */
+};
+
+static volatile sig_atomic_t event_log_stop;
+
+static void event_log_signal(int sig)
+{
+	(void)sig;
+	event_log_stop = 1;
+}
+
+/*
+ * The state file has one line per log: handle, change token, offset of
+ * the next record, record count, and last record header in hexadecimal.
+ */
+static void event_log_load(const char *path, struct event_log_cursor *cursor,
+			   unsigned int n)
+{
+	struct event_log_cursor c;
+	char line[128], last[17];
+	unsigned int i, handle, byte;
+	FILE *f;
+
+	if ((f = fopen(path, "r")) == NULL)
+	{
+		/* First run */
+		if (errno != ENOENT)
+			perror(path);
+		return;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		if (sscanf(line, "%x %x %x %u %16s", &handle, &c.token,
+			   &c.offset, &c.count, last) != 5
+		 || strlen(last) != 16 || handle > 0xFFFF)
+		{
+			fprintf(stderr, "%s: Invalid state, ignored\n", path);
+			continue;
+		}
+		for (i = 0; i < 8; i++)
+		{
+			sscanf(last + 2 * i, "%2x", &byte);
+			c.last[i] = byte;
+		}
+		c.handle = handle;
+
+		/* The last record is read back, it must be a whole one */
+		if (c.count != 0 && (c.last[1] & 0x7F) < 0x08)
+		{
+			fprintf(stderr, "%s: Invalid state, ignored\n", path);
+			continue;
+		}
+
+		for (i = 0; i < n; i++)
+			if (cursor[i].handle == c.handle)
+				cursor[i] = c;
+	}
+
+	fclose(f);
+}
+
+static void event_log_save(const char *path,
+			   const struct event_log_cursor *cursor, unsigned int n)
+{
+	unsigned int i, j;
+	char *tmp;
+	FILE *f;
+	int fd;
+
+	/*
+	 * Replace the file at once, so that it is never seen half written.
+	 * The temporary file gets a name nobody can guess or create first.
+	 */
+	if ((tmp = malloc(strlen(path) + 8)) == NULL)
+	{
+		perror("malloc");
+		return;
+	}
+	sprintf(tmp, "%s.XXXXXX", path);
+
+	if ((fd = mkstemp(tmp)) == -1)
+	{
+		fprintf(stderr, "%s: ", tmp);
+		perror("mkstemp");
+		goto out;
+	}
+	if ((f = fdopen(fd, "w")) == NULL)
+	{
+		fprintf(stderr, "%s: ", tmp);
+		perror("fdopen");
+		close(fd);
+		goto out_unlink;
+	}
+	for (i = 0; i < n; i++)
+	{
+		fprintf(f, "0x%04X 0x%08X 0x%04X %u ", cursor[i].handle,
+			cursor[i].token, cursor[i].offset, cursor[i].count);
+		for (j = 0; j < 8; j++)
+			fprintf(f, "%02X", cursor[i].last[j]);
+		fprintf(f, "\n");
+	}
+	if (fclose(f) != 0)
+	{
+		fprintf(stderr, "%s: ", tmp);
+		perror("fclose");
+		goto out_unlink;
+	}
+
+	if (rename(tmp, path) == 0)
+		goto out;
+	fprintf(stderr, "%s: ", path);
+	perror("rename");
+
+out_unlink:
+	unlink(tmp);
+out:
+	free(tmp);
+}
+
+/*
+ * Read the log area of a type 15 entry, from the log image file if one
+ * was given, else from memory if the access method allows it. Returns
+ * NULL on error, else sets len to the length actually read.
+ */
+static u8 *dmi_event_log_read(const struct dmi_header *h, u32 *len)
+{
+	const u8 *data = h->data;
+	size_t size = WORD(data + 0x04);
+	u8 *log;
+
+	/* Reading the log may fail with error messages */
+	pr_sync();
+
+	if (opt.eventlog != NULL)
+		log = read_file(0, &size, opt.eventlog);
+	else if (data[0x0A] != 0x03)
+	{
+		fprintf(stderr, "Event log access method not supported: %s.\n",
+			dmi_event_log_method(data[0x0A]));
+		return NULL;
+	}
+	else if (opt.flags & FLAG_FROM_DUMP)
+	{
+		fprintf(stderr, "Event log not in dump file, use --event-log=FILE.\n");
+		return NULL;
+	}
+	else
+		log = mem_chunk(DWORD(data + 0x10), size, opt.devmem);
+
+	if (log == NULL)
+	{
+		fprintf(stderr, "Failed to read event log, sorry.\n");
+		return NULL;
+	}
+	dmi_stats_read(size);
+
+	*len = size;
+	return log;
+}
+
+/*
+ * Whether the records seen so far are still there (log not cleared).
+ * Records may have been marked as read since, which changes bit 7 of
+ * their length.
+ */
+static int dmi_event_log_resume(const struct event_log_cursor *c,
+				const u8 *log, u32 start, u32 len)
+{
+	u8 last = c->last[1] & 0x7F;
+	const u8 *p;
+
+	if (c->count == 0)
+		return c->offset == start;
+	if (last < 0x08 || c->offset < start + last || c->offset > len)
+		return 0;
+
+	p = log + c->offset - last;
+	return p[0] == c->last[0] && (p[1] & 0x7F) == last
+		&& memcmp(p + 2, c->last + 2, 6) == 0;
+}
+
+/*
+ * Display the records added to a log since its cursor was last updated,
+ * along with the description of the log if full is set, else only if
+ * there are new records. The log area is only read if token differs from
+ * the token of the cursor, or if the log is read from an image file, as
+ * there is no token to compare then. Returns 1 if the cursor was updated.
+ */
+static int dmi_event_log(const struct dmi_header *h, u32 token,
+			 struct event_log_cursor *c, int full)
+{
+	const u8 *data = h->data;
+	u16 header = 0, start = 0;
+	u8 *log = NULL;
+	u32 len = 0;
+	int updated;
+
+	if (h->length >= 0x14
+	 && (c->offset == 0 || token != c->token || opt.eventlog != NULL))
+		log = dmi_event_log_read(h, &len);
+	updated = log != NULL;
+
+	if (log != NULL)
+	{
+		header = WORD(data + 0x06);
+		start = WORD(data + 0x08);
+		if (!dmi_event_log_resume(c, log, start, len))
+		{
+			c->offset = start;
+			c->count = 0;
+		}
+		c->token = token;
+	}
+	if (!full && (log == NULL || dmi_event_log_end(log, c->offset, len)))
+		goto out;
+
+	if (!(opt.flags & FLAG_QUIET))
+		pr_handle(h);
+	pr_handle_name("System Event Log");
+	if (h->length < 0x14)
+		goto out_sep;
+	if (full)
+	{
+		pr_attr_str("Access Method",
+			dmi_event_log_method(data[0x0A]));
+		dmi_event_log_address(data[0x0A], data + 0x10);
+		dmi_event_log_status(data[0x0B]);
+	}
+	pr_attr_hex32("Change Token", token);
+	if (log == NULL)
+		goto out_sep;
+
+	if (full && h->length >= 0x17 && data[0x14] == 0x01
+	 && header + 0x10 <= start && start <= len)
+		dmi_event_log_header(log + header);
+	if (c->offset < len)
+		c->offset = dmi_event_log_records(h, log, c->offset, len,
+						  &c->count, c->last);
+	if (c->count == 0)
+		pr_attr_str("Events", "None");
+
+out_sep:
+	pr_sep();
+out:
+	free(log);
+	return updated;
+}
+
+/*
+ * Display the events of all the event logs of the table, then, with
+ * --follow, poll the change tokens of the logs and display new events
+ * until interrupted.
+ */
+static void dmi_table_event_log(const struct dmi_table *t, u32 count)
+{
+	const struct dmi_index *idx = t->idx;
+	const struct dmi_index_entry *e, *first;
+	struct sigaction sa, old_int, old_term;
+	struct event_log_cursor *cursor;
+	struct dmi_header h;
+	unsigned int i, n = 0;
+	int changed;
+	u32 token;
+	u8 *p;
+
+	first = dmi_index_type(idx, 15);
+	for (e = first; e != NULL && (u32)(e - idx->entry) < count;
+	     e = dmi_index_next(idx, e))
+		n++;
+	if (n == 0)
+		return;
+
+	if ((cursor = calloc(n, sizeof(struct event_log_cursor))) == NULL)
+	{
+		perror("calloc");
+		return;
+	}
+	for (i = 0, e = first; i < n; i++, e = dmi_index_next(idx, e))
+		cursor[i].handle = e->handle;
+	if (opt.statefile != NULL)
+		event_log_load(opt.statefile, cursor, n);
+
+	for (i = 0, e = first; i < n; i++, e = dmi_index_next(idx, e))
+	{
+		entry_to_dmi_header(&h, t, e);
+		dmi_event_log(&h, h.length >= 0x14 ? DWORD(h.data + 0x0C) : 0,
+			      &cursor[i], 1);
+	}
+	if (opt.statefile != NULL)
+		event_log_save(opt.statefile, cursor, n);
+
+	if (opt.interval == 0)
+		goto out;
+
+	/* No SA_RESTART, so that sleep() returns */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = event_log_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, &old_int);
+	sigaction(SIGTERM, &sa, &old_term);
+
+	while (!event_log_stop)
+	{
+		pr_flush();
+		sleep(opt.interval);
+
+		changed = 0;
+		for (i = 0, e = first; i < n && !event_log_stop;
+		     i++, e = dmi_index_next(idx, e))
+		{
+			if (e->length < 0x14)
+				continue;
+
+			/* The token is all that needs to be read */
+			token = cursor[i].token;
+			if (opt.eventlog == NULL)
+			{
+				pr_sync();
+				if ((p = dmi_table_reread(t, e->offset + 0x0C, 4)) == NULL)
+					continue;
+				token = DWORD(p);
+				free(p);
+			}
+
+			entry_to_dmi_header(&h, t, e);
+			changed |= dmi_event_log(&h, token, &cursor[i], 0);
+		}
+		if (changed && opt.statefile != NULL)
+			event_log_save(opt.statefile, cursor, n);
+	}
+
+	sigaction(SIGINT, &old_int, NULL);
+	sigaction(SIGTERM, &old_term, NULL);
+out:
+	free(cursor);
+}
+
+/*
+ * Table comparison (--diff)
+ *
+ * Structures are matched by type, designation (for the types which have
+ * one) and rank among the structures of the same type and designation,
+ * so that renumbered handles don't get in the way. Matching structures
+ * are compared by a hash of their contents first, and only if the hashes
+ * differ, they are decoded and their output compared line by line.
+ *
+ * Matching pairs are numbered, and references to other structures, both
+ * in the raw data and in the decoded lines, are compared by the number of
+ * the pair they point to, or by handle if they point to no pair. This way
+ * a structure which only refers to renumbered structures is unchanged.
+ */
+
+#define DIFF_NO_PAIR	~0U
+
+struct diff_entry
+{
+	const struct dmi_index_entry *e;
+	const char *key;		/* Designation, "" if none */
+	u32 rank;			/* Among entries with the same key */
+	u32 ref;			/* References, in refs of the side */
+	u8 nref;
+};
+
+struct diff_side
+{
+	const struct dmi_table *t;
+	u32 count;
+	struct diff_entry *list;
+	u32 n;
+	u8 *refs;			/* Offsets of references */
+	u32 *pair;			/* Pair number, by handle */
+};
+
+static const struct diff_side *diff_base;	/* First table, while reading the second one */
+static unsigned int diff_changes;
+static int diff_failed;			/* Second table not found */
+
+static int decode_dump(const char *filename, int *found);
+
+/* Decoders of OEM types depend on the table */
+static void diff_side_vendor(const struct diff_side *s)
+{
+	dmi_reset_vendor();
+	cpuid_type = cpuid_none;
+	dmi_table_vendor(s->t, s->count);
+	ref_table = s->t;
+}
+
+static unsigned long long diff_hash_byte(unsigned long long hash, u8 c)
+{
+	return (hash ^ c) * 0x100000001B3ULL;
+}
+
+/* 64-bit FNV-1a of a structure, except its handle */
+static unsigned long long diff_hash(const struct diff_side *s,
+				    const struct diff_entry *d)
+{
+	unsigned long long hash = 0xCBF29CE484222325ULL;
+	const u8 *ref = s->refs + d->ref;
+	struct dmi_header h;
+	u32 i, k = 0, v;
+
+	entry_to_dmi_header(&h, s->t, d->e);
+	hash = diff_hash_byte(hash, h.data[0]);
+	hash = diff_hash_byte(hash, h.data[1]);
+	for (i = 4; i < d->e->size; i++)
+	{
+		if (k == d->nref || i != ref[k])
+		{
+			hash = diff_hash_byte(hash, h.data[i]);
+			continue;
+		}
+
+		/* A reference counts as its pair, or its handle if none */
+		v = s->pair[WORD(h.data + i)];
+		hash = diff_hash_byte(hash, v != DIFF_NO_PAIR);
+		if (v == DIFF_NO_PAIR)
+			v = WORD(h.data + i);
+		hash = diff_hash_byte(hash, v & 0xFF);
+		hash = diff_hash_byte(hash, v >> 8);
+		hash = diff_hash_byte(hash, v >> 16);
+		hash = diff_hash_byte(hash, v >> 24);
+		i++;
+		k++;
+	}
+
+	return hash;
+}
+
+static int diff_entry_cmp(const void *a, const void *b)
+{
+	const struct diff_entry *da = a, *db = b;
+	int r;
+
+	if (da->e->type != db->e->type)
+		return da->e->type < db->e->type ? -1 : 1;
+	if ((r = strcmp(da->key, db->key)) != 0)
+		return r;
+	return da->rank < db->rank ? -1 : da->rank > db->rank;
+}
+
+/* Returns -1 on error */
+static int diff_side_build(struct diff_side *s, const struct dmi_table *t,
+			   u32 count)
+{
+	const struct dmi_index_entry *e;
+	struct diff_entry *d;
+	struct dmi_header h;
+	u8 off[DMI_MAX_REFS];
+	u32 nrefs = 0, size = 0;
+	const char *key;
+	u32 i;
+	int n;
+
+	s->t = t;
+	s->count = count;
+	s->n = 0;
+	s->refs = NULL;
+	s->list = malloc(count * sizeof(struct diff_entry) + 1);
+	s->pair = malloc(0x10000 * sizeof(u32));
+	if (s->list == NULL || s->pair == NULL)
+	{
+		perror("malloc");
+		return -1;
+	}
+	memset(s->pair, 0xFF, 0x10000 * sizeof(u32));
+
+	diff_side_vendor(s);
+	for (i = 0; i < count; i++)
+	{
+		e = &t->idx->entry[i];
+		if (opt.type != NULL && !opt.type[e->type])
+			continue;
+
+		entry_to_dmi_header(&h, t, e);
+		key = dmi_designation(&h);
+		d = &s->list[s->n++];
+		d->e = e;
+		d->key = key != NULL ? key : "";
+		d->rank = i;	/* Table order, for now */
+
+		n = dmi_handle_refs(&h, off);
+		if (nrefs + n > size)
+		{
+			u8 *p;
+
+			size = size ? 2 * size + n : 1024;
+			if ((p = realloc(s->refs, size)) == NULL)
+			{
+				perror("realloc");
+				return -1;
+			}
+			s->refs = p;
+		}
+		memcpy(s->refs + nrefs, off, n);
+		d->ref = nrefs;
+		d->nref = n;
+		nrefs += n;
+	}
+
+	/* Sort by key, then turn table order into ranks */
+	qsort(s->list, s->n, sizeof(struct diff_entry), diff_entry_cmp);
+	for (i = 0; i < s->n; i++)
+	{
+		d = &s->list[i];
+		d->rank = (i > 0 && d->e->type == d[-1].e->type
+			   && strcmp(d->key, d[-1].key) == 0) ? d[-1].rank + 1 : 0;
+	}
+
+	return 0;
+}
+
+static void diff_side_free(struct diff_side *s)
+{
+	free(s->pair);
+	free(s->refs);
+	free(s->list);
+}
+
+/* Number the matching pairs of structures */
+static void diff_pairs(const struct diff_side *a, const struct diff_side *b)
+{
+	u32 i = 0, j = 0, k = 0;
+	int r;
+
+	while (i < a->n && j < b->n)
+	{
+		r = diff_entry_cmp(&a->list[i], &b->list[j]);
+		if (r < 0)
+			i++;
+		else if (r > 0)
+			j++;
+		else
+		{
+			a->pair[a->list[i++].e->handle] = k;
+			b->pair[b->list[j++].e->handle] = k++;
+		}
+	}
+}
+
+static int diff_hex4(const char *p, u16 *v)
+{
+	int i;
+
+	*v = 0;
+	for (i = 0; i < 4; i++)
+	{
+		if (!isxdigit((unsigned char)p[i]))
+			return 0;
+		*v = (*v << 4) | (isdigit((unsigned char)p[i]) ? p[i] - '0'
+				  : (tolower((unsigned char)p[i]) - 'a' + 10));
+	}
+	return 1;
+}
+
+/*
+ * Remove the marks which dmi_handle_ref() puts after references in the
+ * decoded output. If pair is set, references which point to a pair are
+ * also replaced with its number, of the same width. Returns the new
+ * length.
+ */
+static size_t diff_unmark(char *p, size_t len, const u32 *pair)
+{
+	char num[12];
+	size_t i, j = 0;
+	u16 handle;
+
+	for (i = 0; i < len; i++)
+	{
+		if (p[i] != DMI_REF_MARK)
+		{
+			p[j++] = p[i];
+			continue;
+		}
+		if (pair != NULL && j >= 6 && p[j - 6] == '0' && p[j - 5] == 'x'
+		 && diff_hex4(p + j - 4, &handle) && pair[handle] < 100000)
+		{
+			snprintf(num, sizeof(num), "#%05u", pair[handle]);
+			memcpy(p + j - 6, num, 6);
+		}
+	}
+
+	return j;
+}
+
+/* Split text into lines, in place. Returns their number. */
+static int diff_split(char *p, size_t len, char **line)
+{
+	size_t i;
+	int n = 0;
+
+	for (i = 0; i < len; i++)
+	{
+		if (i == 0 || p[i - 1] == '\0')
+			line[n++] = p + i;
+		if (p[i] == '\n')
+			p[i] = '\0';
+	}
+
+	return n;
+}
+
+/*
+ * Decode a structure into a buffer, one line per attribute, as it would
+ * be displayed. Returns the number of lines, and sets line to an array of
+ * them, followed by the same lines with references replaced by their
+ * pair number, to compare. The caller must free it along with buf.
+ * Returns -1 on error.
+ */
+static int diff_decode(const struct diff_side *s, const struct dmi_index_entry *e,
+		       int dump, char **buf, char ***line)
+{
+	struct dmi_header h;
+	size_t len, size, i;
+	char *p;
+	int n = 0;
+
+	diff_side_vendor(s);
+
+	entry_to_dmi_header(&h, s->t, e);
+	pr_capture_start();
+	ref_mark = 1;
+	if (dump)
+		dmi_dump(&h);
+	else
+		dmi_decode(&h, s->t->ver);
+	ref_mark = 0;
+	*buf = pr_capture_end(&len);
+	*line = NULL;
+	if (*buf == NULL)
+		return 0;
+
+	/* Lines to display, then lines to compare */
+	if ((p = realloc(*buf, 2 * len + 1)) == NULL)
+	{
+		perror("realloc");
+		free(*buf);
+		return -1;
+	}
+	*buf = p;
+	memcpy(p + len, p, len);
+	size = len;
+	diff_unmark(p + size, size, s->pair);
+	len = diff_unmark(p, size, NULL);
+
+	for (i = 0; i < len; i++)
+		if (p[i] == '\n' || i == len - 1)
+			n++;
+	if ((*line = malloc(2 * n * sizeof(char *) + 1)) == NULL)
+	{
+		perror("malloc");
+		free(*buf);
+		return -1;
+	}
+
+	/* Both have the same lines, of the same lengths */
+	n = diff_split(p, len, *line);
+	diff_split(p + size, len, *line + n);
+
+	return n;
+}
+
+/* Display the decoded output of a structure, each line marked with c */
+static void diff_print(const struct diff_side *s, const struct dmi_index_entry *e,
+		       char c)
+{
+	char *buf, **line;
+	int i, n;
+
+	if ((n = diff_decode(s, e, 0, &buf, &line)) < 0)
+		return;
+	for (i = 0; i < n; i++)
+		pr_text("%c%s\n", c, line[i]);
+	free(line);
+	free(buf);
+}
+
+/*
+ * Display the lines which differ between two outputs, based on their
+ * longest common subsequence of the lines to compare, which follow the
+ * lines to display. The first line (the name of the type) is always
+ * displayed. Returns the number of lines which differ.
+ */
+static int diff_lines(char **a, int na, char **b, int nb)
+{
+	char **ka = a + na, **kb = b + nb;
+	unsigned int *lcs;
+	int i, j, w = nb + 1, diffs = 0;
+
+	if (na > 0 && nb > 0 && strcmp(a[0], b[0]) == 0)
+		pr_text(" %s\n", a[0]);
+
+	lcs = calloc((size_t)(na + 1) * w, sizeof(unsigned int));
+	if (lcs == NULL)
+	{
+		perror("calloc");
+		return 0;
+	}
+	for (i = na - 1; i >= 0; i--)
+		for (j = nb - 1; j >= 0; j--)
+			lcs[i * w + j] = strcmp(ka[i], kb[j]) == 0
+				? lcs[(i + 1) * w + j + 1] + 1
+				: lcs[(i + 1) * w + j] > lcs[i * w + j + 1]
+				? lcs[(i + 1) * w + j] : lcs[i * w + j + 1];
+
+	i = j = 0;
+	while (i < na || j < nb)
+	{
+		if (i < na && j < nb && strcmp(ka[i], kb[j]) == 0)
+		{
+			i++;
+			j++;
+		}
+		else if (j == nb || (i < na && lcs[(i + 1) * w + j] >= lcs[i * w + j + 1]))
+		{
+			pr_text("-%s\n", a[i++]);
+			diffs++;
+		}
+		else
+		{
+			pr_text("+%s\n", b[j++]);
+			diffs++;
+		}
+	}
+
+	free(lcs);
+	return diffs;
+}
+
+static void diff_changed(const struct diff_side *sa, const struct diff_entry *a,
+			 const struct diff_side *sb, const struct diff_entry *b)
+{
+	char *buf_a, *buf_b, **line_a, **line_b;
+	int dump, na, nb;
+
+	pr_text("Handle 0x%04X, DMI type %d, %d bytes (changed",
+		b->e->handle, b->e->type, b->e->length);
+	if (a->e->handle != b->e->handle)
+		pr_text(", was handle 0x%04X", a->e->handle);
+	if (a->e->length != b->e->length)
+		pr_text(", was %d bytes", a->e->length);
+	pr_text(")\n");
+
+	/* If the difference isn't decoded, compare the raw data */
+	for (dump = 0; dump <= 1; dump++)
+	{
+		if ((na = diff_decode(sa, a->e, dump, &buf_a, &line_a)) < 0)
+			return;
+		if ((nb = diff_decode(sb, b->e, dump, &buf_b, &line_b)) < 0)
+		{
+			free(line_a);
+			free(buf_a);
+			return;
+		}
+		na = diff_lines(line_a, na, line_b, nb);
+		free(line_a);
+		free(buf_a);
+		free(line_b);
+		free(buf_b);
+		if (na != 0)
+			break;
+	}
+}
+
+/* Display the differences between two tables */
+static void diff_tables(const struct diff_side *a, const struct diff_side *b)
+{
+	unsigned int added = 0, removed = 0, changed = 0, same = 0;
+	u32 i = 0, j = 0;
+	int r;
+
+	diff_pairs(a, b);
+	while (i < a->n || j < b->n)
+	{
+		if (i == a->n)
+			r = 1;
+		else if (j == b->n)
+			r = -1;
+		else
+			r = diff_entry_cmp(&a->list[i], &b->list[j]);
+
+		if (r == 0 && diff_hash(a, &a->list[i]) == diff_hash(b, &b->list[j]))
+		{
+			same++;
+			i++;
+			j++;
+			continue;
+		}
+
+		if (r < 0)
+		{
+			pr_text("Handle 0x%04X, DMI type %d, %d bytes (removed)\n",
+				a->list[i].e->handle, a->list[i].e->type,
+				a->list[i].e->length);
+			diff_print(a, a->list[i++].e, '-');
+			removed++;
+		}
+		else if (r > 0)
+		{
+			pr_text("Handle 0x%04X, DMI type %d, %d bytes (added)\n",
+				b->list[j].e->handle, b->list[j].e->type,
+				b->list[j].e->length);
+			diff_print(b, b->list[j++].e, '+');
+			added++;
+		}
+		else
+		{
+			diff_changed(a, &a->list[i++], b, &b->list[j++]);
+			changed++;
+		}
+		pr_text("\n");
+	}
+
+	if (!(opt.flags & FLAG_QUIET))
+		pr_info("%u structures added, %u removed, %u changed, %u unchanged.",
+			added, removed, changed, same);
+	diff_changes = added + removed + changed;
+}
+
+/*
+ * Called for each of the two tables. The first one is kept aside while
+ * the second one is read, then they are compared.
+ */
+static void dmi_table_diff(const struct dmi_table *t, u32 count)
+{
+	struct diff_side side;
+	int found = 0;
+
+	if (diff_side_build(&side, t, count) < 0)
+	{
+		diff_side_free(&side);
+		return;
+	}
+
+	if (diff_base == NULL)
+	{
+		/*
+		 * The second table is read and decoded from here. It has its
+		 * own shadow copy, but the decoding state of the first table
+		 * must be restored afterwards.
+		 */
+		const struct dmi_table *ref = ref_table;
+		unsigned int flags = opt.flags;
+
+		diff_base = &side;
+		if (decode_dump(opt.diff, &found) != 0 || !found)
+		{
+			pr_sync();
+			fprintf(stderr, "%s: Failed to read DMI table\n", opt.diff);
+			diff_failed = 1;
+		}
+		diff_base = NULL;
+		ref_table = ref;
+		opt.flags = flags;
+	}
+	else
+		diff_tables(diff_base, &side);
+
+	diff_side_free(&side);
+}
+
+static int dmi_table_dump(const u8 *ep, u32 ep_len, const u8 *table,
+			  u32 table_len)
+{
+	int fd;
+	FILE *f;
+
+	pr_sync();
+	fd = open(opt.dumpfile, O_WRONLY|O_CREAT|O_EXCL, 0666);
+	if (fd == -1)
+	{
+		fprintf(stderr, "%s: ", opt.dumpfile);
+		perror("open");
+		return -1;
+	}
+
+	f = fdopen(fd, "wb");
+	if (!f)
+	{
+		fprintf(stderr, "%s: ", opt.dumpfile);
+		perror("fdopen");
+		return -1;
+	}
+
+	if (!(opt.flags & FLAG_QUIET))
+		pr_comment("Writing %d bytes to %s.", ep_len, opt.dumpfile);
+	pr_sync();
+	if (fwrite(ep, ep_len, 1, f) != 1)
+	{
+		fprintf(stderr, "%s: ", opt.dumpfile);
+		perror("fwrite");
+		goto err_close;
+	}
+
+	if (fseek(f, 32, SEEK_SET) != 0)
+	{
+		fprintf(stderr, "%s: ", opt.dumpfile);
+		perror("fseek");
+		goto err_close;
+	}
+
+	if (!(opt.flags & FLAG_QUIET))
+		pr_comment("Writing %d bytes to %s.", table_len, opt.dumpfile);
+	pr_sync();
+	if (fwrite(table, table_len, 1, f) != 1)
+	{
+		fprintf(stderr, "%s: ", opt.dumpfile);
+		perror("fwrite");
+		goto err_close;
+	}
+
+	if (fclose(f))
+	{
+		fprintf(stderr, "%s: ", opt.dumpfile);
+		perror("fclose");
+		return -1;
+	}
+
+	return 0;
+
+err_close:
 	fclose(f);
 	return -1;
 }
 
-static void dmi_table_decode(u8 *buf, u32 len, u16 num, u16 ver, u32 flags)
+/* Display the table as requested by the options */
+static void dmi_table_output(const struct dmi_table *t)
 {
-	u8 *data;
-	int i = 0;
-
-	/* First pass: Save specific values needed to decode OEM types */
-	data = buf;
-	while ((i < num || !num)
-	    && data + 4 <= buf + len) /* 4 is the length of an SMBIOS structure header */
-	{
-		u8 *next;
-		struct dmi_header h;
-
-		to_dmi_header(&h, data);
+	const struct dmi_index *idx = t->idx;
+	u32 len = t->len;
+	u16 num = t->num, ver = t->ver;
+	const struct dmi_index_entry *e;
+	struct dmi_header h;
+	u32 i, start, stop, count;
+	int display, truncated;
+	unsigned long long t0 = 0;
 
-		/*
-		 * If a short entry is found (less than 4 bytes), not only it
-		 * is invalid, but we cannot reliably locate the next entry.
-		 * Also stop at end-of-table marker if so instructed.
-		 */
-		if (h.length < 4 ||
-		    (h.type == 127 &&
-		     (opt.flags & (FLAG_QUIET | FLAG_STOP_AT_EOT))))
-			break;
-		i++;
+	ref_table = t;
 
-		/* Look for the next handle */
-		next = data + h.length;
-		while ((unsigned long)(next - buf + 1) < len
-		    && (next[0] != 0 || next[1] != 0))
-			next++;
-		next += 2;
+	/* In quiet mode, stop decoding at end of table marker */
+	count = idx->count;
+	if ((opt.flags & FLAG_QUIET) && (e = dmi_index_type(idx, 127)) != NULL)
+		count = e - idx->entry;
 
-		/* Make sure the whole structure fits in the table */
-		if ((unsigned long)(next - buf) > len)
-			break;
+	/* The truncated entry, if any, is always the last one */
+	truncated = (count == idx->count && (idx->status & DMI_INDEX_TRUNCATED));
+	if (truncated)
+		count--;
 
-		/* Assign vendor for vendor-specific decodes later */
-		if (h.type == 1 && h.length >= 6)
-			dmi_set_vendor(_dmi_string(&h, data[0x04], 0),
-				       _dmi_string(&h, data[0x05], 0));
+	dmi_table_vendor(t, count);
 
-		/* Remember CPUID type for HPE type 199 */
-		if (h.type == 4 && h.length >= 0x1A && cpuid_type == cpuid_none)
-			cpuid_type = dmi_get_cpuid_type(&h);
-		data = next;
+	start = 0;
+	stop = count;
+	if (opt.string_count)
+	{
+		dmi_table_strings(t, count);
+		stop = 0;
+	}
+	else if (opt.flags & FLAG_RESOLVE)
+	{
+		dmi_table_resolve(t, count);
+		stop = 0;
+	}
+	else if (opt.flags & FLAG_DUMP_ALL)
+	{
+		dmi_table_dump_all(t->buf, len);
+		stop = 0;
+	}
+	else if (opt.flags & FLAG_EVENT_LOG)
+	{
+		dmi_table_event_log(t, count);
+		stop = 0;
+	}
+	else if (opt.diff != NULL)
+	{
+		dmi_table_diff(t, count);
+		stop = 0;
+	}
+	else if (opt.handle != ~0U)
+	{
+		/* Jump straight to the requested handle */
+		e = dmi_index_handle(idx, opt.handle);
+		start = e != NULL ? (u32)(e - idx->entry) : count;
+		if (!(idx->status & DMI_INDEX_DUP_HANDLE) && start < count)
+			stop = start + 1;
 	}
 
-	/* Second pass: Actually decode the data */
-	i = 0;
-	data = buf;
-	while ((i < num || !num)
-	    && data + 4 <= buf + len) /* 4 is the length of an SMBIOS structure header */
+	for (i = start; i < stop; i++)
 	{
-		u8 *next;
-		struct dmi_header h;
-		int display;
+		e = &idx->entry[i];
+		if ((opt.type != NULL && !opt.type[e->type])
+		 || (opt.handle != ~0U && opt.handle != e->handle)
+		 || ((opt.flags & FLAG_QUIET) && e->type == 126))
+			continue;
+
+		if (opt.flags & FLAG_STATS)
+			t0 = dmi_stats_now();
+
+		DMI_PROBE4(structure_start, e->type, e->handle, e->length,
+			   e->offset);
+		entry_to_dmi_header(&h, t, e);
+		if (opt.query != NULL)
+			pr_select(opt.query + h.type * opt.query_words);
+		if (!(opt.flags & FLAG_QUIET) || (opt.flags & FLAG_DUMP))
+			pr_handle(&h);
 
-		to_dmi_header(&h, data);
-		display = ((opt.type == NULL || opt.type[h.type])
-			&& (opt.handle == ~0U || opt.handle == h.handle)
-			&& !((opt.flags & FLAG_QUIET) && (h.type == 126 || h.type == 127))
-			&& !opt.string);
+		/* Fixup a common mistake */
+		if (h.type == 34 && !(opt.flags & FLAG_NO_QUIRKS))
+			dmi_fixup_type_34(&h, 1);
 
-		/*
-		 * If a short entry is found (less than 4 bytes), not only it
-		 * is invalid, but we cannot reliably locate the next entry.
-		 * Better stop at this point, and let the user know his/her
-		 * table is broken.
-		 */
-		if (h.length < 4)
+		if (opt.flags & FLAG_DUMP)
 		{
-			if (!(opt.flags & FLAG_QUIET))
-			{
-				fprintf(stderr,
-					"Invalid entry length (%u). DMI table "
-					"is broken! Stop.\n\n",
-					(unsigned int)h.length);
-				opt.flags |= FLAG_QUIET;
-			}
-			break;
+			dmi_dump(&h);
+			pr_sep();
 		}
-		i++;
+		else
+			dmi_decode(&h, ver);
 
-		/* In quiet mode, stop decoding at end of table marker */
-		if ((opt.flags & FLAG_QUIET) && h.type == 127)
-			break;
+		if (opt.flags & FLAG_STATS)
+			dmi_stats_type(e->type, e->size, dmi_stats_now() - t0);
+		DMI_PROBE4(structure_done, e->type, e->handle, e->length,
+			   e->offset);
+	}
+	pr_select(NULL);
+
+	if (truncated)
+	{
+		e = &idx->entry[count];
+		display = ((opt.type == NULL || opt.type[e->type])
+			&& (opt.handle == ~0U || opt.handle == e->handle)
+			&& !((opt.flags & FLAG_QUIET) && (e->type == 126 || e->type == 127)));
 
+		entry_to_dmi_header(&h, t, e);
 		if (display
 		 && (!(opt.flags & FLAG_QUIET) || (opt.flags & FLAG_DUMP)))
 			pr_handle(&h);
+		if (display && !(opt.flags & FLAG_QUIET))
+			pr_struct_err("<TRUNCATED>");
+		pr_sep();
+	}
 
-		/* Look for the next handle */
-		next = data + h.length;
-		while ((unsigned long)(next - buf + 1) < len
-		    && (next[0] != 0 || next[1] != 0))
-			next++;
-		next += 2;
-
-		/* Make sure the whole structure fits in the table */
-		if ((unsigned long)(next - buf) > len)
-		{
-			if (display && !(opt.flags & FLAG_QUIET))
-				pr_struct_err("<TRUNCATED>");
-			pr_sep();
-			data = next;
-			break;
-		}
-
-		/* Fixup a common mistake */
-		if (h.type == 34 && !(opt.flags & FLAG_NO_QUIRKS))
-			dmi_fixup_type_34(&h, display);
-
-		if (display)
-		{
-			if (opt.flags & FLAG_DUMP)
-			{
-				dmi_dump(&h);
-				pr_sep();
-			}
-			else
-				dmi_decode(&h, ver);
-		}
-		else if (opt.string != NULL
-		      && opt.string->type == h.type)
-			dmi_table_string(&h, data, ver);
-
-		data = next;
+	/* What follows are error messages */
+	pr_sync();
 
-		/* SMBIOS v3 requires stopping at this marker */
-		if (h.type == 127 && (flags & FLAG_STOP_AT_EOT))
-			break;
+	/*
+	 * If a short entry is found (less than 4 bytes), not only it
+	 * is invalid, but we cannot reliably locate the next entry.
+	 * Better stop at this point, and let the user know his/her
+	 * table is broken.
+	 */
+	if ((idx->status & DMI_INDEX_BROKEN) && count == idx->count
+	 && !(opt.flags & FLAG_QUIET))
+	{
+		fprintf(stderr,
+			"Invalid entry length (%u). DMI table "
+			"is broken! Stop.\n\n",
+			(unsigned int)idx->broken_length);
+		opt.flags |= FLAG_QUIET;
 	}
 
 	/*
@@ -5799,23 +7662,81 @@ static void dmi_table_decode(u8 *buf, u32 len, u16 num, u16 ver, u32 flags)
 	 */
 	if (!(opt.flags & FLAG_QUIET))
 	{
-		if (num && i != num)
+		if (num && idx->count != num)
 			fprintf(stderr, "Wrong DMI structures count: %d announced, "
-				"only %d decoded.\n", num, i);
-		if ((unsigned long)(data - buf) > len
-		 || (num && (unsigned long)(data - buf) < len))
+				"only %u decoded.\n", num, idx->count);
+		if (idx->end > len || (num && idx->end < len))
 			fprintf(stderr, "Wrong DMI structures length: %u bytes "
 				"announced, structures occupy %lu bytes.\n",
-				len, (unsigned long)(data - buf));
+				len, (unsigned long)idx->end);
 	}
+
+	ref_table = NULL;
 }
 
-/* Allocates a buffer for the table, must be freed by the caller */
+#ifndef DMI_BATCH
+/* Answer a request of a --serve client */
+static void dmi_table_answer(void *data)
+{
+	dmi_reset_vendor();
+	dmi_table_output(data);
+}
+#endif
+
+static void dmi_table_decode(const u8 *buf, u32 len, u16 num, u16 ver,
+			     off_t base, const char *devmem, u32 flags)
+{
+	struct dmi_index *idx;
+	struct dmi_shadow shadow;
+	struct dmi_table t;
+
+	dmi_stats_phase(STATS_INDEX);
+	idx = dmi_index_build(buf, len, num,
+			      flags & FLAG_STOP_AT_EOT ? DMI_INDEX_STOP_AT_EOT : 0);
+	if (idx == NULL)
+		return;
+	shadow_init(&shadow, buf, len);
+	dmi_stats_phase(STATS_DECODE);
+
+	t.buf = buf;
+	t.len = len;
+	t.num = num;
+	t.ver = ver;
+	t.idx = idx;
+	t.shadow = &shadow;
+	t.base = base;
+	t.devmem = devmem;
+	t.flags = flags;
+#ifndef DMI_BATCH
+	if (opt.sockpath != NULL)
+		dmi_serve(opt.sockpath, dmi_table_answer, &t);
+	else
+#endif
+		dmi_table_output(&t);
+
+	shadow_free(&shadow);
+	dmi_index_free(idx);
+}
+
+/*
+ * Get the table. Dump files and image files are mapped read-only rather
+ * than copied, in which case *mapped is set. Either way the table must
+ * be released with dmi_table_put().
+ *
+ * With --serve and --follow, the table is used for as long as the
+ * process runs, and a file rewritten meanwhile would make accessing a
+ * mapping of it fail with SIGBUS, so it is always copied then.
+ */
 static u8 *dmi_table_get(off_t base, u32 *len, u16 num, u32 ver,
-			 const char *devmem, u32 flags)
+			 const char *devmem, u32 flags, int *mapped)
 {
+	int can_map = opt.sockpath == NULL && opt.interval == 0;
 	u8 *buf;
 
+	*mapped = 0;
+	dmi_stats_phase(STATS_TABLE_READ);
+	DMI_PROBE4(entry_point_found, ver, base, *len, num);
+
 	if (ver > SUPPORTED_SMBIOS_VER && !(opt.flags & FLAG_QUIET))
 	{
 		pr_comment("SMBIOS implementations newer than version %u.%u.%u are not",
@@ -5839,6 +7760,9 @@ static u8 *dmi_table_get(off_t base, u32 *len, u16 num, u32 ver,
 		pr_sep();
 	}
 
+	/* Reading the table may fail with error messages */
+	pr_sync();
+
 	if ((flags & FLAG_NO_FILE_OFFSET) || (opt.flags & FLAG_FROM_DUMP))
 	{
 		/*
@@ -5850,9 +7774,18 @@ static u8 *dmi_table_get(off_t base, u32 *len, u16 num, u32 ver,
 		 * parse error.
 		 */
 		size_t size = *len;
-		buf = read_file(flags & FLAG_NO_FILE_OFFSET ? 0 : base,
-			&size, devmem);
-		if (!(opt.flags & FLAG_QUIET) && num && size != (size_t)*len)
+
+		/* sysfs files can't be mapped */
+		buf = NULL;
+		if (!(flags & FLAG_NO_FILE_OFFSET) && can_map)
+			buf = map_file(base, &size, devmem);
+		if (buf != NULL)
+			*mapped = 1;
+		else
+			buf = read_file(flags & FLAG_NO_FILE_OFFSET ? 0 : base,
+				&size, devmem);
+		if (buf != NULL && !(opt.flags & FLAG_QUIET) && num
+		 && size != (size_t)*len)
 		{
 			fprintf(stderr, "Wrong DMI structures length: %u bytes "
 				"announced, only %lu bytes available.\n",
@@ -5861,7 +7794,26 @@ static u8 *dmi_table_get(off_t base, u32 *len, u16 num, u32 ver,
 		*len = size;
 	}
 	else
-		buf = mem_chunk(base, *len, devmem);
+	{
+		size_t size = *len;
+
+		/*
+		 * Image files can be used in place too, if mem_chunk() would
+		 * accept them. Anything else (such as /dev/mem) gets copied.
+		 */
+		buf = NULL;
+		if (geteuid() != 0 && can_map)
+			buf = map_file(base, &size, devmem);
+		if (buf != NULL && size != *len)
+		{
+			unmap_file(buf, size);
+			buf = NULL;
+		}
+		if (buf != NULL)
+			*mapped = 1;
+		else
+			buf = mem_chunk(base, *len, devmem);
+	}
 
 	if (buf == NULL)
 	{
@@ -5872,10 +7824,20 @@ static u8 *dmi_table_get(off_t base, u32 *len, u16 num, u32 ver,
 				"Try compiling dmidecode with -DUSE_MMAP.\n");
 #endif
 	}
+	else
+		dmi_stats_read(*len);
 
 	return buf;
 }
 
+static void dmi_table_put(u8 *buf, u32 len, int mapped)
+{
+	if (mapped)
+		unmap_file(buf, len);
+	else
+		free(buf);
+}
+
 
 /*
  * Build a crafted entry point with table address hard-coded to 32,
@@ -5910,11 +7872,14 @@ static int smbios3_decode(u8 *buf, size_t buf_len, const char *devmem, u32 flags
 {
 	u32 ver, len;
 	u64 offset;
+	off_t base;
 	u8 *table;
+	int mapped;
 
 	/* Don't let checksum run beyond the buffer */
 	if (buf[0x06] > buf_len)
 	{
+		pr_sync();
 		fprintf(stderr,
 			"Entry point length too large (%u bytes, expected %u).\n",
 			(unsigned int)buf[0x06], 0x18U);
@@ -5933,14 +7898,16 @@ static int smbios3_decode(u8 *buf, size_t buf_len, const char *devmem, u32 flags
 	offset = QWORD(buf + 0x10);
 	if (!(flags & FLAG_NO_FILE_OFFSET) && offset.h && sizeof(off_t) < 8)
 	{
+		pr_sync();
 		fprintf(stderr, "64-bit addresses not supported, sorry.\n");
 		return 0;
 	}
 
 	/* Maximum length, may get trimmed */
 	len = DWORD(buf + 0x0C);
-	table = dmi_table_get(((off_t)offset.h << 32) | offset.l, &len, 0, ver,
-			      devmem, flags | FLAG_STOP_AT_EOT);
+	base = ((off_t)offset.h << 32) | offset.l;
+	table = dmi_table_get(base, &len, 0, ver,
+			      devmem, flags | FLAG_STOP_AT_EOT, &mapped);
 	if (table == NULL)
 		return 1;
 
@@ -5955,11 +7922,11 @@ static int smbios3_decode(u8 *buf, size_t buf_len, const char *devmem, u32 flags
 	}
 	else
 	{
-		dmi_table_decode(table, len, 0, ver >> 8,
+		dmi_table_decode(table, len, 0, ver >> 8, base, devmem,
 				 flags | FLAG_STOP_AT_EOT);
 	}
 
-	free(table);
+	dmi_table_put(table, len, mapped);
 
 	return 1;
 }
@@ -5992,10 +7959,12 @@ static int smbios_decode(u8 *buf, size_t buf_len, const char *devmem, u32 flags)
 	u16 ver, num;
 	u32 len;
 	u8 *table;
+	int mapped;
 
 	/* Don't let checksum run beyond the buffer */
 	if (buf[0x05] > buf_len)
 	{
+		pr_sync();
 		fprintf(stderr,
 			"Entry point length too large (%u bytes, expected %u).\n",
 			(unsigned int)buf[0x05], 0x1FU);
@@ -6014,7 +7983,10 @@ static int smbios_decode(u8 *buf, size_t buf_len, const char *devmem, u32 flags)
 
 	ver = (buf[0x06] << 8) + buf[0x07];
 	if (!(opt.flags & FLAG_NO_QUIRKS))
+	{
+		pr_sync();
 		dmi_fixup_version(&ver);
+	}
 	if (!(opt.flags & FLAG_QUIET))
 		pr_info("SMBIOS %u.%u present.",
 			ver >> 8, ver & 0xFF);
@@ -6023,7 +7995,7 @@ static int smbios_decode(u8 *buf, size_t buf_len, const char *devmem, u32 flags)
 	len = WORD(buf + 0x16);
 	num = WORD(buf + 0x1C);
 	table = dmi_table_get(DWORD(buf + 0x18), &len, num, ver << 8,
-			      devmem, flags);
+			      devmem, flags, &mapped);
 	if (table == NULL)
 		return 1;
 
@@ -6038,10 +8010,11 @@ static int smbios_decode(u8 *buf, size_t buf_len, const char *devmem, u32 flags)
 	}
 	else
 	{
-		dmi_table_decode(table, len, num, ver, flags);
+		dmi_table_decode(table, len, num, ver, DWORD(buf + 0x18),
+				 devmem, flags);
 	}
 
-	free(table);
+	dmi_table_put(table, len, mapped);
 
 	return 1;
 }
@@ -6051,6 +8024,7 @@ static int legacy_decode(u8 *buf, const char *devmem, u32 flags)
 	u16 ver, num;
 	u32 len;
 	u8 *table;
+	int mapped;
 
 	if (!checksum(buf, 0x0F))
 		return 0;
@@ -6064,7 +8038,7 @@ static int legacy_decode(u8 *buf, const char *devmem, u32 flags)
 	len = WORD(buf + 0x06);
 	num = WORD(buf + 0x0C);
 	table = dmi_table_get(DWORD(buf + 0x08), &len, num, ver << 8,
-			      devmem, flags);
+			      devmem, flags, &mapped);
 	if (table == NULL)
 		return 1;
 
@@ -6079,14 +8053,235 @@ static int legacy_decode(u8 *buf, const char *devmem, u32 flags)
 	}
 	else
 	{
-		dmi_table_decode(table, len, num, ver, flags);
+		dmi_table_decode(table, len, num, ver, DWORD(buf + 0x08),
+				 devmem, flags);
 	}
 
-	free(table);
+	dmi_table_put(table, len, mapped);
 
 	return 1;
 }
 
+/*
+ * Decode the DMI data from a file previously written with --dump-bin.
+ * Returns -1 if the file can't be read, 1 on error, 0 otherwise.
+ */
+static int decode_dump(const char *filename, int *found)
+{
+	size_t size = 0x20;
+	u8 *buf;
+	int ret = 0;
+
+	if (!(opt.flags & FLAG_QUIET))
+		pr_info("Reading SMBIOS/DMI data from file %s.", filename);
+	pr_sync();
+	DMI_PROBE1(entry_point_search, "dump");
+	if ((buf = read_file(0, &size, filename)) == NULL)
+		return -1;
+	dmi_stats_read(size);
+
+	/* Truncated entry point can't be processed */
+	if (size < 0x20)
+	{
+		ret = 1;
+		goto out;
+	}
+
+	if (memcmp(buf, "_SM3_", 5) == 0)
+	{
+		if (smbios3_decode(buf, size, filename, 0))
+			(*found)++;
+	}
+	else if (memcmp(buf, "_SM_", 4) == 0)
+	{
+		if (smbios_decode(buf, size, filename, 0))
+			(*found)++;
+	}
+	else if (memcmp(buf, "_DMI_", 5) == 0)
+	{
+		if (legacy_decode(buf, filename, 0))
+			(*found)++;
+	}
+
+out:
+	free(buf);
+	return ret;
+}
+
+/*
+ * Decode one file in batch mode. Everything a previous table may have
+ * left behind is reset first, so that each file is decoded as if it was
+ * the only one. Returns 1 on error, 0 otherwise.
+ */
+int dmi_decode_file(const char *filename)
+{
+	unsigned int flags = opt.flags;
+	int found = 0;
+	int ret;
+
+	dmi_reset_vendor();
+	cpuid_type = cpuid_none;
+
+	ret = decode_dump(filename, &found);
+	if (ret == 0 && !found && !(opt.flags & FLAG_QUIET))
+		pr_comment("No SMBIOS nor DMI entry point found, sorry.");
+
+	/* Decoding a broken table turns quiet mode on */
+	opt.flags = flags;
+
+	return ret != 0;
+}
+
+static int dump_files_add(char ***files, int *count, const char *path)
+{
+	char **p;
+
+	if ((*count & 63) == 0)
+	{
+		p = realloc(*files, (*count + 64) * sizeof(char *));
+		if (p == NULL)
+		{
+			perror("realloc");
+			return -1;
+		}
+		*files = p;
+	}
+
+	if (((*files)[*count] = strdup(path)) == NULL)
+	{
+		perror("strdup");
+		return -1;
+	}
+	(*count)++;
+	return 0;
+}
+
+/*
+ * Read a list file, one path per line. Empty lines and lines starting
+ * with # are ignored. "-" stands for standard input.
+ */
+static int dump_files_list(char ***files, int *count, const char *listfile)
+{
+	FILE *f;
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	int ret = 0;
+
+	if (strcmp(listfile, "-") == 0)
+		f = stdin;
+	else if ((f = fopen(listfile, "r")) == NULL)
+	{
+		perror(listfile);
+		return -1;
+	}
+
+	while ((len = getline(&line, &size, f)) != -1)
+	{
+		if (len && line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (len == 0 || line[0] == '#')
+			continue;
+		if (dump_files_add(files, count, line) < 0)
+		{
+			ret = -1;
+			break;
+		}
+	}
+	if (ferror(f))
+	{
+		perror(listfile);
+		ret = -1;
+	}
+
+	free(line);
+	if (f != stdin)
+		fclose(f);
+	return ret;
+}
+
+static int dump_dir_filter(const struct dirent *d)
+{
+	return d->d_name[0] != '.';
+}
+
+/*
+ * List the regular files in a directory, in alphabetical order. Hidden
+ * files are ignored.
+ */
+static int dump_files_dir(char ***files, int *count, const char *dir)
+{
+	struct dirent **namelist;
+	struct stat st;
+	char *path;
+	int i, n;
+	int ret = 0;
+
+	n = scandir(dir, &namelist, dump_dir_filter, alphasort);
+	if (n < 0)
+	{
+		perror(dir);
+		return -1;
+	}
+
+	for (i = 0; i < n && ret == 0; i++)
+	{
+		path = malloc(strlen(dir) + strlen(namelist[i]->d_name) + 2);
+		if (path == NULL)
+		{
+			perror("malloc");
+			ret = -1;
+			break;
+		}
+		sprintf(path, "%s/%s", dir, namelist[i]->d_name);
+
+		if (stat(path, &st) == 0 && S_ISREG(st.st_mode))
+			ret = dump_files_add(files, count, path);
+
+		free(path);
+	}
+
+	for (i = 0; i < n; i++)
+		free(namelist[i]);
+	free(namelist);
+	return ret;
+}
+
+/*
+ * Return the number of files to decode in batch mode, as given by
+ * --from-dump-list or --from-dump-dir, and their paths in *files.
+ * Returns -1 on error.
+ */
+int dmi_dump_files(char ***files)
+{
+	int count = 0;
+	int ret;
+
+	*files = NULL;
+	if (opt.dumplist != NULL)
+		ret = dump_files_list(files, &count, opt.dumplist);
+	else
+		ret = dump_files_dir(files, &count, opt.dumpdir);
+
+	if (ret < 0)
+	{
+		dmi_dump_files_free(*files, count);
+		*files = NULL;
+		return -1;
+	}
+	return count;
+}
+
+void dmi_dump_files_free(char **files, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		free(files[i]);
+	free(files);
+}
+
+#ifndef DMI_BATCH
 /*
  * Probe for EFI interface
  */
@@ -6176,13 +8371,6 @@ int main(int argc, char * const argv[])
 	int efi;
 	u8 *buf = NULL;
 
-	/*
-	 * We don't want stdout and stderr to be mixed up if both are
-	 * redirected to the same file.
-	 */
-	setlinebuf(stdout);
-	setlinebuf(stderr);
-
 	if (sizeof(u8) != 1 || sizeof(u16) != 2 || sizeof(u32) != 4 || '\0' != 0)
 	{
 		fprintf(stderr, "%s: compiler incompatibility\n", argv[0]);
@@ -6193,6 +8381,8 @@ int main(int argc, char * const argv[])
 	opt.devmem = DEFAULT_MEM_DEV;
 	opt.flags = 0;
 	opt.handle = ~0U;
+	opt.format = PR_FORMAT_TEXT;
+	opt.sockmode = DEFAULT_SOCKET_MODE;
 
 	if (parse_command_line(argc, argv)<0)
 	{
@@ -6218,45 +8408,45 @@ int main(int argc, char * const argv[])
 		goto exit_free;
 	}
 
+	pr_init(opt.format);
+	if (opt.flags & FLAG_STATS)
+		dmi_stats_start();
+
 	if (!(opt.flags & FLAG_QUIET))
 		pr_comment("dmidecode %s", VERSION);
 
-	/* Read from dump if so instructed */
-	size = 0x20;
+	/* Read from dump(s) if so instructed */
 	if (opt.flags & FLAG_FROM_DUMP)
 	{
-		if (!(opt.flags & FLAG_QUIET))
-			pr_info("Reading SMBIOS/DMI data from file %s.",
-				opt.dumpfile);
-		if ((buf = read_file(0, &size, opt.dumpfile)) == NULL)
-		{
-			ret = 1;
-			goto exit_free;
-		}
-
-		/* Truncated entry point can't be processed */
-		if (size < 0x20)
+		if (opt.dumplist != NULL || opt.dumpdir != NULL)
 		{
-			ret = 1;
-			goto done;
-		}
+			char **files;
+			int i, count;
 
-		if (memcmp(buf, "_SM3_", 5) == 0)
-		{
-			if (smbios3_decode(buf, size, opt.dumpfile, 0))
-				found++;
-		}
-		else if (memcmp(buf, "_SM_", 4) == 0)
-		{
-			if (smbios_decode(buf, size, opt.dumpfile, 0))
-				found++;
+			count = dmi_dump_files(&files);
+			if (count < 0)
+			{
+				ret = 1;
+				goto exit_free;
+			}
+			for (i = 0; i < count; i++)
+			{
+				pr_file(files[i]);
+				ret |= dmi_decode_file(files[i]);
+			}
+			dmi_dump_files_free(files, count);
 		}
-		else if (memcmp(buf, "_DMI_", 5) == 0)
+		else
 		{
-			if (legacy_decode(buf, opt.dumpfile, 0))
-				found++;
+			ret = decode_dump(opt.dumpfile, &found);
+			if (ret < 0)
+			{
+				ret = opt.diff != NULL ? 2 : 1;
+				goto exit_free;
+			}
+			goto done;
 		}
-		goto done;
+		goto exit_free;
 	}
 
 	/*
@@ -6264,9 +8454,14 @@ int main(int argc, char * const argv[])
 	 * contain one of several types of entry points, so read enough for
 	 * the largest one, then determine what type it contains.
 	 */
+	size = 0x20;
+	pr_sync();
+	if (!(opt.flags & FLAG_NO_SYSFS))
+		DMI_PROBE1(entry_point_search, "sysfs");
 	if (!(opt.flags & FLAG_NO_SYSFS)
 	 && (buf = read_file(0, &size, SYS_ENTRY_FILE)) != NULL)
 	{
+		dmi_stats_read(size);
 		if (!(opt.flags & FLAG_QUIET))
 			pr_info("Getting SMBIOS data from sysfs.");
 		if (size >= 24 && memcmp(buf, "_SM3_", 5) == 0)
@@ -6292,6 +8487,8 @@ int main(int argc, char * const argv[])
 	}
 
 	/* Next try EFI (ia64, Intel-based Mac, arm64) */
+	pr_sync();
+	DMI_PROBE1(entry_point_search, "efi");
 	efi = address_from_efi(&fp);
 	switch (efi)
 	{
@@ -6305,11 +8502,13 @@ int main(int argc, char * const argv[])
 	if (!(opt.flags & FLAG_QUIET))
 		pr_info("Found SMBIOS entry point in EFI, reading table from %s.",
 			opt.devmem);
+	pr_sync();
 	if ((buf = mem_chunk(fp, 0x20, opt.devmem)) == NULL)
 	{
 		ret = 1;
 		goto exit_free;
 	}
+	dmi_stats_read(0x20);
 
 	if (memcmp(buf, "_SM3_", 5) == 0)
 	{
@@ -6328,11 +8527,14 @@ int main(int argc, char * const argv[])
 	if (!(opt.flags & FLAG_QUIET))
 		pr_info("Scanning %s for entry point.", opt.devmem);
 	/* Fallback to memory scan (x86, x86_64) */
+	pr_sync();
+	DMI_PROBE1(entry_point_search, "memory");
 	if ((buf = mem_chunk(0xF0000, 0x10000, opt.devmem)) == NULL)
 	{
 		ret = 1;
 		goto exit_free;
 	}
+	dmi_stats_read(0x10000);
 
 	/* Look for a 64-bit entry point first */
 	for (fp = 0; fp <= 0xFFE0; fp += 16)
@@ -6373,9 +8575,19 @@ int main(int argc, char * const argv[])
 	if (!found && !(opt.flags & FLAG_QUIET))
 		pr_comment("No SMBIOS nor DMI entry point found, sorry.");
 
+	/* Like diff(1), tell whether the tables differ, 2 on trouble */
+	if (opt.diff != NULL && ret == 0)
+		ret = diff_failed || !found ? 2 : diff_changes != 0;
+
 	free(buf);
 exit_free:
+	dmi_stats_phase(STATS_OUTPUT);
+	pr_end();
+	dmi_stats_print(opt.stats, dmi_smbios_structure_type);
 	free(opt.type);
+	free(opt.string);
+	free(opt.query);
 
 	return ret;
 }
+#endif
@@ -21,16 +21,24 @@
 #ifndef DMIDECODE_H
 #define DMIDECODE_H
 
+#include "config.h"
 #include "types.h"
 
 #define out_of_spec "<OUT OF SPEC>"
 
+struct dmi_index;
+struct dmi_index_entry;
+struct dmi_shadow;
+
 struct dmi_header
 {
 	u8 type;
 	u8 length;
 	u16 handle;
-	u8 *data;
+	const u8 *data;
+	const struct dmi_index *index;		/* NULL if not indexed */
+	const struct dmi_index_entry *entry;
+	struct dmi_shadow *shadow;		/* Filtered strings */
 };
 
 enum cpuid_type
@@ -45,12 +53,18 @@ enum cpuid_type
 	cpuid_loongarch,
 };
 
-extern enum cpuid_type cpuid_type;
+extern DMI_THREAD enum cpuid_type cpuid_type;
 
 int is_printable(const u8 *data, int len);
 const char *dmi_string(const struct dmi_header *dm, u8 s);
 void dmi_print_memory_size(const char *addr, u64 code, int shift);
 void dmi_print_cpuid(void (*print_cb)(const char *name, const char *format, ...),
 		     const char *label, enum cpuid_type sig, const u8 *p);
+const char *dmi_handle_ref(u16 handle);
+
+/* Batch mode (--from-dump-list, --from-dump-dir) */
+int dmi_dump_files(char ***files);
+void dmi_dump_files_free(char **files, int count);
+int dmi_decode_file(const char *filename);
 
 #endif
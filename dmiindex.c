@@ -0,0 +1,296 @@
+/*
+ * SMBIOS structure index
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * The index is built in a single walk of the table. It records where
+ * each structure starts, how long it is and where its strings are, so
+ * that callers never need to scan the raw table again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "util.h"
+#include "dmiindexpriv.h"
+
+static u32 dmi_index_hash_slot(const struct dmi_index *idx, u16 handle)
+{
+	return (handle * 40503U) & (idx->hash_size - 1);
+}
+
+static int dmi_index_grow(void **p, u32 *size, size_t elem)
+{
+	u32 new_size = *size ? *size * 2 : 64;
+	void *q;
+
+	q = realloc(*p, new_size * elem);
+	if (q == NULL)
+	{
+		perror("realloc");
+		return -1;
+	}
+
+	*p = q;
+	*size = new_size;
+	return 0;
+}
+
+static int dmi_index_hash_init(struct dmi_index *idx)
+{
+	u32 i;
+
+	idx->hash_size = 16;
+	while (idx->hash_size < 2 * idx->count)
+		idx->hash_size <<= 1;
+
+	idx->hash = malloc(idx->hash_size * sizeof(u32));
+	if (idx->hash == NULL)
+	{
+		perror("malloc");
+		return -1;
+	}
+	for (i = 0; i < idx->hash_size; i++)
+		idx->hash[i] = DMI_INDEX_NONE;
+
+	/* First occurrence of a handle wins, later ones are flagged */
+	for (i = 0; i < idx->count; i++)
+	{
+		struct dmi_index_entry *e = &idx->entry[i];
+		u32 slot = dmi_index_hash_slot(idx, e->handle);
+
+		while (idx->hash[slot] != DMI_INDEX_NONE)
+		{
+			if (idx->entry[idx->hash[slot]].handle == e->handle)
+				break;
+			slot = (slot + 1) & (idx->hash_size - 1);
+		}
+
+		if (idx->hash[slot] == DMI_INDEX_NONE)
+			idx->hash[slot] = i;
+		else
+		{
+			e->flags |= DMI_ENTRY_DUP_HANDLE;
+			idx->status |= DMI_INDEX_DUP_HANDLE;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Walk the table once and build the index. The walk follows the same
+ * rules as the decoder: stop at the first entry shorter than a header
+ * (the next one can't be located), at the end of the buffer, after num
+ * structures if num is set, and at the end-of-table marker if so
+ * instructed. An entry which runs past the end of the buffer is kept
+ * but flagged as truncated.
+ *
+ * Returns NULL on memory allocation failure.
+ */
+struct dmi_index *dmi_index_build(const u8 *table, u32 len, u16 num,
+				  unsigned int flags)
+{
+	struct dmi_index *idx;
+	u32 entry_size = 0, string_size = 0;
+	u32 off = 0, i;
+
+	idx = calloc(1, sizeof(struct dmi_index));
+	if (idx == NULL)
+	{
+		perror("calloc");
+		return NULL;
+	}
+	idx->table = table;
+	idx->len = len;
+	for (i = 0; i < 256; i++)
+		idx->first[i] = DMI_INDEX_NONE;
+
+	/* 4 is the length of an SMBIOS structure header */
+	while ((idx->count < num || !num) && off + 4 <= len)
+	{
+		struct dmi_index_entry *e;
+		u32 next, s;
+
+		if (table[off + 1] < 4)
+		{
+			idx->status |= DMI_INDEX_BROKEN;
+			idx->broken_length = table[off + 1];
+			break;
+		}
+
+		/*
+		 * Look for the next handle. If there is no string set
+		 * terminator, stop one byte before the end of the table, so
+		 * that the entry is seen as truncated below.
+		 */
+		next = off + table[off + 1];
+		if (next < len)
+		{
+			s = find_double_nul(table + next, len - next);
+			next += s < len - next ? s : len - next - 1;
+		}
+		next += 2;
+
+		if (idx->count == entry_size
+		 && dmi_index_grow((void **)&idx->entry, &entry_size,
+				   sizeof(struct dmi_index_entry)))
+			goto err_free;
+
+		e = &idx->entry[idx->count++];
+		e->type = table[off];
+		e->length = table[off + 1];
+		e->handle = WORD(table + off + 2);
+		e->offset = off;
+		e->string = idx->string_count;
+		e->string_count = 0;
+		e->flags = 0;
+		e->next = DMI_INDEX_NONE;
+
+		/* Make sure the whole structure fits in the table */
+		if (next > len)
+		{
+			e->size = len - off;
+			e->flags |= DMI_ENTRY_TRUNCATED;
+			idx->status |= DMI_INDEX_TRUNCATED;
+			off = next;
+			break;
+		}
+		e->size = next - off;
+
+		/*
+		 * The string set ends with the first empty string. Only the
+		 * first 255 strings can be referenced.
+		 */
+		s = off + e->length;
+		while (s < next - 2 && table[s] != 0 && e->string_count < 255)
+		{
+			if (idx->string_count == string_size
+			 && dmi_index_grow((void **)&idx->string, &string_size,
+					   sizeof(u32)))
+				goto err_free;
+
+			idx->string[idx->string_count++] = s;
+			e->string_count++;
+			s += strlen((const char *)table + s) + 1;
+		}
+
+		off = next;
+
+		if (e->type == 127 && (flags & DMI_INDEX_STOP_AT_EOT))
+			break;
+	}
+	idx->end = off;
+
+	/* Chain entries of the same type, in table order */
+	for (i = idx->count; i-- > 0; )
+	{
+		idx->entry[i].next = idx->first[idx->entry[i].type];
+		idx->first[idx->entry[i].type] = i;
+	}
+
+	if (dmi_index_hash_init(idx))
+		goto err_free;
+
+	return idx;
+
+err_free:
+	dmi_index_free(idx);
+	return NULL;
+}
+
+void dmi_index_free(struct dmi_index *idx)
+{
+	if (idx == NULL)
+		return;
+
+	free(idx->entry);
+	free(idx->string);
+	free(idx->hash);
+	free(idx);
+}
+
+/* Number of structures in the index */
+u32 dmi_index_count(const struct dmi_index *idx)
+{
+	return idx->count;
+}
+
+/* DMI_INDEX_* flags of the table */
+u32 dmi_index_status(const struct dmi_index *idx)
+{
+	return idx->status;
+}
+
+/* Returns structure number i, in table order, or NULL */
+const struct dmi_index_entry *dmi_index_entry(const struct dmi_index *idx,
+					      u32 i)
+{
+	if (i >= idx->count)
+		return NULL;
+	return &idx->entry[i];
+}
+
+/* Returns the first structure with the given handle, or NULL */
+const struct dmi_index_entry *dmi_index_handle(const struct dmi_index *idx,
+					       u16 handle)
+{
+	u32 slot = dmi_index_hash_slot(idx, handle);
+
+	while (idx->hash[slot] != DMI_INDEX_NONE)
+	{
+		if (idx->entry[idx->hash[slot]].handle == handle)
+			return &idx->entry[idx->hash[slot]];
+		slot = (slot + 1) & (idx->hash_size - 1);
+	}
+
+	return NULL;
+}
+
+/* Returns the first structure of the given type, or NULL */
+const struct dmi_index_entry *dmi_index_type(const struct dmi_index *idx,
+					     u8 type)
+{
+	if (idx->first[type] == DMI_INDEX_NONE)
+		return NULL;
+	return &idx->entry[idx->first[type]];
+}
+
+/* Returns the next structure of the same type, or NULL */
+const struct dmi_index_entry *dmi_index_next(const struct dmi_index *idx,
+					     const struct dmi_index_entry *e)
+{
+	if (e->next == DMI_INDEX_NONE)
+		return NULL;
+	return &idx->entry[e->next];
+}
+
+/*
+ * Returns string number s (starting at 1) of the given structure, or
+ * NULL if there is no such string. The string is returned as found in
+ * the table, without any filtering.
+ */
+const char *dmi_index_string(const struct dmi_index *idx,
+			     const struct dmi_index_entry *e, u8 s)
+{
+	if (s == 0 || s > e->string_count)
+		return NULL;
+	return (const char *)idx->table + idx->string[e->string + s - 1];
+}
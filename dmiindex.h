@@ -0,0 +1,85 @@
+/*
+ * SMBIOS structure index
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ */
+
+#ifndef DMIINDEX_H
+#define DMIINDEX_H
+
+#include "types.h"
+
+#define DMI_INDEX_NONE          0xFFFFFFFFU
+
+/* Flags for dmi_index_build() */
+#define DMI_INDEX_STOP_AT_EOT   (1 << 0)
+
+/* Table status, as found by dmi_index_build() */
+#define DMI_INDEX_BROKEN        (1 << 0)
+#define DMI_INDEX_TRUNCATED     (1 << 1)
+#define DMI_INDEX_DUP_HANDLE    (1 << 2)
+
+/* Entry flags */
+#define DMI_ENTRY_TRUNCATED     (1 << 0)
+#define DMI_ENTRY_DUP_HANDLE    (1 << 1)
+
+/*
+ * One record per structure. All offsets are relative to the start of
+ * the table, so the index stays valid if the table is moved around.
+ */
+struct dmi_index_entry
+{
+	u8 type;
+	u8 length;		/* Formatted area only */
+	u16 handle;
+	u32 offset;		/* Start of the structure */
+	u32 size;		/* Formatted area and string set */
+	u32 string;		/* First slot in the string offset array */
+	u8 string_count;
+	u8 flags;
+	u32 next;		/* Next entry of the same type */
+};
+
+/* Only libdmidecode itself knows what is in an index */
+struct dmi_index;
+
+/* Functions of the shared library, the rest of it is hidden */
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define DMI_EXPORT __attribute__ ((visibility ("default")))
+#else
+#define DMI_EXPORT
+#endif
+
+DMI_EXPORT struct dmi_index *dmi_index_build(const u8 *table, u32 len, u16 num,
+					     unsigned int flags);
+DMI_EXPORT void dmi_index_free(struct dmi_index *idx);
+
+DMI_EXPORT u32 dmi_index_count(const struct dmi_index *idx);
+DMI_EXPORT u32 dmi_index_status(const struct dmi_index *idx);
+DMI_EXPORT const struct dmi_index_entry *dmi_index_entry(const struct dmi_index *idx,
+							 u32 i);
+DMI_EXPORT const struct dmi_index_entry *dmi_index_handle(const struct dmi_index *idx,
+							  u16 handle);
+DMI_EXPORT const struct dmi_index_entry *dmi_index_type(const struct dmi_index *idx,
+							u8 type);
+DMI_EXPORT const struct dmi_index_entry *dmi_index_next(const struct dmi_index *idx,
+							const struct dmi_index_entry *e);
+DMI_EXPORT const char *dmi_index_string(const struct dmi_index *idx,
+					const struct dmi_index_entry *e, u8 s);
+
+#endif
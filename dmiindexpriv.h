@@ -0,0 +1,47 @@
+/*
+ * SMBIOS structure index, internals
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * The layout of an index is not part of the library interface, only
+ * dmidecode itself is built against it. It is not installed.
+ */
+
+#ifndef DMIINDEXPRIV_H
+#define DMIINDEXPRIV_H
+
+#include "types.h"
+#include "dmiindex.h"
+
+struct dmi_index
+{
+	const u8 *table;
+	u32 len;		/* Table length */
+	u32 end;		/* Where the table walk stopped */
+	u32 status;
+	u8 broken_length;	/* Length of the invalid entry, if any */
+	u32 count;		/* Number of entries */
+	u32 string_count;	/* Size of the string offset array */
+	u32 hash_size;		/* Always a power of 2 */
+	u32 first[256];		/* First entry of each type */
+	struct dmi_index_entry *entry;
+	u32 *string;
+	u32 *hash;
+};
+
+#endif
@@ -23,12 +23,14 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "config.h"
 #include "types.h"
 #include "util.h"
 #include "dmidecode.h"
 #include "dmioem.h"
 #include "dmiopt.h"
 #include "dmioutput.h"
+#include "probes.h"
 
 /*
  * Globals for vendor-specific decodes
@@ -45,8 +47,9 @@ enum DMI_VENDORS
 	VENDOR_LENOVO,
 };
 
-static enum DMI_VENDORS dmi_vendor = VENDOR_UNKNOWN;
-static const char *dmi_product = NULL;
+static DMI_THREAD enum DMI_VENDORS dmi_vendor = VENDOR_UNKNOWN;
+static DMI_THREAD const char *dmi_product = NULL;
+static DMI_THREAD u8 nic_ctr;
 
 /*
  * Remember the system vendor for later use. We only actually store the
@@ -90,13 +93,23 @@ void dmi_set_vendor(const char *v, const char *p)
 	dmi_product = p;
 }
 
+/*
+ * Forget the system vendor, before decoding another table.
+ */
+void dmi_reset_vendor(void)
+{
+	dmi_vendor = VENDOR_UNKNOWN;
+	dmi_product = NULL;
+	nic_ctr = 0;
+}
+
 /*
  * Acer-specific data structures are decoded here.
  */
 
 static int dmi_decode_acer(const struct dmi_header *h)
 {
-	u8 *data = h->data;
+	const u8 *data = h->data;
 	u16 cap;
 
 	switch (h->type)
@@ -147,7 +160,7 @@ static void dmi_dell_bios_flags(u64 flags)
 static void dmi_dell_hotkeys(const struct dmi_header *h)
 {
 	int count = (h->length - 0x04) / 0x04;
-	u8 *hotkey = h->data + 0x04;
+	const u8 *hotkey = h->data + 0x04;
 
 	if (!count)
 		return;
@@ -172,8 +185,8 @@ static void dmi_dell_indexed_io_access(const struct dmi_header *h)
 	};
 	int tokens = (h->length - 0x0C) / 0x05;
 	const char *str = out_of_spec;
-	u8 *data = h->data;
-	u8 *token;
+	const u8 *data = h->data;
+	const u8 *token;
 	u8 type;
 
 	pr_attr("Index Port", "0x%04hx", WORD(data + 0x04));
@@ -207,8 +220,8 @@ static void dmi_dell_indexed_io_access(const struct dmi_header *h)
 static void dmi_dell_token_interface(const struct dmi_header *h)
 {
 	int tokens = (h->length - 0x0B) / 0x06;
-	u8 *data = h->data;
-	u8 *token;
+	const u8 *data = h->data;
+	const u8 *token;
 
 	pr_attr("Command I/O Address", "0x%04x", WORD(data + 0x04));
 	pr_attr("Command I/O Code", "0x%02x", data[0x06]);
@@ -233,7 +246,7 @@ static void dmi_dell_token_interface(const struct dmi_header *h)
 
 static int dmi_decode_dell(const struct dmi_header *h)
 {
-	u8 *data = h->data;
+	const u8 *data = h->data;
 
 	switch (h->type)
 	{
@@ -280,7 +293,6 @@ static void dmi_print_hp_net_iface_rec(u8 id, u8 bus, u8 dev, const u8 *mac)
 	 * using 0xFF marker is not future proof. 256 NICs is a lot, but
 	 * 640K ought to be enough for anybody(said no one, ever).
 	 * */
-	static u8 nic_ctr;
 	char attr[8];
 
 	if (id == 0xFF)
@@ -352,7 +364,7 @@ static void dmi_hp_203_assoc_hndl(const char *fname, u16 num)
 	if (num == 0xFFFE)
 		pr_attr(fname, "N/A");
 	else
-		pr_attr(fname, "0x%04X", num);
+		pr_attr(fname, "0x%04X%s", num, dmi_handle_ref(num));
 }
 
 static void dmi_hp_203_pciinfo(const char *fname, u16 num)
@@ -519,7 +531,7 @@ static void dmi_hp_216_fw_type(u16 code)
 	pr_attr("Firmware Type", "%s", str);
 }
 
-static void dmi_hp_216_version(u8 format, u8 *data)
+static void dmi_hp_216_version(u8 format, const u8 *data)
 {
 	const char * const name = "Version Data";
 	const char * const reserved = "Reserved";
@@ -930,7 +942,7 @@ static void dmi_hp_242_speed(const char *attr, u16 speed)
 static void dmi_hp_245_pcie_riser(const struct dmi_header *h)
 {
 	const char *str = "Reserved";
-	u8 *data = h->data;
+	const u8 *data = h->data;
 
 	pr_attr("Board Type", "PCIe Riser");
 	if (h->length < 0x09) return;
@@ -954,7 +966,7 @@ static void dmi_hp_245_pcie_riser(const struct dmi_header *h)
 
 static int dmi_decode_hp(const struct dmi_header *h)
 {
-	u8 *data = h->data;
+	const u8 *data = h->data;
 	int nic, ptr;
 	u32 feat;
 	const char *company = (dmi_vendor == VENDOR_HP) ? "HP" : "HPE";
@@ -1024,7 +1036,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			pr_handle_name("%s Processor Specific Information", company);
 			if (h->length < 0x0A) break;
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x04));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x04),
+					dmi_handle_ref(WORD(data + 0x04)));
 			pr_attr("APIC ID", "%u", data[0x06]);
 			feat = data[0x07];
 			pr_attr("BSP", "%s", feat & 0x01 ? "Yes" : "No");
@@ -1157,8 +1170,9 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			if (!(opt.flags & FLAG_QUIET))
 			{
 				if (WORD(data + 0x14) & 1)
-					pr_attr("Associated Real/Phys Handle", "0x%04X",
-						WORD(data + 0x20));
+					pr_attr("Associated Real/Phys Handle", "0x%04X%s",
+						WORD(data + 0x20),
+						dmi_handle_ref(WORD(data + 0x20)));
 				else
 					pr_attr("Associated Real/Phys Handle", "N/A");
 			}
@@ -1340,7 +1354,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			dmi_hp_224_module_type(data[0x06]);
 			dmi_hp_224_module_attr(data[0x07]);
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x8));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x8),
+					dmi_handle_ref(WORD(data + 0x8)));
 			if (h->length < 0x0c) break;
 			dmi_hp_224_chipid(WORD(data + 0x0a));
 			break;
@@ -1367,7 +1382,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			pr_handle_name("%s Power Supply Information", company);
 			if (h->length < 0x0B) break;
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x4));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x4),
+					dmi_handle_ref(WORD(data + 0x4)));
 			pr_attr("Manufacturer", "%s", dmi_string(h, data[0x06]));
 			pr_attr("Revision", "%s", dmi_string(h, data[0x07]));
 			dmi_hp_230_method_bus_seg_addr(data[0x08], data[0x09], data[0x0A]);
@@ -1461,7 +1477,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			pr_handle_name("%s DIMM Vendor Information", company);
 			if (h->length < 0x08) break;
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x4));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x4),
+					dmi_handle_ref(WORD(data + 0x4)));
 			pr_attr("DIMM Manufacturer", "%s", dmi_string(h, data[0x06]));
 			pr_attr("DIMM Manufacturer Part Number", "%s", dmi_string(h, data[0x07]));
 			if (h->length < 0x09) break;
@@ -1495,7 +1512,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			pr_handle_name("%s Proliant USB Port Connector Correlation Record", company);
 			if (h->length < 0x0F) break;
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x4));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x4),
+					dmi_handle_ref(WORD(data + 0x4)));
 			if (h->length < 0x11)
 				pr_attr("PCI Device", "%02x:%02x.%x", data[0x6],
 					data[0x7] >> 3, data[0x7] & 0x7);
@@ -1549,7 +1567,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			pr_handle_name("%s USB Device Correlation Record", company);
 			if (h->length < 0x17) break;
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x04));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x04),
+					dmi_handle_ref(WORD(data + 0x04)));
 			pr_attr("USB Vendor ID", "0x%04x", WORD(data + 0x06));
 			pr_attr("Embedded SD Card", "%s", data[0x08] & 0x01 ? "Present" : "Empty");
 			dmi_hp_239_usb_device(data[0x0A], data[0x0B], data[0x0C]);
@@ -1587,7 +1606,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			pr_handle_name("%s Proliant Inventory Record", company);
 			if (h->length < 0x27) break;
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x4));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x4),
+					dmi_handle_ref(WORD(data + 0x4)));
 			pr_attr("Package Version", "0x%08X", DWORD(data + 0x6));
 			pr_attr("Version String", "%s", dmi_string(h, data[0x0A]));
 
@@ -1644,7 +1664,8 @@ static int dmi_decode_hp(const struct dmi_header *h)
 			pr_handle_name("%s ProLiant Hard Drive Inventory Record", company);
 			if (h->length < 0x2C) break;
 			if (!(opt.flags & FLAG_QUIET))
-				pr_attr("Associated Handle", "0x%04X", WORD(data + 0x4));
+				pr_attr("Associated Handle", "0x%04X%s", WORD(data + 0x4),
+					dmi_handle_ref(WORD(data + 0x4)));
 			dmi_hp_242_hdd_type(data[0x06]);
 			pr_attr("ID", "%llx", QWORD(data + 0x07));
 			if (h->length < 0x3E)
@@ -1722,7 +1743,7 @@ static int dmi_decode_hp(const struct dmi_header *h)
 
 static int dmi_decode_ibm_lenovo(const struct dmi_header *h)
 {
-	u8 *data = h->data;
+	const u8 *data = h->data;
 
 	switch (h->type)
 	{
@@ -1844,19 +1865,99 @@ static int dmi_decode_ibm_lenovo(const struct dmi_header *h)
  */
 int dmi_decode_oem(const struct dmi_header *h)
 {
+	int ret;
+
 	switch (dmi_vendor)
 	{
 		case VENDOR_HP:
 		case VENDOR_HPE:
-			return dmi_decode_hp(h);
+			ret = dmi_decode_hp(h);
+			break;
 		case VENDOR_ACER:
-			return dmi_decode_acer(h);
+			ret = dmi_decode_acer(h);
+			break;
 		case VENDOR_DELL:
-			return dmi_decode_dell(h);
+			ret = dmi_decode_dell(h);
+			break;
 		case VENDOR_IBM:
 		case VENDOR_LENOVO:
-			return dmi_decode_ibm_lenovo(h);
+			ret = dmi_decode_ibm_lenovo(h);
+			break;
 		default:
-			return 0;
+			ret = 0;
+	}
+
+	DMI_PROBE4(oem_decode, h->type, h->handle, dmi_vendor, ret);
+	return ret;
+}
+
+/*
+ * Offsets of the references to other structures in an OEM-specific
+ * entry, as displayed by the decoders above, for --diff. Returns their
+ * number, at most max.
+ */
+static int dmi_oem_ref_add(const struct dmi_header *h, u8 *off, int n,
+			   int max, unsigned int offset)
+{
+	if (offset + 2 <= h->length && n < max)
+		off[n++] = offset;
+	return n;
+}
+
+int dmi_oem_handle_refs(const struct dmi_header *h, u8 *off, int max)
+{
+	const u8 *data = h->data;
+	int gen, n = 0;
+
+	if (dmi_vendor != VENDOR_HP && dmi_vendor != VENDOR_HPE)
+		return 0;
+	gen = dmi_hpegen(dmi_product);
+	if (gen < 0)
+		return 0;
+
+	switch (h->type)
+	{
+		case 197:
+			if (h->length < 0x0A) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			break;
+		case 203:
+			if (gen < G9 || h->length < 0x1F) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			n = dmi_oem_ref_add(h, off, n, max, 0x06);
+			n = dmi_oem_ref_add(h, off, n, max, 0x12);
+			if (h->length < 0x22 || !(WORD(data + 0x14) & 1)) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x20);
+			break;
+		case 224:
+			if (h->length < 0x0A) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x08);
+			break;
+		case 230:
+			if (h->length < 0x0B) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			break;
+		case 237:
+			if (gen < G9 || h->length < 0x08) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			break;
+		case 238:
+			if (gen < G9 || h->length < 0x0F) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			break;
+		case 239:
+			if (gen < G9 || h->length < 0x17) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			break;
+		case 240:
+			if (h->length < 0x27) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			break;
+		case 242:
+			if (gen < G10 || h->length < 0x2C) break;
+			n = dmi_oem_ref_add(h, off, n, max, 0x04);
+			break;
 	}
+
+	return n;
 }
@@ -22,4 +22,6 @@
 struct dmi_header;
 
 void dmi_set_vendor(const char *s, const char *p);
+void dmi_reset_vendor(void);
 int dmi_decode_oem(const struct dmi_header *h);
+int dmi_oem_handle_refs(const struct dmi_header *h, u8 *off, int max);
@@ -30,10 +30,12 @@
 #include "util.h"
 #include "dmidecode.h"
 #include "dmiopt.h"
+#include "dmioutput.h"
+#include "dmistats.h"
 
 
 /* Options are global */
-struct opt opt;
+DMI_THREAD struct opt opt;
 
 
 /*
@@ -176,9 +178,25 @@ static const struct string_keyword opt_string_keyword[] = {
 	{ "processor-frequency", 4, 0x16 },     /* dmi_processor_frequency() */
 };
 
-/* This is a template, 3rd field is set at runtime. */
-static struct string_keyword opt_oem_string_keyword =
-	{ NULL, 11, 0x00 };
+/*
+ * Keywords of types which usually have several instances, these are
+ * displayed in handle order (the above are in table order, as they
+ * always were).
+ */
+static const struct string_keyword opt_string_instance_keyword[] = {
+	{ "processor-socket-designation", 4, 0x04 },
+	{ "processor-serial-number", 4, 0x20 },
+	{ "processor-asset-tag", 4, 0x21 },
+	{ "processor-part-number", 4, 0x22 },
+	{ "cache-socket-designation", 7, 0x04 },
+	{ "slot-designation", 9, 0x04 },
+	{ "memory-device-locator", 17, 0x10 },
+	{ "memory-device-bank-locator", 17, 0x11 },
+	{ "memory-device-manufacturer", 17, 0x17 },
+	{ "memory-device-serial-number", 17, 0x18 },
+	{ "memory-device-asset-tag", 17, 0x19 },
+	{ "memory-device-part-number", 17, 0x1A },
+};
 
 static void print_opt_string_list(void)
 {
@@ -189,43 +207,96 @@ static void print_opt_string_list(void)
 	{
 		fprintf(stderr, "  %s\n", opt_string_keyword[i].keyword);
 	}
+	for (i = 0; i < ARRAY_SIZE(opt_string_instance_keyword); i++)
+	{
+		fprintf(stderr, "  %s\n", opt_string_instance_keyword[i].keyword);
+	}
 }
 
-static int parse_opt_string(const char *arg)
+/* Strings are displayed in the order they were requested */
+static int add_opt_string(const char *keyword, u8 type, u8 offset, u8 field,
+			  u8 ordered)
 {
-	unsigned int i;
+	struct opt_string *p;
 
-	if (opt.string)
+	p = realloc(opt.string, (opt.string_count + 1) * sizeof(*p));
+	if (p == NULL)
 	{
-		fprintf(stderr, "Only one string can be specified\n");
+		perror("realloc");
 		return -1;
 	}
+	opt.string = p;
 
-	for (i = 0; i < ARRAY_SIZE(opt_string_keyword); i++)
+	p = &opt.string[opt.string_count++];
+	p->keyword = keyword;
+	p->type = type;
+	p->offset = offset;
+	p->field = field;
+	p->ordered = ordered;
+	return 0;
+}
+
+static const struct string_keyword *find_string_keyword(
+	const struct string_keyword *list, unsigned int n,
+	const char *arg, size_t len)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+	{
+		if (strlen(list[i].keyword) == len
+		 && !strncasecmp(arg, list[i].keyword, len))
+			return &list[i];
+	}
+	return NULL;
+}
+
+/* Accepts a comma-separated list of keywords */
+static int parse_opt_string(const char *arg)
+{
+	const struct string_keyword *k;
+	u8 ordered;
+	size_t len;
+
+	do
 	{
-		if (!strcasecmp(arg, opt_string_keyword[i].keyword))
+		len = strcspn(arg, ",");
+
+		ordered = 0;
+		k = find_string_keyword(opt_string_keyword,
+					ARRAY_SIZE(opt_string_keyword),
+					arg, len);
+		if (k == NULL)
+		{
+			k = find_string_keyword(opt_string_instance_keyword,
+						ARRAY_SIZE(opt_string_instance_keyword),
+						arg, len);
+			ordered = 1;
+		}
+		if (k == NULL)
 		{
-			opt.string = &opt_string_keyword[i];
-			return 0;
+			fprintf(stderr, "Invalid string keyword: %.*s\n",
+				(int)len, arg);
+			print_opt_string_list();
+			return -1;
 		}
+		if (add_opt_string(k->keyword, k->type, k->offset, 0,
+				   ordered) < 0)
+			return -1;
+
+		arg += len;
 	}
+	while (*arg++ == ',');
 
-	fprintf(stderr, "Invalid string keyword: %s\n", arg);
-	print_opt_string_list();
-	return -1;
+	return 0;
 }
 
+/* OEM strings (type 11) have no keyword, offset is the string number */
 static int parse_opt_oem_string(const char *arg)
 {
-	unsigned long val;
+	unsigned long val = 0;
 	char *next;
 
-	if (opt.string)
-	{
-		fprintf(stderr, "Only one string can be specified\n");
-		return -1;
-	}
-
 	/* Return the number of OEM strings */
 	if (strcmp(arg, "count") == 0)
 		goto done;
@@ -237,10 +308,157 @@ static int parse_opt_oem_string(const char *arg)
 		return -1;
 	}
 
-	opt_oem_string_keyword.offset = val;
 done:
-	opt.string = &opt_oem_string_keyword;
-	return 0;
+	return add_opt_string(NULL, 11, val, 0, 0);
+}
+
+/*
+ * Handling of option --field
+ */
+
+static int parse_opt_field(const char *arg)
+{
+	static const struct { const char *name; u8 field; } field_name[] = {
+		{ "byte", FIELD_BYTE },
+		{ "word", FIELD_WORD },
+		{ "dword", FIELD_DWORD },
+		{ "qword", FIELD_QWORD },
+		{ "string", FIELD_STRING },
+		{ "uuid", FIELD_UUID },
+	};
+	unsigned long type, offset;
+	u8 field = FIELD_BYTE;
+	unsigned int i;
+	const char *p;
+	char *next;
+
+	type = strtoul(arg, &next, 0);
+	if (next == arg || *next != ':' || type > 0xff)
+		goto invalid;
+
+	p = next + 1;
+	offset = strtoul(p, &next, 0);
+	if (next == p || (*next != ':' && *next != '\0') || offset > 0xff)
+		goto invalid;
+
+	if (*next == ':')
+	{
+		for (i = 0; i < ARRAY_SIZE(field_name); i++)
+			if (!strcasecmp(next + 1, field_name[i].name))
+				break;
+		if (i == ARRAY_SIZE(field_name))
+			goto invalid;
+		field = field_name[i].field;
+	}
+
+	/* The argument doubles as the keyword for --key-value */
+	return add_opt_string(arg, type, offset, field, 0);
+
+invalid:
+	fprintf(stderr, "Invalid field: %s\n", arg);
+	fprintf(stderr, "Fields are TYPE:OFFSET[:byte|word|dword|qword|string|uuid]\n");
+	return -1;
+}
+
+/*
+ * Handling of option --query
+ *
+ * The query is compiled into one bitmap of selected attributes per
+ * type, indexed like the attribute dictionary of the output layer. The
+ * queried types are also added to opt.type, so that other entries are
+ * skipped altogether.
+ */
+
+static int parse_opt_query(const char *arg)
+{
+	unsigned int words = (pr_attr_count() + 31) / 32;
+	char *buf, *item, *attr, *save;
+	u8 *types;
+	int i, t;
+	int ret = -1;
+
+	if (opt.query == NULL)
+	{
+		opt.query = calloc(256 * words, sizeof(u32));
+		if (opt.query == NULL)
+		{
+			perror("calloc");
+			return -1;
+		}
+		opt.query_words = words;
+	}
+	if (opt.type == NULL)
+	{
+		opt.type = calloc(256, sizeof(u8));
+		if (opt.type == NULL)
+		{
+			perror("calloc");
+			return -1;
+		}
+	}
+
+	buf = strdup(arg);
+	if (buf == NULL)
+	{
+		perror("strdup");
+		return -1;
+	}
+
+	for (item = strtok_r(buf, ",", &save); item != NULL;
+	     item = strtok_r(NULL, ",", &save))
+	{
+		attr = strchr(item, '.');
+		if (attr == NULL || attr == item || attr[1] == '\0')
+		{
+			fprintf(stderr, "Invalid query: %s\n", item);
+			fprintf(stderr, "Queries are TYPE.ATTRIBUTE[,TYPE.ATTRIBUTE...]\n");
+			goto exit_free;
+		}
+		*attr++ = '\0';
+
+		i = pr_attr_lookup(attr);
+		if (i < 0)
+		{
+			fprintf(stderr, "Unknown attribute: %s\n", attr);
+			fprintf(stderr, "Valid attributes are listed by --list-attributes\n");
+			goto exit_free;
+		}
+
+		types = parse_opt_type(NULL, item);
+		if (types == NULL)
+			goto exit_free;
+		for (t = 0; t < 256; t++)
+		{
+			if (!types[t])
+				continue;
+			opt.query[t * words + i / 32] |= 1U << (i % 32);
+			opt.type[t] = 1;
+		}
+		free(types);
+	}
+	ret = 0;
+
+exit_free:
+	free(buf);
+	return ret;
+}
+
+/*
+ * Handling of option --format
+ */
+
+static int parse_opt_format(const char *arg)
+{
+	if (!strcasecmp(arg, "text"))
+		return PR_FORMAT_TEXT;
+	if (!strcasecmp(arg, "json"))
+		return PR_FORMAT_JSON;
+	if (!strcasecmp(arg, "cbor"))
+		return PR_FORMAT_CBOR;
+
+	fprintf(stderr, "Invalid output format: %s\n", arg);
+	fprintf(stderr, "Valid output formats are: text, json, cbor\n");
+	return -1;
 }
 
 static u32 parse_opt_handle(const char *arg)
@@ -257,16 +475,135 @@ static u32 parse_opt_handle(const char *arg)
 	return val;
 }
 
+#ifndef DMI_BATCH
+static unsigned int parse_opt_interval(const char *arg)
+{
+	unsigned long val;
+	char *next;
+
+	val = strtoul(arg, &next, 10);
+	if (next == arg || *next != '\0' || val == 0 || val > 86400)
+	{
+		fprintf(stderr, "Invalid polling interval: %s\n", arg);
+		return 0;
+	}
+	return val;
+}
+
+static unsigned int parse_opt_mode(const char *arg)
+{
+	unsigned long val;
+	char *next;
+
+	val = strtoul(arg, &next, 8);
+	if (next == arg || *next != '\0' || val > 0777)
+	{
+		fprintf(stderr, "Invalid socket mode: %s\n", arg);
+		return ~0U;
+	}
+	return val;
+}
+
+static int parse_opt_stats(const char *arg)
+{
+	if (!strcasecmp(arg, "text"))
+		return STATS_FORMAT_TEXT;
+	if (!strcasecmp(arg, "json"))
+		return STATS_FORMAT_JSON;
+
+	fprintf(stderr, "Invalid statistics format: %s\n", arg);
+	fprintf(stderr, "Valid statistics formats are: text, json\n");
+	return -1;
+}
+#endif
+
+#ifdef DMI_BATCH
+static unsigned int parse_opt_jobs(const char *arg)
+{
+	unsigned long val;
+	char *next;
+
+	val = strtoul(arg, &next, 10);
+	if (next == arg || *next != '\0' || val == 0 || val > 1024)
+	{
+		fprintf(stderr, "Invalid number of jobs: %s\n", arg);
+		return 0;
+	}
+	return val;
+}
+#endif
+
 /*
  * Command line options handling
  */
 
+/* Checks shared by command lines and requests, return -1 on error */
+static int check_output_options(int type_option)
+{
+	/* --query sets opt.type, so it is checked on its own first */
+	if (opt.query != NULL
+	 && (opt.string_count != 0 || type_option || opt.handle != ~0U
+	  || (opt.flags & (FLAG_DUMP | FLAG_DUMP_BIN | FLAG_RESOLVE
+			   | FLAG_EVENT_LOG | FLAG_DUMP_ALL))))
+	{
+		fprintf(stderr, "Option --query can't be used with --string, --field, --type, --handle, --dump, --dump-bin, --resolve-address, --event-log or --dump-all\n");
+		return -1;
+	}
+
+	/* Check for mutually exclusive output format options */
+	if ((opt.string_count != 0) + (opt.type != NULL)
+	  + !!(opt.flags & FLAG_DUMP_BIN) + (opt.handle != ~0U)
+	  + !!(opt.flags & FLAG_RESOLVE) + !!(opt.flags & FLAG_EVENT_LOG)
+	  + !!(opt.flags & FLAG_DUMP_ALL) > 1)
+	{
+		fprintf(stderr, "Options --string, --field, --type, --handle, --dump-bin, --resolve-address, --event-log and --dump-all are mutually exclusive\n");
+		return -1;
+	}
+
+	/* Strings are always printed as plain text */
+	if (opt.string_count != 0 && opt.format != PR_FORMAT_TEXT)
+	{
+		fprintf(stderr, "Option %s only supports text output\n",
+			opt.string[0].field ? "--field" :
+			opt.string[0].keyword ? "--string" : "--oem-string");
+		return -1;
+	}
+
+	if ((opt.flags & FLAG_RESOLVE)
+	 && ((opt.flags & FLAG_DUMP) || opt.format != PR_FORMAT_TEXT))
+	{
+		fprintf(stderr, "Option --resolve-address can't be used with --dump or --format\n");
+		return -1;
+	}
+
+	if ((opt.flags & FLAG_EVENT_LOG) && (opt.flags & FLAG_DUMP))
+	{
+		fprintf(stderr, "Option --event-log can't be used with --dump\n");
+		return -1;
+	}
+
+	if ((opt.flags & FLAG_DUMP_ALL)
+	 && ((opt.flags & FLAG_DUMP) || opt.format != PR_FORMAT_TEXT))
+	{
+		fprintf(stderr, "Option --dump-all can't be used with --dump or --format\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 /* Return -1 on error, 0 on success */
 int parse_command_line(int argc, char * const argv[])
 {
 	int option;
 	unsigned int i;
+	int type_option = 0;
+	char *diff_first = NULL;
+#ifdef DMI_BATCH
+	const char *optstring = "d:hj:qs:t:uH:V";
+#else
 	const char *optstring = "d:hqs:t:uH:V";
+#endif
 	struct option longopts[] = {
 		{ "dev-mem", required_argument, NULL, 'd' },
 		{ "help", no_argument, NULL, 'h' },
@@ -275,14 +612,38 @@ int parse_command_line(int argc, char * const argv[])
 		{ "string", required_argument, NULL, 's' },
 		{ "type", required_argument, NULL, 't' },
 		{ "dump", no_argument, NULL, 'u' },
+		{ "dump-all", no_argument, NULL, 'I' },
 		{ "dump-bin", required_argument, NULL, 'B' },
 		{ "from-dump", required_argument, NULL, 'F' },
+		{ "from-dump-list", required_argument, NULL, 'M' },
+		{ "from-dump-dir", required_argument, NULL, 'D' },
 		{ "handle", required_argument, NULL, 'H' },
 		{ "oem-string", required_argument, NULL, 'O' },
+		{ "key-value", no_argument, NULL, 'K' },
+		{ "field", required_argument, NULL, 'E' },
+		{ "query", required_argument, NULL, 'Y' },
+		{ "annotate-handles", no_argument, NULL, 'N' },
+		{ "format", required_argument, NULL, 'J' },
 		{ "no-sysfs", no_argument, NULL, 'S' },
+#ifndef DMI_BATCH
+		{ "serve", required_argument, NULL, 'W' },
+		{ "serve-mode", required_argument, NULL, 'm' },
+		{ "serve-group", required_argument, NULL, 'g' },
+		{ "resolve-address", no_argument, NULL, 'R' },
+		{ "event-log", optional_argument, NULL, 'G' },
+		{ "follow", optional_argument, NULL, 'P' },
+		{ "state-file", required_argument, NULL, 'Z' },
+		{ "diff", required_argument, NULL, 'X' },
+		{ "stats", optional_argument, NULL, 'a' },
+#endif
 		{ "list-strings", no_argument, NULL, 'L' },
 		{ "list-types", no_argument, NULL, 'T' },
+		{ "list-attributes", no_argument, NULL, 'A' },
 		{ "version", no_argument, NULL, 'V' },
+#ifdef DMI_BATCH
+		{ "jobs", required_argument, NULL, 'j' },
+		{ "unordered", no_argument, NULL, 'U' },
+#endif
 		{ NULL, 0, NULL, 0 }
 	};
 
@@ -297,6 +658,14 @@ int parse_command_line(int argc, char * const argv[])
 				opt.flags |= FLAG_FROM_DUMP;
 				opt.dumpfile = optarg;
 				break;
+			case 'M':
+				opt.flags |= FLAG_FROM_DUMP;
+				opt.dumplist = optarg;
+				break;
+			case 'D':
+				opt.flags |= FLAG_FROM_DUMP;
+				opt.dumpdir = optarg;
+				break;
 			case 'd':
 				opt.devmem = optarg;
 				break;
@@ -323,6 +692,27 @@ int parse_command_line(int argc, char * const argv[])
 				opt.type = parse_opt_type(opt.type, optarg);
 				if (opt.type == NULL)
 					return -1;
+				type_option = 1;
+				break;
+			case 'Y':
+				if (parse_opt_query(optarg) < 0)
+					return -1;
+				break;
+			case 'J':
+				opt.format = parse_opt_format(optarg);
+				if (opt.format < 0)
+					return -1;
+				break;
+			case 'K':
+				opt.flags |= FLAG_KEY_VALUE;
+				break;
+			case 'N':
+				opt.flags |= FLAG_ANNOTATE;
+				break;
+			case 'E':
+				if (parse_opt_field(optarg) < 0)
+					return -1;
+				opt.flags |= FLAG_QUIET;
 				break;
 			case 'H':
 				opt.handle = parse_opt_handle(optarg);
@@ -332,9 +722,58 @@ int parse_command_line(int argc, char * const argv[])
 			case 'u':
 				opt.flags |= FLAG_DUMP;
 				break;
+			case 'I':
+				opt.flags |= FLAG_DUMP_ALL | FLAG_QUIET;
+				break;
 			case 'S':
 				opt.flags |= FLAG_NO_SYSFS;
 				break;
+#ifndef DMI_BATCH
+			case 'W':
+				opt.sockpath = optarg;
+				break;
+			case 'm':
+				opt.sockmode = parse_opt_mode(optarg);
+				if (opt.sockmode == ~0U)
+					return -1;
+				break;
+			case 'g':
+				opt.sockgroup = optarg;
+				break;
+			case 'R':
+				opt.flags |= FLAG_RESOLVE | FLAG_QUIET;
+				break;
+			case 'G':
+				opt.flags |= FLAG_EVENT_LOG;
+				opt.eventlog = optarg;
+				break;
+			case 'P':
+				opt.interval = optarg ? parse_opt_interval(optarg)
+						      : DEFAULT_FOLLOW_INTERVAL;
+				if (opt.interval == 0)
+					return -1;
+				break;
+			case 'Z':
+				opt.statefile = optarg;
+				break;
+			case 'X':
+				/* The second file is the next argument */
+				if (optind >= argc)
+				{
+					fprintf(stderr, "Option --diff requires two files\n");
+					return -1;
+				}
+				diff_first = optarg;
+				opt.diff = argv[optind++];
+				break;
+			case 'a':
+				opt.stats = optarg ? parse_opt_stats(optarg)
+						   : STATS_FORMAT_TEXT;
+				if (opt.stats < 0)
+					return -1;
+				opt.flags |= FLAG_STATS;
+				break;
+#endif
 			case 'L':
 				for (i = 0; i < ARRAY_SIZE(opt_string_keyword); i++)
 					fprintf(stdout, "%s\n", opt_string_keyword[i].keyword);
@@ -345,9 +784,23 @@ int parse_command_line(int argc, char * const argv[])
 					fprintf(stdout, "%s\n", opt_type_keyword[i].keyword);
 				opt.flags |= FLAG_LIST;
 				return 0;
+			case 'A':
+				pr_dictionary();
+				opt.flags |= FLAG_LIST;
+				return 0;
 			case 'V':
 				opt.flags |= FLAG_VERSION;
 				break;
+#ifdef DMI_BATCH
+			case 'j':
+				opt.jobs = parse_opt_jobs(optarg);
+				if (opt.jobs == 0)
+					return -1;
+				break;
+			case 'U':
+				opt.unordered = 1;
+				break;
+#endif
 			case '?':
 				switch (optopt)
 				{
@@ -363,12 +816,28 @@ int parse_command_line(int argc, char * const argv[])
 				return -1;
 		}
 
-	/* Check for mutually exclusive output format options */
-	if ((opt.string != NULL) + (opt.type != NULL)
-	  + !!(opt.flags & FLAG_DUMP_BIN) + (opt.handle != ~0U) > 1)
-	{
-		fprintf(stderr, "Options --string, --type, --handle and --dump-bin are mutually exclusive\n");
+	if (check_output_options(type_option) < 0)
 		return -1;
+
+	if (opt.diff != NULL)
+	{
+		if (opt.string_count != 0 || opt.handle != ~0U
+		 || opt.query != NULL || opt.format != PR_FORMAT_TEXT
+		 || (opt.flags & (FLAG_DUMP | FLAG_DUMP_BIN | FLAG_RESOLVE
+				  | FLAG_EVENT_LOG | FLAG_DUMP_ALL)))
+		{
+			fprintf(stderr, "Option --diff can't be used with output options other than --type\n");
+			return -1;
+		}
+		if (opt.flags & FLAG_FROM_DUMP)
+		{
+			fprintf(stderr, "Options --from-dump, --from-dump-list, --from-dump-dir and --diff are mutually exclusive\n");
+			return -1;
+		}
+
+		/* The first file is read as with --from-dump */
+		opt.flags |= FLAG_FROM_DUMP;
+		opt.dumpfile = diff_first;
 	}
 
 	if ((opt.flags & FLAG_FROM_DUMP) && (opt.flags & FLAG_DUMP_BIN))
@@ -377,28 +846,191 @@ int parse_command_line(int argc, char * const argv[])
 		return -1;
 	}
 
+	if ((opt.dumpfile != NULL) + (opt.dumplist != NULL)
+	  + (opt.dumpdir != NULL) > 1)
+	{
+		fprintf(stderr, "Options --from-dump, --from-dump-list and --from-dump-dir are mutually exclusive\n");
+		return -1;
+	}
+
+	if ((opt.interval != 0 || opt.statefile != NULL)
+	 && !(opt.flags & FLAG_EVENT_LOG))
+	{
+		fprintf(stderr, "Options --follow and --state-file require --event-log\n");
+		return -1;
+	}
+
+	if (opt.sockpath == NULL
+	 && (opt.sockmode != DEFAULT_SOCKET_MODE || opt.sockgroup != NULL))
+	{
+		fprintf(stderr, "Options --serve-mode and --serve-group require --serve\n");
+		return -1;
+	}
+
+	if (opt.sockpath != NULL && (opt.flags & FLAG_STATS))
+	{
+		fprintf(stderr, "Options --serve and --stats are mutually exclusive\n");
+		return -1;
+	}
+
+	/* What to display is up to the clients */
+	if (opt.sockpath != NULL
+	 && (opt.string_count != 0 || opt.type != NULL || opt.handle != ~0U
+	  || opt.query != NULL || opt.format != PR_FORMAT_TEXT
+	  || opt.dumplist != NULL || opt.dumpdir != NULL || opt.diff != NULL
+	  || (opt.flags & (FLAG_DUMP | FLAG_DUMP_BIN | FLAG_KEY_VALUE
+			   | FLAG_RESOLVE | FLAG_ANNOTATE | FLAG_EVENT_LOG
+			   | FLAG_DUMP_ALL))))
+	{
+		fprintf(stderr, "Option --serve can't be used with output options, clients set them\n");
+		return -1;
+	}
+
 	return 0;
 }
 
+#ifndef DMI_BATCH
+/*
+ * Requests of --serve clients: the output options of the command line,
+ * applied on top of the options of the daemon.
+ * Return -1 on error, 0 on success.
+ */
+int parse_request(int argc, char * const argv[])
+{
+	int option;
+	int type_option = 0;
+	const char *optstring = "qs:t:uH:";
+	struct option longopts[] = {
+		{ "quiet", no_argument, NULL, 'q' },
+		{ "string", required_argument, NULL, 's' },
+		{ "type", required_argument, NULL, 't' },
+		{ "dump", no_argument, NULL, 'u' },
+		{ "handle", required_argument, NULL, 'H' },
+		{ "oem-string", required_argument, NULL, 'O' },
+		{ "key-value", no_argument, NULL, 'K' },
+		{ "field", required_argument, NULL, 'E' },
+		{ "query", required_argument, NULL, 'Y' },
+		{ "annotate-handles", no_argument, NULL, 'N' },
+		{ "format", required_argument, NULL, 'J' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	/* Start over, the daemon's own command line was parsed already */
+	optind = 0;
+	while ((option = getopt_long(argc, argv, optstring, longopts, NULL)) != -1)
+		switch (option)
+		{
+			case 'q':
+				opt.flags |= FLAG_QUIET;
+				break;
+			case 's':
+				if (parse_opt_string(optarg) < 0)
+					return -1;
+				opt.flags |= FLAG_QUIET;
+				break;
+			case 'O':
+				if (parse_opt_oem_string(optarg) < 0)
+					return -1;
+				opt.flags |= FLAG_QUIET;
+				break;
+			case 't':
+				opt.type = parse_opt_type(opt.type, optarg);
+				if (opt.type == NULL)
+					return -1;
+				type_option = 1;
+				break;
+			case 'Y':
+				if (parse_opt_query(optarg) < 0)
+					return -1;
+				break;
+			case 'J':
+				opt.format = parse_opt_format(optarg);
+				if (opt.format < 0)
+					return -1;
+				break;
+			case 'K':
+				opt.flags |= FLAG_KEY_VALUE;
+				break;
+			case 'N':
+				opt.flags |= FLAG_ANNOTATE;
+				break;
+			case 'E':
+				if (parse_opt_field(optarg) < 0)
+					return -1;
+				opt.flags |= FLAG_QUIET;
+				break;
+			case 'H':
+				opt.handle = parse_opt_handle(optarg);
+				if (opt.handle  == ~0U)
+					return -1;
+				break;
+			case 'u':
+				opt.flags |= FLAG_DUMP;
+				break;
+			case '?':
+				return -1;
+		}
+
+	if (optind < argc)
+	{
+		fprintf(stderr, "Unexpected argument: %s\n", argv[optind]);
+		return -1;
+	}
+
+	return check_output_options(type_option);
+}
+#endif
+
 void print_help(void)
 {
 	static const char *help =
+#ifdef DMI_BATCH
+		"Usage: dmidecode-batch --from-dump-list FILE|--from-dump-dir DIR [OPTIONS]\n"
+#else
 		"Usage: dmidecode [OPTIONS]\n"
+#endif
 		"Options are:\n"
 		" -d, --dev-mem FILE     Read memory from device FILE (default: " DEFAULT_MEM_DEV ")\n"
 		" -h, --help             Display this help text and exit\n"
 		" -q, --quiet            Less verbose output\n"
 		"     --no-quirks        Decode everything without quirks\n"
-		" -s, --string KEYWORD   Only display the value of the given DMI string\n"
+		" -s, --string KEYWORD   Only display the value of the given DMI string(s)\n"
 		"     --list-strings     List available string keywords and exit\n"
 		" -t, --type TYPE        Only display the entries of given type\n"
 		"     --list-types       List available type keywords and exit\n"
 		" -H, --handle HANDLE    Only display the entry of given handle\n"
 		" -u, --dump             Do not decode the entries\n"
+		"     --dump-all         Dump the whole DMI table in xxd layout\n"
 		"     --dump-bin FILE    Dump the DMI data to a binary file\n"
 		"     --from-dump FILE   Read the DMI data from a binary file\n"
+		"     --from-dump-list FILE\n"
+		"                        Read the DMI data from each binary file listed in FILE\n"
+		"     --from-dump-dir DIR\n"
+		"                        Read the DMI data from each binary file in DIR\n"
 		"     --no-sysfs         Do not attempt to read DMI data from sysfs files\n"
 		"     --oem-string N     Only display the value of the given OEM string\n"
+		"     --field TYPE:OFFSET[:byte|word|dword|qword|string|uuid]\n"
+		"                        Only display the value at OFFSET in entries of TYPE\n"
+		"     --key-value        Display strings as KEYWORD=VALUE\n"
+		"     --format FORMAT    Select the output format (text, json or cbor)\n"
+		"     --query QUERY      Only display the given attributes (TYPE.ATTRIBUTE,...)\n"
+		"     --annotate-handles Display the type and designation of referenced entries\n"
+		"     --list-attributes  List the attribute dictionary and exit\n"
+#ifndef DMI_BATCH
+		"     --serve SOCKET     Answer queries of clients connecting to SOCKET\n"
+		"     --serve-mode MODE  Set the permissions of SOCKET (octal, default: 600)\n"
+		"     --serve-group GROUP Set the group owning SOCKET\n"
+		"     --resolve-address  Display the memory device of each address read from stdin\n"
+		"     --event-log[=FILE] Display the events of the system event log (read from FILE)\n"
+		"     --follow[=SECONDS] Keep displaying new events, polling every SECONDS (default: 60)\n"
+		"     --state-file FILE  Only display events not displayed before, per FILE\n"
+		"     --diff FILE1 FILE2 Display the differences between two binary dump files\n"
+		"     --stats[=FORMAT]   Display timing and decoding statistics on stderr (text or json)\n"
+#endif
+#ifdef DMI_BATCH
+		" -j, --jobs N           Decode N files in parallel (default: one per CPU)\n"
+		"     --unordered        Output each file as soon as it is decoded\n"
+#endif
 		" -V, --version          Display the version and exit\n";
 
 	printf("%s", help);
@@ -19,6 +19,7 @@
  *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
  */
 
+#include "config.h"
 #include "types.h"
 
 struct string_keyword
@@ -28,16 +29,50 @@ struct string_keyword
 	u8 offset;
 };
 
+/* A string or field to display (--string, --oem-string, --field) */
+struct opt_string
+{
+	const char *keyword;
+	u8 type;
+	u8 offset;
+	u8 field;	/* Set for --field, 0 for keywords */
+	u8 ordered;	/* Instances in handle order, else in table order */
+};
+
+/* --field interpretations */
+#define FIELD_BYTE              1
+#define FIELD_WORD              2
+#define FIELD_DWORD             3
+#define FIELD_QWORD             4
+#define FIELD_STRING            5
+#define FIELD_UUID              6
+
 struct opt
 {
 	const char *devmem;
 	unsigned int flags;
 	u8 *type;
-	const struct string_keyword *string;
+	struct opt_string *string;	/* Strings to display, in order */
+	unsigned int string_count;
+	u32 *query;			/* Attribute bitmap of each type */
+	unsigned int query_words;	/* Size of each bitmap */
 	char *dumpfile;
+	const char *dumplist;
+	const char *dumpdir;
 	u32 handle;
+	int format;
+	const char *sockpath;		/* --serve */
+	unsigned int sockmode;		/* --serve-mode */
+	const char *sockgroup;		/* --serve-group */
+	const char *eventlog;		/* --event-log image file */
+	const char *statefile;		/* --state-file */
+	unsigned int interval;		/* --follow, 0 if not following */
+	const char *diff;		/* --diff, second file */
+	int stats;			/* --stats format */
+	unsigned int jobs;		/* dmidecode-batch only */
+	int unordered;			/* dmidecode-batch only */
 };
-extern struct opt opt;
+extern DMI_THREAD struct opt opt;
 
 #define FLAG_VERSION            (1 << 0)
 #define FLAG_HELP               (1 << 1)
@@ -48,6 +83,13 @@ extern struct opt opt;
 #define FLAG_NO_SYSFS           (1 << 6)
 #define FLAG_NO_QUIRKS          (1 << 7)
 #define FLAG_LIST               (1 << 8)
+#define FLAG_KEY_VALUE          (1 << 9)
+#define FLAG_RESOLVE            (1 << 10)
+#define FLAG_ANNOTATE           (1 << 11)
+#define FLAG_EVENT_LOG          (1 << 12)
+#define FLAG_DUMP_ALL           (1 << 13)
+#define FLAG_STATS              (1 << 14)
 
 int parse_command_line(int argc, char * const argv[]);
+int parse_request(int argc, char * const argv[]);
 void print_help(void);
@@ -19,19 +19,1519 @@
  *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
  */
 
+#include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include "dmioutput.h"
 
+/*
+ * The errors of the output code itself can't go through the per-thread
+ * stderr of dmidecode-batch, which writes to the output
+ */
+#ifdef DMI_BATCH
+#undef perror
+#endif
+
+/*
+ * Output buffer
+ *
+ * Everything written to stdout goes to an arena of large chunks, which
+ * is written out with a single writev() call when all chunks are full,
+ * at the end, and at sync points (see pr_sync()). Chunks are kept after
+ * a flush, so the arena is only allocated once.
+ *
+ * In batch and daemon modes, output can be captured instead (see
+ * pr_part_start() and pr_capture_start()): flushing then appends to a
+ * memory buffer.
+ */
+
+#define OUT_CHUNK_SIZE	(64 * 1024)
+#define OUT_CHUNKS	16
+
+static DMI_THREAD struct
+{
+	struct iovec iov[OUT_CHUNKS];	/* iov_len is the used length */
+	size_t size[OUT_CHUNKS];	/* Allocated length */
+	int count;			/* Chunks in use */
+	int sync;			/* stdout and stderr are the same file */
+	int error;			/* Stop writing after an error */
+	int capture;			/* Flush to memory */
+	char *capture_buf;
+	size_t capture_len;
+	size_t capture_size;
+	char *err_buf;			/* Error messages of a part */
+	size_t err_len;
+	size_t err_size;
+	unsigned long writes;		/* Write calls (--stats) */
+	unsigned long long written;	/* Bytes written (--stats) */
+} out;
+
+static void out_capture(void)
+{
+	size_t len = 0;
+	int i;
+
+	for (i = 0; i < out.count; i++)
+		len += out.iov[i].iov_len;
+
+	if (out.capture_size - out.capture_len < len)
+	{
+		size_t size = out.capture_size ? out.capture_size : OUT_CHUNK_SIZE;
+		char *p;
+
+		while (size - out.capture_len < len)
+			size *= 2;
+		p = realloc(out.capture_buf, size);
+		if (p == NULL)
+		{
+			perror("realloc");
+			out.error = 1;
+			out.count = 0;
+			return;
+		}
+		out.capture_buf = p;
+		out.capture_size = size;
+	}
+
+	for (i = 0; i < out.count; i++)
+	{
+		memcpy(out.capture_buf + out.capture_len, out.iov[i].iov_base,
+		       out.iov[i].iov_len);
+		out.capture_len += out.iov[i].iov_len;
+	}
+	out.count = 0;
+}
+
+static void out_flush(void)
+{
+	struct iovec iov[OUT_CHUNKS], *v = iov;
+	int count = out.count;
+	ssize_t n;
+
+	if (out.capture)
+	{
+		if (!out.error)
+			out_capture();
+		out.count = 0;
+		return;
+	}
+
+	/* Work on a copy, partial writes move the pointers */
+	memcpy(iov, out.iov, count * sizeof(struct iovec));
+	out.count = 0;
+
+	while (count && !out.error)
+	{
+		n = writev(STDOUT_FILENO, v, count);
+		out.writes++;
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("write");
+			out.error = 1;
+			break;
+		}
+		out.written += n;
+
+		while (count && (size_t)n >= v->iov_len)
+		{
+			n -= v->iov_len;
+			v++;
+			count--;
+		}
+		if (count)
+		{
+			v->iov_base = (char *)v->iov_base + n;
+			v->iov_len -= n;
+		}
+	}
+}
+
+/* Returns room for len bytes, the caller must then call out_commit() */
+static char *out_reserve(size_t len)
+{
+	struct iovec *v;
+
+	if (out.count)
+	{
+		v = &out.iov[out.count - 1];
+		if (out.size[out.count - 1] - v->iov_len >= len)
+			return (char *)v->iov_base + v->iov_len;
+	}
+
+	if (out.count == OUT_CHUNKS)
+		out_flush();
+
+	v = &out.iov[out.count];
+	if (out.size[out.count] < len)
+	{
+		size_t size = len > OUT_CHUNK_SIZE ? len : OUT_CHUNK_SIZE;
+		void *p = realloc(v->iov_base, size);
+
+		if (p == NULL)
+		{
+			perror("realloc");
+			return NULL;
+		}
+		v->iov_base = p;
+		out.size[out.count] = size;
+	}
+	v->iov_len = 0;
+	out.count++;
+
+	return v->iov_base;
+}
+
+static void out_commit(size_t len)
+{
+	out.iov[out.count - 1].iov_len += len;
+}
+
+static void out_write(const void *s, size_t len)
+{
+	char *p = out_reserve(len);
+
+	if (p == NULL)
+		return;
+	memcpy(p, s, len);
+	out_commit(len);
+}
+
+static void out_puts(const char *s)
+{
+	out_write(s, strlen(s));
+}
+
+static void out_putc(char c)
+{
+	out_write(&c, 1);
+}
+
+static void out_vprintf(const char *format, va_list args)
+{
+	va_list copy;
+	size_t avail = 0;
+	char *p = NULL;
+	int len;
+
+	/* Try in place first, most lines fit */
+	if (out.count)
+	{
+		struct iovec *v = &out.iov[out.count - 1];
+
+		p = (char *)v->iov_base + v->iov_len;
+		avail = out.size[out.count - 1] - v->iov_len;
+	}
+
+	va_copy(copy, args);
+	len = vsnprintf(p, avail, format, copy);
+	va_end(copy);
+	if (len < 0)
+		return;
+
+	if ((size_t)len >= avail)
+	{
+		p = out_reserve(len + 1);
+		if (p == NULL)
+			return;
+		vsnprintf(p, len + 1, format, args);
+	}
+	out_commit(len);
+}
+
+static void out_printf(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	out_vprintf(format, args);
+	va_end(args);
+}
+
+static void out_free(void)
+{
+	int i;
+
+	for (i = 0; i < OUT_CHUNKS; i++)
+	{
+		free(out.iov[i].iov_base);
+		out.iov[i].iov_base = NULL;
+		out.size[i] = 0;
+	}
+	out.count = 0;
+}
+
+/*
+ * Number formatting
+ *
+ * The typed pr_* functions convert integers themselves, two decimal
+ * digits at a time, instead of going through vsnprintf(). Numbers are
+ * written backwards, ending at the given pointer, and the first
+ * character is returned.
+ */
+
+#define DEC_PAIRS(c) c "0" c "1" c "2" c "3" c "4" c "5" c "6" c "7" c "8" c "9"
+
+static const char dec_pairs[] =
+	DEC_PAIRS("0") DEC_PAIRS("1") DEC_PAIRS("2") DEC_PAIRS("3")
+	DEC_PAIRS("4") DEC_PAIRS("5") DEC_PAIRS("6") DEC_PAIRS("7")
+	DEC_PAIRS("8") DEC_PAIRS("9");
+
+/* Longest string written by fmt_u32() or fmt_hex(), NUL byte included */
+#define FMT_SIZE	12
+
+static char *fmt_u32(char *end, u32 v)
+{
+	while (v >= 100)
+	{
+		end -= 2;
+		memcpy(end, dec_pairs + 2 * (v % 100), 2);
+		v /= 100;
+	}
+	if (v >= 10)
+	{
+		end -= 2;
+		memcpy(end, dec_pairs + 2 * v, 2);
+	}
+	else
+		*--end = '0' + v;
+
+	return end;
+}
+
+/* Same as printf's "0x%0*X", digits must be 8 or less */
+static char *fmt_hex(char *end, u32 v, int digits)
+{
+	while (digits--)
+	{
+		*--end = "0123456789ABCDEF"[v & 0xF];
+		v >>= 4;
+	}
+	*--end = 'x';
+	*--end = '0';
+
+	return end;
+}
+
+/*
+ * Each output format implements the same set of hooks. Variadic
+ * arguments are passed down as a va_list.
+ */
+struct pr_ops
+{
+	void (*comment)(const char *format, va_list args);
+	void (*info)(const char *format, va_list args);
+	void (*file)(const char *name);
+	void (*handle)(const struct dmi_header *h);
+	void (*handle_name)(const char *format, va_list args);
+	void (*attr)(const char *name, const char *format, va_list args);
+	void (*attr_str)(const char *name, const char *s);
+	void (*subattr)(const char *name, const char *format, va_list args);
+	void (*subattr_str)(const char *name, const char *s);
+	void (*list_start)(const char *name, const char *format, va_list args);
+	void (*list_item)(const char *format, va_list args);
+	void (*list_item_str)(const char *s);
+	void (*list_end)(void);
+	void (*sep)(void);
+	void (*struct_err)(const char *format, va_list args);
+	void (*end)(void);
+};
+
+/*
+ * Plain text output
+ */
+
+static void text_comment(const char *format, va_list args)
+{
+	out_puts("# ");
+	out_vprintf(format, args);
+	out_putc('\n');
+}
+
+static void text_info(const char *format, va_list args)
+{
+	out_vprintf(format, args);
+	out_putc('\n');
+}
+
+static void text_file(const char *name)
+{
+	out_printf("# File: %s\n", name);
+}
+
+static void text_handle(const struct dmi_header *h)
+{
+	char buf[3 * FMT_SIZE + 32], *p = buf + sizeof(buf);
+
+	/* Built backwards, "Handle 0x%04X, DMI type %d, %d bytes\n" */
+	p -= 7;
+	memcpy(p, " bytes\n", 7);
+	p = fmt_u32(p, h->length);
+	p -= 2;
+	memcpy(p, ", ", 2);
+	p = fmt_u32(p, h->type);
+	p -= 11;
+	memcpy(p, ", DMI type ", 11);
+	p = fmt_hex(p, h->handle, 4);
+	p -= 7;
+	memcpy(p, "Handle ", 7);
+
+	out_write(p, buf + sizeof(buf) - p);
+}
+
+static void text_handle_name(const char *format, va_list args)
+{
+	out_vprintf(format, args);
+	out_putc('\n');
+}
+
+static void text_attr(const char *name, const char *format, va_list args)
+{
+	out_putc('\t');
+	out_puts(name);
+	out_puts(": ");
+	out_vprintf(format, args);
+	out_putc('\n');
+}
+
+static void text_subattr(const char *name, const char *format, va_list args)
+{
+	out_puts("\t\t");
+	out_puts(name);
+	out_puts(": ");
+	out_vprintf(format, args);
+	out_putc('\n');
+}
+
+/* Write a whole attribute line at once */
+static void text_value(int depth, const char *name, const char *s)
+{
+	size_t name_len = strlen(name), len = strlen(s);
+	char *p = out_reserve(depth + name_len + len + 3);
+
+	if (p == NULL)
+		return;
+	memset(p, '\t', depth);
+	memcpy(p + depth, name, name_len);
+	memcpy(p + depth + name_len, ": ", 2);
+	memcpy(p + depth + name_len + 2, s, len);
+	p[depth + name_len + 2 + len] = '\n';
+	out_commit(depth + name_len + len + 3);
+}
+
+static void text_attr_str(const char *name, const char *s)
+{
+	text_value(1, name, s);
+}
+
+static void text_subattr_str(const char *name, const char *s)
+{
+	text_value(2, name, s);
+}
+
+static void text_list_start(const char *name, const char *format, va_list args)
+{
+	out_putc('\t');
+	out_puts(name);
+	out_putc(':');
+
+	/* format is optional, skip value if not provided */
+	if (format)
+	{
+		out_putc(' ');
+		out_vprintf(format, args);
+	}
+	out_putc('\n');
+}
+
+static void text_list_item(const char *format, va_list args)
+{
+	out_puts("\t\t");
+	out_vprintf(format, args);
+	out_putc('\n');
+}
+
+static void text_list_item_str(const char *s)
+{
+	size_t len = strlen(s);
+	char *p = out_reserve(len + 3);
+
+	if (p == NULL)
+		return;
+	memcpy(p, "\t\t", 2);
+	memcpy(p + 2, s, len);
+	p[len + 2] = '\n';
+	out_commit(len + 3);
+}
+
+static void text_list_end(void)
+{
+	/* a no-op for text output */
+}
+
+static void text_sep(void)
+{
+	out_putc('\n');
+}
+
+static void text_struct_err(const char *format, va_list args)
+{
+	out_putc('\t');
+	out_vprintf(format, args);
+	out_putc('\n');
+}
+
+static void text_end(void)
+{
+	/* a no-op for text output */
+}
+
+static const struct pr_ops text_ops = {
+	.comment = text_comment,
+	.info = text_info,
+	.file = text_file,
+	.handle = text_handle,
+	.handle_name = text_handle_name,
+	.attr = text_attr,
+	.attr_str = text_attr_str,
+	.subattr = text_subattr,
+	.subattr_str = text_subattr_str,
+	.list_start = text_list_start,
+	.list_item = text_list_item,
+	.list_item_str = text_list_item_str,
+	.list_end = text_list_end,
+	.sep = text_sep,
+	.struct_err = text_struct_err,
+	.end = text_end,
+};
+
+/*
+ * Structured output
+ *
+ * The document is a single array, with one element per structure or
+ * message: comments and informational messages become maps with a
+ * "comment" or "info" member, and each structure becomes a map with its
+ * handle, type, length, name and attributes. In batch mode, the records
+ * of each file are preceded by a map with a "file" member. Lists become
+ * arrays, or maps with a "value" and an "items" array if the list has a
+ * value of its own. An attribute followed by sub-attributes becomes a map
+ * with a "value" and the sub-attributes.
+ *
+ * Output is streamed, the only state kept is where we are in the current
+ * structure. The last attribute is held back until we know whether
+ * sub-attributes follow. How the document is actually written out is up
+ * to the encoder (JSON or CBOR).
+ */
+
+enum pr_key
+{
+	KEY_HANDLE,
+	KEY_TYPE,
+	KEY_LENGTH,
+	KEY_NAME,
+	KEY_ATTRIBUTES,
+	KEY_VALUE,
+	KEY_ITEMS,
+	KEY_ERROR,
+	KEY_COMMENT,
+	KEY_INFO,
+	KEY_FILE,
+};
+
+static const char *key_name[] = {
+	"handle",
+	"type",
+	"length",
+	"name",
+	"attributes",
+	"value",
+	"items",
+	"error",
+	"comment",
+	"info",
+	"file",
+};
+
+struct pr_encoder
+{
+	void (*doc_start)(void);
+	void (*doc_end)(void);
+	void (*part_start)(void);	/* Continue a document started elsewhere */
+	void (*map_start)(void);
+	void (*array_start)(void);
+	void (*close)(void);	/* Ends the innermost map or array */
+	void (*key)(enum pr_key key);
+	void (*attr_key)(const char *name);
+	void (*string)(const char *s);
+	void (*uint)(unsigned int v);
+};
+
+static DMI_THREAD const struct pr_encoder *enc;
+
+static DMI_THREAD struct
+{
+	int started;		/* Document started */
+	int in_handle;		/* Structure map open */
+	int in_attrs;		/* Attributes map open */
+	int in_subattrs;	/* Attribute map open for sub-attributes */
+	int in_list;		/* 0, 1 for plain array, 2 for map */
+	int pending;		/* Attribute held back */
+	char *name;
+	size_t name_size;
+	char *value;
+	size_t value_size;
+	char *buf;		/* Formatting buffer */
+	size_t size;
+} st;
+
+/* Format into the shared buffer, growing it as needed */
+static const char *st_format(const char *format, va_list args)
+{
+	va_list copy;
+	int len;
+
+	va_copy(copy, args);
+	len = vsnprintf(st.buf, st.size, format, copy);
+	va_end(copy);
+	if (len < 0)
+		return "";
+
+	if ((size_t)len >= st.size)
+	{
+		char *p = realloc(st.buf, len + 1);
+
+		if (p == NULL)
+		{
+			perror("realloc");
+			return "";
+		}
+		st.buf = p;
+		st.size = len + 1;
+		vsnprintf(st.buf, st.size, format, args);
+	}
+
+	return st.buf;
+}
+
+/* Copy s to a buffer which is reused from call to call */
+static int st_save(char **buf, size_t *size, const char *s)
+{
+	size_t len = strlen(s) + 1;
+
+	if (len > *size)
+	{
+		char *p = realloc(*buf, len);
+
+		if (p == NULL)
+		{
+			perror("realloc");
+			return -1;
+		}
+		*buf = p;
+		*size = len;
+	}
+	memcpy(*buf, s, len);
+	return 0;
+}
+
+static void st_record_start(void)
+{
+	if (!st.started)
+	{
+		enc->doc_start();
+		st.started = 1;
+	}
+	enc->map_start();
+}
+
+/* Write out the held back attribute, or close its map */
+static void st_flush_attr(void)
+{
+	if (st.pending)
+	{
+		enc->attr_key(st.name);
+		enc->string(st.value);
+		st.pending = 0;
+	}
+	if (st.in_subattrs)
+	{
+		enc->close();
+		st.in_subattrs = 0;
+	}
+}
+
+static void st_close_list(void)
+{
+	if (st.in_list)
+	{
+		enc->close();
+		if (st.in_list == 2)
+			enc->close();
+		st.in_list = 0;
+	}
+}
+
+/* Get ready to write an attribute-level element */
+static void st_open_attrs(void)
+{
+	st_flush_attr();
+	st_close_list();
+
+	if (!st.in_handle)
+	{
+		/* Shouldn't happen, but keep the document valid */
+		st_record_start();
+		st.in_handle = 1;
+	}
+	if (!st.in_attrs)
+	{
+		enc->key(KEY_ATTRIBUTES);
+		enc->map_start();
+		st.in_attrs = 1;
+	}
+}
+
+static void st_close_handle(void)
+{
+	if (!st.in_handle)
+		return;
+
+	st_flush_attr();
+	st_close_list();
+	if (st.in_attrs)
+		enc->close();
+	enc->close();
+	st.in_handle = st.in_attrs = 0;
+}
+
+static void st_message(enum pr_key key, const char *format, va_list args)
+{
+	st_close_handle();
+	st_record_start();
+	enc->key(key);
+	enc->string(st_format(format, args));
+	enc->close();
+}
+
+static void st_comment(const char *format, va_list args)
+{
+	st_message(KEY_COMMENT, format, args);
+}
+
+static void st_info(const char *format, va_list args)
+{
+	st_message(KEY_INFO, format, args);
+}
+
+static void st_file(const char *name)
+{
+	st_close_handle();
+	st_record_start();
+	enc->key(KEY_FILE);
+	enc->string(name);
+	enc->close();
+}
+
+static void st_handle(const struct dmi_header *h)
+{
+	st_close_handle();
+	st_record_start();
+	enc->key(KEY_HANDLE);
+	enc->uint(h->handle);
+	enc->key(KEY_TYPE);
+	enc->uint(h->type);
+	enc->key(KEY_LENGTH);
+	enc->uint(h->length);
+	st.in_handle = 1;
+}
+
+static void st_handle_name(const char *format, va_list args)
+{
+	if (!st.in_handle)
+	{
+		/* The handle is hidden in quiet mode */
+		st_record_start();
+		st.in_handle = 1;
+	}
+	else if (st.in_attrs)
+	{
+		/* Names only make sense before the attributes */
+		st_open_attrs();
+	}
+	enc->key(KEY_NAME);
+	enc->string(st_format(format, args));
+}
+
+static void st_attr_str(const char *name, const char *s)
+{
+	st_open_attrs();
+	st.pending = (st_save(&st.name, &st.name_size, name) == 0
+		&& st_save(&st.value, &st.value_size, s) == 0);
+}
+
+static void st_attr(const char *name, const char *format, va_list args)
+{
+	st_attr_str(name, st_format(format, args));
+}
+
+static void st_subattr_str(const char *name, const char *s)
+{
+	if (st.pending)
+	{
+		/* Turn the held back attribute into a map */
+		enc->attr_key(st.name);
+		enc->map_start();
+		enc->key(KEY_VALUE);
+		enc->string(st.value);
+		st.pending = 0;
+		st.in_subattrs = 1;
+	}
+
+	/* Without a parent attribute, keep it at the attribute level */
+	if (!st.in_subattrs)
+		st_open_attrs();
+	enc->attr_key(name);
+	enc->string(s);
+}
+
+static void st_subattr(const char *name, const char *format, va_list args)
+{
+	st_subattr_str(name, st_format(format, args));
+}
+
+static void st_list_start(const char *name, const char *format, va_list args)
+{
+	st_open_attrs();
+	enc->attr_key(name);
+	if (format)
+	{
+		enc->map_start();
+		enc->key(KEY_VALUE);
+		enc->string(st_format(format, args));
+		enc->key(KEY_ITEMS);
+		enc->array_start();
+		st.in_list = 2;
+	}
+	else
+	{
+		enc->array_start();
+		st.in_list = 1;
+	}
+}
+
+static void st_list_item_str(const char *s)
+{
+	if (!st.in_list)
+	{
+		/* Item without a list, make it an anonymous one */
+		st_open_attrs();
+		enc->key(KEY_ITEMS);
+		enc->array_start();
+		st.in_list = 1;
+	}
+	enc->string(s);
+}
+
+static void st_list_item(const char *format, va_list args)
+{
+	st_list_item_str(st_format(format, args));
+}
+
+static void st_list_end(void)
+{
+	st_close_list();
+}
+
+static void st_sep(void)
+{
+	st_close_handle();
+}
+
+static void st_struct_err(const char *format, va_list args)
+{
+	st_open_attrs();
+	enc->key(KEY_ERROR);
+	enc->string(st_format(format, args));
+}
+
+static void st_free(void)
+{
+	free(st.buf);
+	free(st.name);
+	free(st.value);
+	st.buf = st.name = st.value = NULL;
+	st.size = st.name_size = st.value_size = 0;
+	st.started = 0;
+}
+
+static void st_end(void)
+{
+	st_close_handle();
+	if (!st.started)
+		enc->doc_start();
+	enc->doc_end();
+	st_free();
+}
+
+static const struct pr_ops struct_ops = {
+	.comment = st_comment,
+	.info = st_info,
+	.file = st_file,
+	.handle = st_handle,
+	.handle_name = st_handle_name,
+	.attr = st_attr,
+	.attr_str = st_attr_str,
+	.subattr = st_subattr,
+	.subattr_str = st_subattr_str,
+	.list_start = st_list_start,
+	.list_item = st_list_item,
+	.list_item_str = st_list_item_str,
+	.list_end = st_list_end,
+	.sep = st_sep,
+	.struct_err = st_struct_err,
+	.end = st_end,
+};
+
+/*
+ * JSON encoder
+ *
+ * Top-level elements go on a line of their own, so that the output is
+ * still somewhat readable and easy to process with line-based tools.
+ */
+
+#define JSON_MAX_DEPTH	8
+
+static DMI_THREAD struct
+{
+	int depth;
+	int after_key;		/* Next value completes a map member */
+	int count[JSON_MAX_DEPTH];
+	char closer[JSON_MAX_DEPTH];
+} json;
+
+/* Write the separator which comes before a new element, if any */
+static void json_sep(void)
+{
+	if (json.after_key)
+	{
+		json.after_key = 0;
+		return;
+	}
+	if (json.count[json.depth]++)
+		out_puts(json.depth == 1 ? ",\n" : ", ");
+}
+
+static void json_open(char opener, char closer)
+{
+	json_sep();
+	out_putc(opener);
+	if (json.depth + 1 < JSON_MAX_DEPTH)
+		json.depth++;
+	json.count[json.depth] = 0;
+	json.closer[json.depth] = closer;
+}
+
+static void json_close(void)
+{
+	out_putc(json.closer[json.depth]);
+	if (json.depth > 0)
+		json.depth--;
+}
+
+/* Write s as a quoted JSON string */
+static void json_quote(const char *s)
+{
+	static const char hex[] = "0123456789abcdef";
+	const unsigned char *p = (const unsigned char *)s;
+
+	out_putc('"');
+	for (; *p; p++)
+	{
+		switch (*p)
+		{
+			case '"':
+				out_puts("\\\"");
+				break;
+			case '\\':
+				out_puts("\\\\");
+				break;
+			case '\n':
+				out_puts("\\n");
+				break;
+			case '\t':
+				out_puts("\\t");
+				break;
+			default:
+				if (*p < 0x20 || *p >= 0x7F)
+				{
+					out_puts("\\u00");
+					out_putc(hex[*p >> 4]);
+					out_putc(hex[*p & 0x0F]);
+				}
+				else
+					out_putc(*p);
+		}
+	}
+	out_putc('"');
+}
+
+static void json_doc_start(void)
+{
+	json.depth = 0;
+	json.after_key = 0;
+	json.count[0] = 0;
+	json_open('[', ']');
+	out_putc('\n');
+}
+
+/* Pick up after the last element of a document written by another thread */
+static void json_part_start(void)
+{
+	json.depth = 1;
+	json.after_key = 0;
+	json.count[1] = 1;
+	json.closer[1] = ']';
+}
+
+static void json_doc_end(void)
+{
+	if (json.count[json.depth])
+		out_putc('\n');
+	json_close();
+	out_putc('\n');
+}
+
+static void json_map_start(void)
+{
+	json_open('{', '}');
+}
+
+static void json_array_start(void)
+{
+	json_open('[', ']');
+}
+
+static void json_attr_key(const char *name)
+{
+	json_sep();
+	json_quote(name);
+	out_puts(": ");
+	json.after_key = 1;
+}
+
+static void json_key(enum pr_key key)
+{
+	json_attr_key(key_name[key]);
+}
+
+static void json_string(const char *s)
+{
+	json_sep();
+	json_quote(s);
+}
+
+static void json_uint(unsigned int v)
+{
+	char buf[FMT_SIZE], *p;
+
+	json_sep();
+	p = fmt_u32(buf + sizeof(buf), v);
+	out_write(p, buf + sizeof(buf) - p);
+}
+
+static const struct pr_encoder json_encoder = {
+	.doc_start = json_doc_start,
+	.doc_end = json_doc_end,
+	.part_start = json_part_start,
+	.map_start = json_map_start,
+	.array_start = json_array_start,
+	.close = json_close,
+	.key = json_key,
+	.attr_key = json_attr_key,
+	.string = json_string,
+	.uint = json_uint,
+};
+
+/*
+ * CBOR encoder (RFC 8949)
+ *
+ * Same document structure as JSON, but in binary form and with short
+ * keys: the structural keys (handle, type, name...) are small negative
+ * integers, and attribute names found in the attribute dictionary are
+ * replaced by their index in it. Attribute names which aren't in the
+ * dictionary (built at run time) are written as text strings.
+ *
+ * The document is tagged as CBOR (self-describe tag) and its first
+ * element is a header map identifying the dictionary, so that decoders
+ * can check that they have the right one. Maps and arrays use the
+ * indefinite-length encoding, so the output can be streamed.
+ */
+
+static const char *attr_dict[] = {
+#include "dmiattr.h"
+};
+
+#define ATTR_DICT_SIZE	(sizeof(attr_dict) / sizeof(attr_dict[0]))
+
+#define CBOR_UINT	0
+#define CBOR_NEGINT	1
+#define CBOR_TEXT	3
+#define CBOR_ARRAY	4
+#define CBOR_MAP	5
+#define CBOR_TAG	6
+#define CBOR_BREAK	0xFF
+#define CBOR_INDEFINITE	31
+#define CBOR_SELF_DESCRIBE	55799
+
+static void cbor_head(u8 major, u32 v)
+{
+	u8 buf[5];
+	size_t len;
+
+	if (v < 24)
+	{
+		buf[0] = major << 5 | v;
+		len = 1;
+	}
+	else if (v <= 0xFF)
+	{
+		buf[0] = major << 5 | 24;
+		buf[1] = v;
+		len = 2;
+	}
+	else if (v <= 0xFFFF)
+	{
+		buf[0] = major << 5 | 25;
+		buf[1] = v >> 8;
+		buf[2] = v;
+		len = 3;
+	}
+	else
+	{
+		buf[0] = major << 5 | 26;
+		buf[1] = v >> 24;
+		buf[2] = v >> 16;
+		buf[3] = v >> 8;
+		buf[4] = v;
+		len = 5;
+	}
+	out_write(buf, len);
+}
+
+static void cbor_text(const char *s)
+{
+	size_t len = strlen(s);
+
+	cbor_head(CBOR_TEXT, len);
+	out_write(s, len);
+}
+
+static int attr_dict_cmp(const void *key, const void *elem)
+{
+	return strcmp(key, *(const char * const *)elem);
+}
+
+/* Identifies the dictionary, so that decoders can tell if they have it */
+static u32 attr_dict_hash(void)
+{
+	u32 hash = 2166136261U;	/* FNV-1a */
+	size_t i;
+	const char *p;
+
+	for (i = 0; i < ATTR_DICT_SIZE; i++)
+	{
+		for (p = attr_dict[i]; *p; p++)
+			hash = (hash ^ (u8)*p) * 16777619U;
+		hash *= 16777619U;	/* Terminating NUL */
+	}
+	return hash;
+}
+
+static void cbor_doc_start(void)
+{
+	cbor_head(CBOR_TAG, CBOR_SELF_DESCRIBE);
+	out_putc(CBOR_ARRAY << 5 | CBOR_INDEFINITE);
+
+	cbor_head(CBOR_MAP, 3);
+	cbor_text("format");
+	cbor_text("dmidecode");
+	cbor_text("dictionary-size");
+	cbor_head(CBOR_UINT, ATTR_DICT_SIZE);
+	cbor_text("dictionary-hash");
+	cbor_head(CBOR_UINT, attr_dict_hash());
+}
+
+static void cbor_part_start(void)
+{
+	/* Array elements need no separator */
+}
+
+static void cbor_close(void)
+{
+	out_putc(CBOR_BREAK);
+}
+
+static void cbor_map_start(void)
+{
+	out_putc(CBOR_MAP << 5 | CBOR_INDEFINITE);
+}
+
+static void cbor_array_start(void)
+{
+	out_putc(CBOR_ARRAY << 5 | CBOR_INDEFINITE);
+}
+
+/* Structural key n is written as integer -1 - n */
+static void cbor_key(enum pr_key key)
+{
+	cbor_head(CBOR_NEGINT, key);
+}
+
+/* Index of an attribute name in the dictionary, -1 if it isn't in it */
+int pr_attr_lookup(const char *name)
+{
+	const char **p;
+
+	p = bsearch(name, attr_dict, ATTR_DICT_SIZE, sizeof(attr_dict[0]),
+		    attr_dict_cmp);
+	return p != NULL ? p - attr_dict : -1;
+}
+
+unsigned int pr_attr_count(void)
+{
+	return ATTR_DICT_SIZE;
+}
+
+static void cbor_attr_key(const char *name)
+{
+	int i = pr_attr_lookup(name);
+
+	if (i >= 0)
+		cbor_head(CBOR_UINT, i);
+	else
+		cbor_text(name);
+}
+
+static void cbor_uint(unsigned int v)
+{
+	cbor_head(CBOR_UINT, v);
+}
+
+static const struct pr_encoder cbor_encoder = {
+	.doc_start = cbor_doc_start,
+	.doc_end = cbor_close,
+	.part_start = cbor_part_start,
+	.map_start = cbor_map_start,
+	.array_start = cbor_array_start,
+	.close = cbor_close,
+	.key = cbor_key,
+	.attr_key = cbor_attr_key,
+	.string = cbor_text,
+	.uint = cbor_uint,
+};
+
+/*
+ * Print the attribute dictionary, one name per line, preceded by its
+ * index. This is what CBOR decoders need to map keys back to names.
+ */
+void pr_dictionary(void)
+{
+	size_t i;
+
+	printf("# dictionary-size %u\n", (unsigned int)ATTR_DICT_SIZE);
+	printf("# dictionary-hash %u\n", attr_dict_hash());
+	for (i = 0; i < ATTR_DICT_SIZE; i++)
+		printf("%u\t%s\n", (unsigned int)i, attr_dict[i]);
+}
+
+static DMI_THREAD const struct pr_ops *ops = &text_ops;
+
+/*
+ * Attribute selection (--query): a bitmap of the selected attributes,
+ * indexed like the attribute dictionary. Other attributes are dropped
+ * before they are formatted, along with their sub-attributes or items.
+ *
+ * Attribute names are string literals, so their dictionary index is
+ * remembered by address, and each call site only pays for the lookup
+ * once.
+ *
+ * The handle and name of a structure are held back until one of its
+ * attributes is selected, so that structures with none of the selected
+ * attributes don't show at all.
+ */
+#define SELECT_CACHE_SIZE	512
+
+static DMI_THREAD const u32 *selection;
+static DMI_THREAD int attr_shown = 1, list_shown = 1;
+static DMI_THREAD struct
+{
+	const char *name;
+	int index;
+} select_cache[SELECT_CACHE_SIZE];
+static DMI_THREAD struct
+{
+	int handle;			/* pr_handle() called */
+	struct dmi_header h;
+	int name;			/* pr_handle_name() called */
+	char name_buf[128];
+	int shown;			/* Something of the record is shown */
+} held;
+
+static int pr_selected(const char *name)
+{
+	unsigned int slot;
+	int i;
+
+	if (selection == NULL)
+		return 1;
+
+	slot = ((unsigned long)name >> 2) % SELECT_CACHE_SIZE;
+	if (select_cache[slot].name == name)
+		i = select_cache[slot].index;
+	else
+	{
+		i = pr_attr_lookup(name);
+		select_cache[slot].name = name;
+		select_cache[slot].index = i;
+	}
+	return i >= 0 && (selection[i / 32] & (1U << (i % 32)));
+}
+
+/*
+ * Whether an attribute would be displayed, so that the decoder can skip
+ * the work for those which wouldn't.
+ */
+int pr_wanted(const char *name)
+{
+	return pr_selected(name);
+}
+
+static void ops_handle_name(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	ops->handle_name(format, args);
+	va_end(args);
+}
+
+/* Something of the current record is shown, so it starts now */
+static void pr_release(void)
+{
+	if (held.shown)
+		return;
+	held.shown = 1;
+	if (held.handle)
+		ops->handle(&held.h);
+	if (held.name)
+		ops_handle_name("%s", held.name_buf);
+}
+
+/* NULL selects all attributes */
+void pr_select(const u32 *mask)
+{
+	selection = mask;
+	attr_shown = list_shown = 1;
+	held.handle = held.name = held.shown = 0;
+}
+
+/*
+ * Select the output format. Must be called before anything is printed.
+ */
+void pr_init(enum pr_format format)
+{
+	struct stat st_out, st_err;
+
+	switch (format)
+	{
+		case PR_FORMAT_JSON:
+		case PR_FORMAT_CBOR:
+			ops = &struct_ops;
+			enc = format == PR_FORMAT_JSON ?
+				&json_encoder : &cbor_encoder;
+			break;
+		default:
+			ops = &text_ops;
+	}
+
+	/* From now on, stdio must not be used to write to stdout */
+	fflush(stdout);
+
+	/*
+	 * Messages on stderr only need to be kept in order with the
+	 * output if both end up in the same place.
+	 */
+	out.sync = fstat(STDOUT_FILENO, &st_out) != 0
+		|| fstat(STDERR_FILENO, &st_err) != 0
+		|| (st_out.st_dev == st_err.st_dev
+		 && st_out.st_ino == st_err.st_ino);
+}
+
+/* Terminate the output document, if the format needs it, and write it */
+void pr_end(void)
+{
+	ops->end();
+	out_flush();
+	out_free();
+}
+
+/*
+ * Sync point: write out everything buffered so far, before something
+ * is written to stderr. This is a no-op if stdout and stderr are not
+ * the same file.
+ */
+void pr_sync(void)
+{
+	if (out.sync)
+		out_flush();
+}
+
+/* Write out everything buffered so far, before waiting for something */
+void pr_flush(void)
+{
+	out_flush();
+}
+
+/* Write calls made and bytes written to stdout so far */
+void pr_counters(unsigned long *writes, unsigned long long *written)
+{
+	*writes = out.writes;
+	*written = out.written;
+}
+
+/* Stop capturing, and hand over the captured data */
+static char *out_capture_end(size_t *len)
+{
+	char *p;
+
+	out_flush();
+	out_free();
+
+	p = out.capture_buf;
+	*len = out.capture_len;
+	out.capture_buf = NULL;
+	out.capture_len = out.capture_size = 0;
+	out.capture = out.error = 0;
+
+	return p;
+}
+
+/*
+ * Batch mode: capture the output of one file, to be inserted later with
+ * pr_write() in the main document, after its pr_file() record.
+ * pr_part_end() returns the captured data, which the caller must free.
+ */
+void pr_part_start(void)
+{
+	out.capture = 1;
+	if (ops == &struct_ops)
+	{
+		st.started = 1;
+		enc->part_start();
+	}
+}
+
+char *pr_part_end(size_t *len)
+{
+	if (ops == &struct_ops)
+	{
+		st_close_handle();
+		st_free();
+	}
+
+	return out_capture_end(len);
+}
+
+/*
+ * Batch mode: error messages written while decoding a part. If stdout and
+ * stderr are the same file, they go in the part itself, at the same place
+ * as with dmidecode. Otherwise they are kept aside, and pr_part_errors()
+ * returns them, the caller must free them.
+ */
+void pr_part_error(const char *buf, size_t len)
+{
+	size_t size;
+	char *p;
+
+	if (out.sync)
+	{
+		out_write(buf, len);
+		return;
+	}
+
+	if (out.err_size - out.err_len < len)
+	{
+		size = out.err_size ? out.err_size : 256;
+		while (size - out.err_len < len)
+			size *= 2;
+		p = realloc(out.err_buf, size);
+		if (p == NULL)
+			return;
+		out.err_buf = p;
+		out.err_size = size;
+	}
+	memcpy(out.err_buf + out.err_len, buf, len);
+	out.err_len += len;
+}
+
+char *pr_part_errors(size_t *len)
+{
+	char *p = out.err_buf;
+
+	*len = out.err_len;
+	out.err_buf = NULL;
+	out.err_len = out.err_size = 0;
+
+	return p;
+}
+
+/*
+ * Daemon mode: capture a whole document, to be sent to a client.
+ * Everything written so far goes to stdout first. pr_capture_end()
+ * terminates the document and returns it, the caller must free it.
+ */
+void pr_capture_start(void)
+{
+	out_flush();
+	out.capture = 1;
+}
+
+char *pr_capture_end(size_t *len)
+{
+	ops->end();
+
+	return out_capture_end(len);
+}
+
+/* Raw data, as returned by pr_part_end() */
+void pr_write(const void *buf, size_t len)
+{
+	out_write(buf, len);
+}
+
+/* Raw text, regardless of the output format */
+void pr_text(const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	out_vprintf(format, args);
+	va_end(args);
+}
+
 void pr_comment(const char *format, ...)
 {
 	va_list args;
 
-	printf("# ");
 	va_start(args, format);
-	vprintf(format, args);
+	ops->comment(format, args);
 	va_end(args);
-	printf("\n");
 }
 
 void pr_info(const char *format, ...)
@@ -39,15 +1539,26 @@ void pr_info(const char *format, ...)
 	va_list args;
 
 	va_start(args, format);
-	vprintf(format, args);
+	ops->info(format, args);
 	va_end(args);
-	printf("\n");
+}
+
+/* Start of the data read from another file, in batch mode */
+void pr_file(const char *name)
+{
+	ops->file(name);
 }
 
 void pr_handle(const struct dmi_header *h)
 {
-	printf("Handle 0x%04X, DMI type %d, %d bytes\n",
-	       h->handle, h->type, h->length);
+	if (selection != NULL)
+	{
+		held.h = *h;
+		held.handle = 1;
+		return;
+	}
+
+	ops->handle(h);
 }
 
 void pr_handle_name(const char *format, ...)
@@ -55,83 +1566,180 @@ void pr_handle_name(const char *format, ...)
 	va_list args;
 
 	va_start(args, format);
-	vprintf(format, args);
+	if (selection != NULL)
+	{
+		vsnprintf(held.name_buf, sizeof(held.name_buf), format, args);
+		held.name = 1;
+	}
+	else
+		ops->handle_name(format, args);
 	va_end(args);
-	printf("\n");
 }
 
 void pr_attr(const char *name, const char *format, ...)
 {
 	va_list args;
 
-	printf("\t%s: ", name);
+	if (!(attr_shown = pr_selected(name)))
+		return;
+	if (selection != NULL)
+		pr_release();
 
 	va_start(args, format);
-	vprintf(format, args);
+	ops->attr(name, format, args);
 	va_end(args);
-	printf("\n");
+}
+
+/*
+ * Typed attributes: same as pr_attr() with "%s", "%u", "0x%02X", "0x%04X",
+ * "0x%08X" and "%u %s" (value and unit) respectively, but without
+ * parsing a format string
+ */
+void pr_attr_str(const char *name, const char *s)
+{
+	if (!(attr_shown = pr_selected(name)))
+		return;
+	if (selection != NULL)
+		pr_release();
+
+	ops->attr_str(name, s);
+}
+
+void pr_attr_u32(const char *name, u32 v)
+{
+	char buf[FMT_SIZE];
+
+	buf[FMT_SIZE - 1] = '\0';
+	pr_attr_str(name, fmt_u32(buf + FMT_SIZE - 1, v));
+}
+
+void pr_attr_hex8(const char *name, u8 v)
+{
+	char buf[FMT_SIZE];
+
+	buf[FMT_SIZE - 1] = '\0';
+	pr_attr_str(name, fmt_hex(buf + FMT_SIZE - 1, v, 2));
+}
+
+void pr_attr_hex16(const char *name, u16 v)
+{
+	char buf[FMT_SIZE];
+
+	buf[FMT_SIZE - 1] = '\0';
+	pr_attr_str(name, fmt_hex(buf + FMT_SIZE - 1, v, 4));
+}
+
+void pr_attr_hex32(const char *name, u32 v)
+{
+	char buf[FMT_SIZE];
+
+	buf[FMT_SIZE - 1] = '\0';
+	pr_attr_str(name, fmt_hex(buf + FMT_SIZE - 1, v, 8));
+}
+
+void pr_attr_size(const char *name, u32 v, const char *unit)
+{
+	char buf[FMT_SIZE + 16], *p;
+	size_t len = strlen(unit);
+
+	/* Units are short, but don't take chances */
+	if (len >= sizeof(buf) - FMT_SIZE)
+	{
+		pr_attr(name, "%u %s", v, unit);
+		return;
+	}
+
+	p = fmt_u32(buf + FMT_SIZE - 1, v);
+	buf[FMT_SIZE - 1] = ' ';
+	memcpy(buf + FMT_SIZE, unit, len + 1);
+	pr_attr_str(name, p);
 }
 
 void pr_subattr(const char *name, const char *format, ...)
 {
 	va_list args;
 
-	printf("\t\t%s: ", name);
+	if (!attr_shown)
+		return;
 
 	va_start(args, format);
-	vprintf(format, args);
+	ops->subattr(name, format, args);
 	va_end(args);
-	printf("\n");
+}
+
+void pr_subattr_str(const char *name, const char *s)
+{
+	if (!attr_shown)
+		return;
+
+	ops->subattr_str(name, s);
+}
+
+void pr_subattr_u32(const char *name, u32 v)
+{
+	char buf[FMT_SIZE];
+
+	buf[FMT_SIZE - 1] = '\0';
+	pr_subattr_str(name, fmt_u32(buf + FMT_SIZE - 1, v));
 }
 
 void pr_list_start(const char *name, const char *format, ...)
 {
 	va_list args;
 
-	printf("\t%s:", name);
-
-	/* format is optional, skip value if not provided */
-	if (format)
-	{
-		printf(" ");
-		va_start(args, format);
-		vprintf(format, args);
-		va_end(args);
-	}
-	printf("\n");
+	if (!(list_shown = pr_selected(name)))
+		return;
+	if (selection != NULL)
+		pr_release();
 
+	va_start(args, format);
+	ops->list_start(name, format, args);
+	va_end(args);
 }
 
 void pr_list_item(const char *format, ...)
 {
 	va_list args;
 
-	printf("\t\t");
+	if (!list_shown)
+		return;
 
 	va_start(args, format);
-	vprintf(format, args);
+	ops->list_item(format, args);
 	va_end(args);
-	printf("\n");
+}
+
+void pr_list_item_str(const char *s)
+{
+	if (!list_shown)
+		return;
+
+	ops->list_item_str(s);
 }
 
 void pr_list_end(void)
 {
-	/* a no-op for text output */
+	if (list_shown)
+		ops->list_end();
 }
 
 void pr_sep(void)
 {
-	printf("\n");
+	/* Nothing of the record was selected */
+	if (selection != NULL && !held.shown)
+		return;
+
+	ops->sep();
 }
 
 void pr_struct_err(const char *format, ...)
 {
 	va_list args;
 
-	printf("\t");
+	if (selection != NULL)
+		pr_release();
 
 	va_start(args, format);
-	vprintf(format, args);
+	ops->struct_err(format, args);
 	va_end(args);
-	printf("\n");
 }
@@ -19,16 +19,52 @@
  *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
  */
 
+#include <stddef.h>
 #include "dmidecode.h"
 
+enum pr_format
+{
+	PR_FORMAT_TEXT,
+	PR_FORMAT_JSON,
+	PR_FORMAT_CBOR,
+};
+
+void pr_init(enum pr_format format);
+void pr_end(void);
+void pr_sync(void);
+void pr_flush(void);
+void pr_counters(unsigned long *writes, unsigned long long *written);
+void pr_part_start(void);
+char *pr_part_end(size_t *len);
+void pr_part_error(const char *buf, size_t len);
+char *pr_part_errors(size_t *len);
+void pr_capture_start(void);
+char *pr_capture_end(size_t *len);
+void pr_write(const void *buf, size_t len);
+void pr_text(const char *format, ...);
+void pr_dictionary(void);
+int pr_attr_lookup(const char *name);
+unsigned int pr_attr_count(void);
+void pr_select(const u32 *mask);
+int pr_wanted(const char *name);
 void pr_comment(const char *format, ...);
 void pr_info(const char *format, ...);
+void pr_file(const char *name);
 void pr_handle(const struct dmi_header *h);
 void pr_handle_name(const char *format, ...);
 void pr_attr(const char *name, const char *format, ...);
+void pr_attr_str(const char *name, const char *s);
+void pr_attr_u32(const char *name, u32 v);
+void pr_attr_hex8(const char *name, u8 v);
+void pr_attr_hex16(const char *name, u16 v);
+void pr_attr_hex32(const char *name, u32 v);
+void pr_attr_size(const char *name, u32 v, const char *unit);
 void pr_subattr(const char *name, const char *format, ...);
+void pr_subattr_str(const char *name, const char *s);
+void pr_subattr_u32(const char *name, u32 v);
 void pr_list_start(const char *name, const char *format, ...);
 void pr_list_item(const char *format, ...);
+void pr_list_item_str(const char *s);
 void pr_list_end(void);
 void pr_sep(void);
 void pr_struct_err(const char *format, ...);
@@ -0,0 +1,626 @@
+/*
+ * Daemon mode of dmidecode (--serve)
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * The table is read and indexed once, then each client connecting to the
+ * Unix socket sends one request, which is a line holding output options
+ * of the command line (such as "-s system-uuid" or "-t memory --format
+ * json"). The answer is what dmidecode would display with these options,
+ * then the connection is closed. Requests are answered one at a time,
+ * from the table in memory, but an event loop takes care of the
+ * connections so that slow clients don't hold back the others. Clients
+ * which aren't done within SERVE_TIMEOUT seconds are disconnected.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "types.h"
+#include "dmiopt.h"
+#include "dmioutput.h"
+#include "dmiserve.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <grp.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define SERVE_MAX_CLIENTS	256
+#define SERVE_MAX_EVENTS	64
+#define SERVE_MAX_ARGS		64
+#define SERVE_REQUEST_SIZE	4096
+#define SERVE_ERROR_SIZE	4096
+#define SERVE_TIMEOUT		10	/* Seconds per client */
+
+struct serve_client
+{
+	int fd;
+	time_t deadline;		/* Closed if not done by then */
+	char *answer;
+	size_t answer_len;
+	size_t answer_sent;
+	size_t req_len;
+	char req[SERVE_REQUEST_SIZE];
+	struct serve_client *prev, *next;
+};
+
+static struct
+{
+	void (*answer)(void *data);
+	void *data;
+	struct opt base;		/* Options of the daemon */
+	struct serve_client *clients;
+	unsigned int count;
+} serve;
+
+static volatile sig_atomic_t serve_stop;
+
+static void serve_signal(int sig)
+{
+	(void)sig;
+	serve_stop = 1;
+}
+
+/*
+ * Split a request into arguments. Arguments are separated by blanks, and
+ * can be quoted with single or double quotes. Returns the number of
+ * arguments, -1 on error.
+ */
+static int serve_split(char *line, char *argv[], int max)
+{
+	static char progname[] = "dmidecode";
+	char *p = line, *q;
+	char quote;
+	int argc = 0;
+
+	argv[argc++] = progname;
+	for (;;)
+	{
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '\0')
+			break;
+		if (argc == max - 1)
+			return -1;
+
+		argv[argc++] = q = p;
+		quote = 0;
+		while (*p != '\0' && (quote || (*p != ' ' && *p != '\t')))
+		{
+			if (quote ? *p == quote : (*p == '\'' || *p == '"'))
+				quote = quote ? 0 : *p;
+			else
+				*q++ = *p;
+			p++;
+		}
+		if (quote)
+			return -1;
+		if (*p != '\0')
+			p++;
+		*q = '\0';
+	}
+	argv[argc] = NULL;
+
+	return argc;
+}
+
+/* Answer the client with an error message */
+static void serve_error(struct serve_client *c, const char *msg)
+{
+	c->answer = strdup(msg);
+	if (c->answer == NULL)
+		perror("strdup");
+	else
+		c->answer_len = strlen(c->answer);
+}
+
+/*
+ * Error messages are written to stderr, which is redirected to a pipe
+ * while answering a request, so that they go to the client rather than
+ * to the daemon's stderr. Messages which don't fit in the pipe are
+ * dropped, not waited for.
+ */
+struct serve_stderr
+{
+	int pipe[2];
+	int saved;		/* The daemon's stderr, -1 if not redirected */
+};
+
+static void serve_stderr_start(struct serve_stderr *e)
+{
+	e->saved = -1;
+	if (pipe(e->pipe) != 0)
+	{
+		perror("pipe");
+		return;
+	}
+	if (fcntl(e->pipe[0], F_SETFL, O_NONBLOCK) != 0
+	 || fcntl(e->pipe[1], F_SETFL, O_NONBLOCK) != 0)
+	{
+		perror("fcntl");
+		goto out_close;
+	}
+
+	fflush(stderr);
+	e->saved = dup(STDERR_FILENO);
+	if (e->saved == -1)
+		goto out_close;
+	if (dup2(e->pipe[1], STDERR_FILENO) == -1)
+	{
+		close(e->saved);
+		e->saved = -1;
+		goto out_close;
+	}
+	return;
+
+out_close:
+	close(e->pipe[0]);
+	close(e->pipe[1]);
+}
+
+/* Restore stderr, and return what was written to it (nul-terminated) */
+static size_t serve_stderr_end(struct serve_stderr *e, char *buf, size_t size)
+{
+	size_t len = 0;
+	ssize_t n;
+
+	if (e->saved == -1)
+		return 0;
+
+	fflush(stderr);
+	dup2(e->saved, STDERR_FILENO);
+	close(e->saved);
+	close(e->pipe[1]);
+	while (len < size - 1
+	    && (n = read(e->pipe[0], buf + len, size - 1 - len)) > 0)
+		len += n;
+	close(e->pipe[0]);
+	buf[len] = '\0';
+
+	return len;
+}
+
+/* Decode the table as the client requested, into c->answer */
+static void serve_answer(struct serve_client *c)
+{
+	char *argv[SERVE_MAX_ARGS];
+	char msg[SERVE_ERROR_SIZE], *p;
+	struct serve_stderr e;
+	size_t n;
+	int argc;
+
+	argc = serve_split(c->req, argv, SERVE_MAX_ARGS);
+	if (argc < 0)
+	{
+		serve_error(c, "Invalid request: unbalanced quotes or too many arguments\n");
+		goto out;
+	}
+
+	/* The client gets the error messages, as dmidecode would print them */
+	serve_stderr_start(&e);
+	if (parse_request(argc, argv) < 0)
+	{
+		if (serve_stderr_end(&e, msg, sizeof(msg)) == 0)
+			strcpy(msg, "Invalid request\n");
+		serve_error(c, msg);
+		goto out;
+	}
+
+	pr_init(opt.format);
+	pr_capture_start();
+	serve.answer(serve.data);
+	c->answer = pr_capture_end(&c->answer_len);
+
+	/* Messages come last, as when the output goes to a pipe */
+	n = serve_stderr_end(&e, msg, sizeof(msg));
+	if (n != 0 && c->answer != NULL)
+	{
+		p = realloc(c->answer, c->answer_len + n);
+		if (p == NULL)
+			perror("realloc");
+		else
+		{
+			memcpy(p + c->answer_len, msg, n);
+			c->answer = p;
+			c->answer_len += n;
+		}
+	}
+
+out:
+	free(opt.type);
+	free(opt.string);
+	free(opt.query);
+	opt = serve.base;
+}
+
+/* Returns 1 when done with the client, 0 if there's more to send */
+static int serve_send(struct serve_client *c)
+{
+	ssize_t n;
+
+	while (c->answer_sent < c->answer_len)
+	{
+		n = send(c->fd, c->answer + c->answer_sent,
+			 c->answer_len - c->answer_sent, MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : 1;
+		}
+		c->answer_sent += n;
+	}
+
+	return 1;
+}
+
+/* Returns 1 when done with the client, 0 if it must be waited for */
+static int serve_read(struct serve_client *c)
+{
+	ssize_t n;
+	char *end;
+
+	n = read(c->fd, c->req + c->req_len, sizeof(c->req) - 1 - c->req_len);
+	if (n < 0)
+		return errno == EAGAIN || errno == EINTR ? 0 : 1;
+	if (n == 0 && c->req_len == 0)
+		return 1;
+	c->req_len += n;
+	c->req[c->req_len] = '\0';
+
+	/* The request ends at the first new line, or when the client stops */
+	end = memchr(c->req, '\n', c->req_len);
+	if (end != NULL)
+	{
+		if (end > c->req && end[-1] == '\r')
+			end--;
+		*end = '\0';
+	}
+	else if (n != 0)
+	{
+		if (c->req_len < sizeof(c->req) - 1)
+			return 0;
+		c->req[0] = '\0';
+		c->req_len = 0;
+		serve_error(c, "Invalid request: too long\n");
+		if (c->answer == NULL)
+			return 1;
+		return serve_send(c);
+	}
+
+	serve_answer(c);
+	if (c->answer == NULL)
+		return 1;
+
+	return serve_send(c);
+}
+
+static void serve_close(int efd, struct serve_client *c)
+{
+	epoll_ctl(efd, EPOLL_CTL_DEL, c->fd, NULL);
+	close(c->fd);
+	free(c->answer);
+
+	if (c->prev != NULL)
+		c->prev->next = c->next;
+	else
+		serve.clients = c->next;
+	if (c->next != NULL)
+		c->next->prev = c->prev;
+	serve.count--;
+	free(c);
+}
+
+static time_t serve_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec;
+}
+
+/* Close the connections of clients which took too long */
+static void serve_expire(int efd)
+{
+	struct serve_client *c, *next;
+	time_t now = serve_now();
+
+	for (c = serve.clients; c != NULL; c = next)
+	{
+		next = c->next;
+		if (now >= c->deadline)
+			serve_close(efd, c);
+	}
+}
+
+static void serve_accept(int efd, int sfd)
+{
+	struct serve_client *c;
+	struct epoll_event ev;
+	int fd;
+
+	while ((fd = accept(sfd, NULL, NULL)) >= 0)
+	{
+		if (serve.count == SERVE_MAX_CLIENTS)
+		{
+			close(fd);
+			continue;
+		}
+
+		c = calloc(1, sizeof(struct serve_client));
+		if (c == NULL)
+		{
+			perror("calloc");
+			close(fd);
+			continue;
+		}
+		c->fd = fd;
+		c->deadline = serve_now() + SERVE_TIMEOUT;
+
+		ev.events = EPOLLIN;
+		ev.data.ptr = c;
+		if (fcntl(fd, F_SETFL, O_NONBLOCK) != 0
+		 || fcntl(fd, F_SETFD, FD_CLOEXEC) != 0
+		 || epoll_ctl(efd, EPOLL_CTL_ADD, fd, &ev) != 0)
+		{
+			perror("accept");
+			close(fd);
+			free(c);
+			continue;
+		}
+
+		c->next = serve.clients;
+		if (c->next != NULL)
+			c->next->prev = c;
+		serve.clients = c;
+		serve.count++;
+	}
+
+	if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		perror("accept");
+}
+
+/*
+ * Remove a socket file left over by a previous instance, but not one
+ * which is still in use. Returns 1 if it was removed.
+ */
+static int serve_unlink_stale(const struct sockaddr_un *addr)
+{
+	struct stat st;
+	int fd, stale;
+
+	if (lstat(addr->sun_path, &st) != 0 || !S_ISSOCK(st.st_mode))
+		goto in_use;
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		goto in_use;
+	stale = connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) != 0
+		&& errno == ECONNREFUSED;
+	close(fd);
+	if (stale && unlink(addr->sun_path) == 0)
+		return 1;
+
+in_use:
+	errno = EADDRINUSE;
+	return 0;
+}
+
+/*
+ * Create the listening socket. Clients can query serial numbers and such,
+ * so by default only the owner can connect (see --serve-mode and
+ * --serve-group).
+ */
+static int serve_listen(const char *path)
+{
+	struct sockaddr_un addr;
+	struct group *gr = NULL;
+	mode_t mask;
+	int fd, ret;
+
+	if (opt.sockgroup != NULL)
+	{
+		errno = 0;
+		gr = getgrnam(opt.sockgroup);
+		if (gr == NULL)
+		{
+			if (errno)
+				perror("getgrnam");
+			else
+				fprintf(stderr, "%s: Unknown group\n", opt.sockgroup);
+			return -1;
+		}
+	}
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+	{
+		fprintf(stderr, "%s: Socket path too long\n", path);
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+	{
+		perror("socket");
+		return -1;
+	}
+
+	/* The socket must never be more open than requested, even briefly */
+	mask = umask(~opt.sockmode & 0777);
+	ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+	if (ret != 0 && errno == EADDRINUSE && serve_unlink_stale(&addr))
+		ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+	umask(mask);
+	if (ret != 0)
+	{
+		fprintf(stderr, "%s: ", path);
+		perror("bind");
+		close(fd);
+		return -1;
+	}
+
+	if ((gr != NULL && chown(path, -1, gr->gr_gid) != 0)
+	 || chmod(path, opt.sockmode) != 0 || listen(fd, SOMAXCONN) != 0)
+	{
+		fprintf(stderr, "%s: ", path);
+		perror("listen");
+		close(fd);
+		unlink(path);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+ * Answer the requests of clients, until SIGINT or SIGTERM is received.
+ * answer() displays the table as requested by the options, data is
+ * passed to it. Returns -1 on error, 0 otherwise.
+ */
+int dmi_serve(const char *path, void (*answer)(void *data), void *data)
+{
+	struct epoll_event ev, events[SERVE_MAX_EVENTS];
+	struct sigaction sa, old_int, old_term;
+	struct serve_client *c;
+	int sfd, efd, n, i, done;
+	int ret = -1;
+
+	serve.answer = answer;
+	serve.data = data;
+	serve.base = opt;
+	serve.base.flags &= ~FLAG_QUIET;
+
+	sfd = serve_listen(path);
+	if (sfd == -1)
+		return -1;
+
+	efd = epoll_create1(EPOLL_CLOEXEC);
+	if (efd == -1)
+	{
+		perror("epoll_create1");
+		goto out_close;
+	}
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &ev) != 0)
+	{
+		perror("epoll_ctl");
+		goto out_close;
+	}
+
+	/* No SA_RESTART, so that epoll_wait() returns */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = serve_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, &old_int);
+	sigaction(SIGTERM, &sa, &old_term);
+
+	if (!(opt.flags & FLAG_QUIET))
+		pr_info("Serving requests on %s.", path);
+	pr_flush();
+	opt = serve.base;
+
+	while (!serve_stop)
+	{
+		/* Wake up every second to expire clients, if there are any */
+		n = epoll_wait(efd, events, SERVE_MAX_EVENTS,
+			       serve.clients != NULL ? 1000 : -1);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("epoll_wait");
+			goto out_signal;
+		}
+
+		for (i = 0; i < n; i++)
+		{
+			c = events[i].data.ptr;
+			if (c == NULL)
+			{
+				serve_accept(efd, sfd);
+				continue;
+			}
+
+			if (c->answer == NULL)
+			{
+				done = serve_read(c);
+				if (!done && c->answer != NULL)
+				{
+					/* Send the rest when the client is ready */
+					ev.events = EPOLLOUT;
+					ev.data.ptr = c;
+					if (epoll_ctl(efd, EPOLL_CTL_MOD, c->fd, &ev) != 0)
+						done = 1;
+				}
+			}
+			else
+				done = serve_send(c);
+
+			if (done)
+				serve_close(efd, c);
+		}
+
+		/* So that idle clients can't hold all the slots */
+		serve_expire(efd);
+	}
+	ret = 0;
+
+out_signal:
+	sigaction(SIGINT, &old_int, NULL);
+	sigaction(SIGTERM, &old_term, NULL);
+	while (serve.clients != NULL)
+		serve_close(efd, serve.clients);
+out_close:
+	if (efd != -1)
+		close(efd);
+	close(sfd);
+	unlink(path);
+
+	/* Back to the output format of the daemon */
+	pr_init(opt.format);
+
+	return ret;
+}
+
+#else /* __linux__ */
+
+int dmi_serve(const char *path, void (*answer)(void *data), void *data)
+{
+	(void)path;
+	(void)answer;
+	(void)data;
+
+	fprintf(stderr, "Option --serve is only supported on Linux\n");
+	return -1;
+}
+
+#endif /* __linux__ */
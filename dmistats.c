@@ -0,0 +1,250 @@
+/*
+ * Run-time statistics of dmidecode (--stats)
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * Time is measured with the monotonic clock and charged to the current
+ * phase: the main program switches phases as it goes, from looking for
+ * the entry point to writing out the output. Output written while
+ * decoding, when the output buffer fills up, is charged to decoding.
+ * The decoding time of each structure is also added up per type.
+ * Resource usage comes from getrusage(), and output counters from the
+ * output layer. Everything is printed to stderr at the end.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include "types.h"
+#include "dmioutput.h"
+#include "dmistats.h"
+
+static const char *phase_name[STATS_PHASES] = {
+	"Entry Point",
+	"Table Read",
+	"Index",
+	"Decode",
+	"Output",
+};
+
+static const char *phase_key[STATS_PHASES] = {
+	"entry_point",
+	"table_read",
+	"index",
+	"decode",
+	"output",
+};
+
+struct stats_type
+{
+	unsigned int count;
+	unsigned long long bytes;
+	unsigned long long ns;
+};
+
+/*
+ * Only dmidecode --stats starts the statistics. The decoder calls the
+ * functions below regardless, including from the worker threads of
+ * dmidecode-batch, so they must not touch anything until then.
+ */
+static struct
+{
+	int started;
+	enum dmi_stats_phase phase;
+	unsigned long long mark;	/* When the current phase started */
+	unsigned long long ns[STATS_PHASES];
+	unsigned long long read;	/* Bytes read or mapped */
+	struct stats_type type[256];
+} stats;
+
+/* Monotonic time in nanoseconds */
+unsigned long long dmi_stats_now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		return 0;
+
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void dmi_stats_start(void)
+{
+	stats.started = 1;
+	stats.phase = STATS_ENTRY_POINT;
+	stats.mark = dmi_stats_now();
+}
+
+/* Charge the time elapsed so far to the current phase, and switch */
+void dmi_stats_phase(enum dmi_stats_phase phase)
+{
+	unsigned long long now;
+
+	if (!stats.started)
+		return;
+
+	now = dmi_stats_now();
+	stats.ns[stats.phase] += now - stats.mark;
+	stats.mark = now;
+	stats.phase = phase;
+}
+
+void dmi_stats_read(size_t len)
+{
+	if (!stats.started)
+		return;
+
+	stats.read += len;
+}
+
+void dmi_stats_type(u8 type, u32 size, unsigned long long ns)
+{
+	if (!stats.started)
+		return;
+
+	stats.type[type].count++;
+	stats.type[type].bytes += size;
+	stats.type[type].ns += ns;
+}
+
+/* Nanoseconds as milliseconds, with 3 decimals */
+static void print_ms(const char *format, unsigned long long ns)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%llu.%03llu", ns / 1000000,
+		 (ns / 1000) % 1000);
+	fprintf(stderr, format, buf);
+}
+
+static unsigned long long tv_ns(const struct timeval *tv)
+{
+	return (unsigned long long)tv->tv_sec * 1000000000ULL
+		+ tv->tv_usec * 1000ULL;
+}
+
+static void print_text(const struct rusage *ru, unsigned long writes,
+		       unsigned long long written,
+		       const char *(*type_name)(u8 type))
+{
+	unsigned long long total = 0;
+	int i;
+
+	fprintf(stderr, "# Statistics\n");
+	fprintf(stderr, "%-12s %12s\n", "Phase", "Time (ms)");
+	for (i = 0; i < STATS_PHASES; i++)
+	{
+		fprintf(stderr, "%-12s ", phase_name[i]);
+		print_ms("%12s\n", stats.ns[i]);
+		total += stats.ns[i];
+	}
+	fprintf(stderr, "%-12s ", "Total");
+	print_ms("%12s\n", total);
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "Bytes read: %llu\n", stats.read);
+	fprintf(stderr, "Bytes written: %llu in %lu write calls\n",
+		written, writes);
+	if (ru != NULL)
+	{
+		print_ms("CPU time: %s ms user, ", tv_ns(&ru->ru_utime));
+		print_ms("%s ms system\n", tv_ns(&ru->ru_stime));
+		fprintf(stderr, "Maximum resident set size: %ld kB\n",
+			ru->ru_maxrss);
+		fprintf(stderr, "Page faults: %ld minor, %ld major\n",
+			ru->ru_minflt, ru->ru_majflt);
+		fprintf(stderr, "Context switches: %ld voluntary, %ld involuntary\n",
+			ru->ru_nvcsw, ru->ru_nivcsw);
+	}
+
+	fprintf(stderr, "\n%4s %8s %10s %12s  %s\n",
+		"Type", "Count", "Bytes", "Decode (ms)", "Name");
+	for (i = 0; i < 256; i++)
+	{
+		if (!stats.type[i].count)
+			continue;
+		fprintf(stderr, "%4d %8u %10llu ", i, stats.type[i].count,
+			stats.type[i].bytes);
+		print_ms("%12s  ", stats.type[i].ns);
+		fprintf(stderr, "%s\n", type_name(i));
+	}
+}
+
+/* One JSON object, times in microseconds */
+static void print_json(const struct rusage *ru, unsigned long writes,
+		       unsigned long long written)
+{
+	unsigned long long total = 0;
+	int i, n = 0;
+
+	fprintf(stderr, "{\"phases_us\": {");
+	for (i = 0; i < STATS_PHASES; i++)
+	{
+		fprintf(stderr, "\"%s\": %llu, ", phase_key[i],
+			stats.ns[i] / 1000);
+		total += stats.ns[i];
+	}
+	fprintf(stderr, "\"total\": %llu}", total / 1000);
+
+	fprintf(stderr, ", \"read_bytes\": %llu", stats.read);
+	fprintf(stderr, ", \"written_bytes\": %llu, \"write_calls\": %lu",
+		written, writes);
+	if (ru != NULL)
+		fprintf(stderr, ", \"user_us\": %llu, \"system_us\": %llu"
+			", \"max_rss_kb\": %ld, \"minor_faults\": %ld"
+			", \"major_faults\": %ld, \"voluntary_switches\": %ld"
+			", \"involuntary_switches\": %ld",
+			tv_ns(&ru->ru_utime) / 1000, tv_ns(&ru->ru_stime) / 1000,
+			ru->ru_maxrss, ru->ru_minflt, ru->ru_majflt,
+			ru->ru_nvcsw, ru->ru_nivcsw);
+
+	fprintf(stderr, ", \"types\": [");
+	for (i = 0; i < 256; i++)
+	{
+		if (!stats.type[i].count)
+			continue;
+		fprintf(stderr, "%s{\"type\": %d, \"count\": %u, \"bytes\": %llu"
+			", \"decode_us\": %llu}", n++ ? ", " : "", i,
+			stats.type[i].count, stats.type[i].bytes,
+			stats.type[i].ns / 1000);
+	}
+	fprintf(stderr, "]}\n");
+}
+
+/* Must be called after pr_end(), so that all output is accounted for */
+void dmi_stats_print(int format, const char *(*type_name)(u8 type))
+{
+	struct rusage ru;
+	unsigned long writes;
+	unsigned long long written;
+
+	if (!stats.started)
+		return;
+
+	dmi_stats_phase(stats.phase);
+	pr_counters(&writes, &written);
+
+	if (format == STATS_FORMAT_JSON)
+		print_json(getrusage(RUSAGE_SELF, &ru) == 0 ? &ru : NULL,
+			   writes, written);
+	else
+		print_text(getrusage(RUSAGE_SELF, &ru) == 0 ? &ru : NULL,
+			   writes, written, type_name);
+}
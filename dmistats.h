@@ -0,0 +1,48 @@
+/*
+ * Run-time statistics of dmidecode (--stats)
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ */
+
+#ifndef DMISTATS_H
+#define DMISTATS_H
+
+#include <stddef.h>
+#include "types.h"
+
+enum dmi_stats_phase
+{
+	STATS_ENTRY_POINT,
+	STATS_TABLE_READ,
+	STATS_INDEX,
+	STATS_DECODE,
+	STATS_OUTPUT,
+	STATS_PHASES
+};
+
+#define STATS_FORMAT_TEXT	0
+#define STATS_FORMAT_JSON	1
+
+void dmi_stats_start(void);
+void dmi_stats_phase(enum dmi_stats_phase phase);
+void dmi_stats_read(size_t len);
+unsigned long long dmi_stats_now(void);
+void dmi_stats_type(u8 type, u32 size, unsigned long long ns);
+void dmi_stats_print(int format, const char *(*type_name)(u8 type));
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Static tracepoints (USDT)
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * When compiled with USE_SDT defined, the probes below are SystemTap SDT
+ * probes of provider "dmidecode", which bpftrace, perf and SystemTap can
+ * attach to. Each probe is a single nop instruction until something
+ * attaches to it. Otherwise the probes compile to nothing.
+ *
+ * mem_chunk_start(base, len, devmem)
+ * mem_chunk_done(base, len, ok)
+ * read_file_start(base, len, filename)
+ * read_file_done(base, len, ok)
+ *	Reads from memory devices and files (util.c)
+ * entry_point_search(method)
+ *	Looking for an entry point: "sysfs", "efi", "memory" or "dump"
+ * entry_point_found(version, table base, table len, structure count)
+ *	Valid entry point, version encoded as in SMBIOS 3 (0xMMmmrr),
+ *	structure count is 0 if not announced
+ * structure_start(type, handle, length, offset)
+ * structure_done(type, handle, length, offset)
+ *	Decoding of each structure, offset is in the table
+ * oem_decode(type, handle, vendor, decoded)
+ *	Dispatch of an OEM-specific structure to the vendor decoder
+ */
+
+#ifndef PROBES_H
+#define PROBES_H
+
+#ifdef USE_SDT
+#include <sys/sdt.h>
+
+#define DMI_PROBE1(name, a) \
+	DTRACE_PROBE1(dmidecode, name, a)
+#define DMI_PROBE3(name, a, b, c) \
+	DTRACE_PROBE3(dmidecode, name, a, b, c)
+#define DMI_PROBE4(name, a, b, c, d) \
+	DTRACE_PROBE4(dmidecode, name, a, b, c, d)
+#else
+#define DMI_PROBE1(name, a) do { } while (0)
+#define DMI_PROBE3(name, a, b, c) do { } while (0)
+#define DMI_PROBE4(name, a, b, c, d) do { } while (0)
+#endif
+
+#endif
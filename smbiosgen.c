@@ -0,0 +1,859 @@
+/*
+ * Synthetic SMBIOS table generator
+ * This file is part of the dmidecode project.
+ *
+ *   Copyright (C) 2026 The dmidecode authors
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+ *
+ * smbios-gen writes made up SMBIOS tables, in the same layout as the files
+ * written by "dmidecode --dump-bin": an SMBIOS 3 entry point at offset 0
+ * and the table at offset 32. It is meant for benchmarking and testing
+ * dmidecode with tables larger, or more broken, than real ones.
+ *
+ * Structures are generated by type, in increasing type order, with the
+ * end-of-table structure last. For the common types, string fields point
+ * to actual strings and handle fields to structures of the right type.
+ * Everything else is pseudo-random, but the same options always give the
+ * same file. Structures of other types are random, without strings.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+
+#include "version.h"
+#include "config.h"
+#include "types.h"
+#include "util.h"
+
+/* Strings of each OEM Strings and System Configuration Options structure */
+#define GEN_OEM_STRINGS		4
+
+/* Handles 0xFFFE and 0xFFFF have special meanings */
+#define GEN_HANDLES		0xFFFE
+
+/* Corruptions */
+#define CORRUPT_LENGTH		(1 << 0)
+#define CORRUPT_STRING		(1 << 1)
+#define CORRUPT_HANDLE		(1 << 2)
+#define CORRUPT_EOT		(1 << 3)
+#define CORRUPT_TRUNCATE	(1 << 4)
+#define CORRUPT_CHECKSUM	(1 << 5)
+
+/* Options are global */
+struct opt
+{
+	unsigned int flags;
+	unsigned int count[256];	/* Structures of each type */
+	int types;			/* Types were given */
+	u32 version;			/* As in the entry point, 0xMMmmrr */
+	unsigned int string_min;
+	unsigned int string_max;
+	const struct gen_vendor *vendor;
+	unsigned int corrupt;
+	unsigned long corrupt_at[6];	/* Structure to corrupt, by bit */
+	u32 seed;
+	const char *file;
+};
+static struct opt opt;
+
+#define FLAG_VERSION            (1 << 0)
+#define FLAG_HELP               (1 << 1)
+
+/*
+ * Structures of known layout: formatted area length, offsets of the
+ * string fields, offsets of the handle fields along with the type they
+ * refer to, and offsets of the count fields which must be 0 for the
+ * length to be right. Some OEM structures are only decoded if they start
+ * with a signature (at offset 0x04) or if their first string is a given
+ * one.
+ */
+struct gen_template
+{
+	u8 type;
+	u8 length;
+	u8 string[8];		/* 0-terminated */
+	struct { u8 offset, type; } ref[3];	/* offset 0 ends */
+	u8 zero[3];		/* 0-terminated */
+	const char *signature;
+	const char *string1;
+};
+
+static const struct gen_template template[] = {
+	{ 0, 0x1A, { 0x04, 0x05, 0x08 }, { { 0, 0 } }, { 0 }, NULL, NULL },
+	{ 1, 0x1B, { 0x04, 0x05, 0x06, 0x07, 0x19, 0x1A }, { { 0, 0 } }, { 0 },
+		NULL, NULL },
+	{ 2, 0x0F, { 0x04, 0x05, 0x06, 0x07, 0x08, 0x0A }, { { 0x0B, 3 } },
+		{ 0x0E }, NULL, NULL },
+	{ 3, 0x16, { 0x04, 0x06, 0x07, 0x08, 0x15 }, { { 0, 0 } },
+		{ 0x13, 0x14 }, NULL, NULL },
+	{ 4, 0x32, { 0x04, 0x07, 0x10, 0x20, 0x21, 0x22 },
+		{ { 0x1A, 7 }, { 0x1C, 7 }, { 0x1E, 7 } }, { 0 }, NULL, NULL },
+	{ 7, 0x1B, { 0x04 }, { { 0, 0 } }, { 0 }, NULL, NULL },
+	{ 8, 0x09, { 0x04, 0x06 }, { { 0, 0 } }, { 0 }, NULL, NULL },
+	{ 9, 0x11, { 0x04 }, { { 0, 0 } }, { 0 }, NULL, NULL },
+	{ 16, 0x17, { 0 }, { { 0, 0 } }, { 0 }, NULL, NULL },
+	{ 17, 0x5C, { 0x10, 0x11, 0x17, 0x18, 0x19, 0x1A, 0x2B },
+		{ { 0x04, 16 } }, { 0 }, NULL, NULL },
+	{ 19, 0x1F, { 0 }, { { 0x0C, 16 } }, { 0 }, NULL, NULL },
+	{ 20, 0x23, { 0 }, { { 0x0C, 17 }, { 0x0E, 19 } }, { 0 }, NULL, NULL },
+	{ 32, 0x0B, { 0 }, { { 0, 0 } }, { 0 }, NULL, NULL },
+	{ 41, 0x0B, { 0x04 }, { { 0, 0 } }, { 0 }, NULL, NULL },
+	{ 131, 0x16, { 0 }, { { 0, 0 } }, { 0 }, NULL, "TVT-Enablement" },
+	{ 135, 0x0A, { 0 }, { { 0, 0 } }, { 0 }, "TP\x07\x03\x01", NULL },
+	{ 140, 0x0F, { 0x0D, 0x0E }, { { 0, 0 } }, { 0 }, "LENOVO\x0B\x07\x01",
+		NULL },
+};
+
+/* Length of the structures of other types */
+#define GEN_LENGTH_STANDARD	0x10
+#define GEN_LENGTH_OEM		0x40
+
+/*
+ * Vendor personalities: the strings which make dmidecode use the vendor's
+ * decoders, and the OEM types these decoders know about.
+ */
+struct gen_vendor
+{
+	const char *name;
+	const char *manufacturer;
+	const char *product;
+	u8 oem[24];		/* 0-terminated */
+};
+
+static const struct gen_vendor vendor[] = {
+	{ "acer", "Acer", "Aspire 5", { 170 } },
+	{ "dell", "Dell Inc.", "PowerEdge R740", { 177, 178, 212, 218 } },
+	{ "hp", "HP", "ProLiant DL360 Gen9",
+		{ 194, 197, 199, 203, 204, 209, 212, 216, 219, 221, 224, 230,
+		  233, 236, 237, 238, 239, 240, 242, 245 } },
+	{ "hpe", "HPE", "ProLiant DL380 Gen10",
+		{ 194, 197, 199, 203, 204, 209, 212, 216, 219, 221, 224, 230,
+		  233, 236, 237, 238, 239, 240, 242, 245 } },
+	{ "ibm", "IBM", "System x3650 M5", { 131, 135, 140 } },
+	{ "lenovo", "LENOVO", "ThinkSystem SR650", { 131, 135, 140 } },
+};
+
+/* Table used when no type is given */
+static const struct { u8 type; unsigned int count; } default_types[] = {
+	{ 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 }, { 4, 2 }, { 7, 6 }, { 8, 4 },
+	{ 9, 4 }, { 11, 1 }, { 16, 1 }, { 17, 8 }, { 19, 1 }, { 20, 8 },
+	{ 32, 1 }, { 41, 2 },
+};
+
+static const struct { const char *keyword; unsigned int bit; } corruption[] = {
+	{ "length", CORRUPT_LENGTH },
+	{ "string", CORRUPT_STRING },
+	{ "handle", CORRUPT_HANDLE },
+	{ "eot", CORRUPT_EOT },
+	{ "truncate", CORRUPT_TRUNCATE },
+	{ "checksum", CORRUPT_CHECKSUM },
+};
+
+/*
+ * Pseudo-random numbers (xorshift32), reproducible across platforms
+ */
+
+static u32 rnd_state;
+
+static u32 rnd(void)
+{
+	u32 x = rnd_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return rnd_state = x;
+}
+
+/*
+ * Table being built
+ */
+
+struct gen_table
+{
+	u8 *buf;
+	size_t len;
+	size_t size;
+	unsigned long count;		/* Structures */
+	size_t *offset;			/* Of each structure */
+};
+
+static u8 *gen_reserve(struct gen_table *t, size_t len)
+{
+	if (t->size - t->len < len)
+	{
+		size_t size = t->size ? t->size : 64 * 1024;
+		u8 *p;
+
+		while (size - t->len < len)
+			size *= 2;
+		p = realloc(t->buf, size);
+		if (p == NULL)
+		{
+			perror("realloc");
+			return NULL;
+		}
+		t->buf = p;
+		t->size = size;
+	}
+
+	return t->buf + t->len;
+}
+
+static int gen_string(struct gen_table *t, const char *s)
+{
+	static const char charset[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789 -";
+	unsigned int i, len;
+	u8 *p;
+
+	if (s != NULL)
+		len = strlen(s);
+	else
+		len = opt.string_min
+		    + rnd() % (opt.string_max - opt.string_min + 1);
+
+	if ((p = gen_reserve(t, len + 1)) == NULL)
+		return -1;
+
+	if (s != NULL)
+		memcpy(p, s, len);
+	else
+		for (i = 0; i < len; i++)
+			p[i] = charset[rnd() % (sizeof(charset) - 1)];
+	p[len] = '\0';
+	t->len += len + 1;
+
+	return 0;
+}
+
+static const struct gen_template *gen_template(u8 type)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(template); i++)
+		if (template[i].type == type)
+			return &template[i];
+
+	return NULL;
+}
+
+/* Fixed strings of the vendor personality, NULL for a random string */
+static const char *gen_vendor_string(u8 type, u8 offset)
+{
+	if (opt.vendor == NULL)
+		return NULL;
+	if ((type == 0 || type == 1) && offset == 0x04)
+		return opt.vendor->manufacturer;
+	if (type == 1 && offset == 0x05)
+		return opt.vendor->product;
+
+	return NULL;
+}
+
+/*
+ * Add the n-th structure of its type. first[] is the number of the first
+ * structure of each type, so that handle fields can refer to them (in
+ * turn, if there are several).
+ */
+static int gen_structure(struct gen_table *t, u8 type, unsigned long n,
+			 const unsigned long *first)
+{
+	const struct gen_template *tpl = gen_template(type);
+	unsigned int length, strings = 0, i;
+	size_t start = t->len;
+	u8 *p;
+
+	if (type == 127)
+		length = 4;
+	else if (tpl != NULL)
+		length = tpl->length;
+	else if (type == 11 || type == 12)
+		length = 5;
+	else
+		length = type >= 128 ? GEN_LENGTH_OEM : GEN_LENGTH_STANDARD;
+
+	if ((p = gen_reserve(t, length)) == NULL)
+		return -1;
+	t->offset[t->count] = start;
+
+	for (i = 4; i < length; i++)
+		p[i] = rnd();
+	p[0] = type;
+	p[1] = length;
+	p[2] = ((first[type] + n) % GEN_HANDLES) & 0xFF;
+	p[3] = ((first[type] + n) % GEN_HANDLES) >> 8;
+
+	if (tpl != NULL)
+	{
+		for (i = 0; i < ARRAY_SIZE(tpl->zero) && tpl->zero[i]; i++)
+			p[tpl->zero[i]] = 0;
+		for (i = 0; i < ARRAY_SIZE(tpl->ref) && tpl->ref[i].offset; i++)
+		{
+			u8 ref = tpl->ref[i].type;
+			unsigned long h = 0xFFFF;
+
+			if (opt.count[ref])
+				h = (first[ref] + n % opt.count[ref]) % GEN_HANDLES;
+			p[tpl->ref[i].offset] = h & 0xFF;
+			p[tpl->ref[i].offset + 1] = h >> 8;
+		}
+		for (i = 0; i < ARRAY_SIZE(tpl->string) && tpl->string[i]; i++)
+			p[tpl->string[i]] = ++strings;
+		if (tpl->signature != NULL)
+			memcpy(p + 4, tpl->signature, strlen(tpl->signature));
+		if (tpl->string1 != NULL && strings == 0)
+			strings = 1;
+	}
+	else if (type == 11 || type == 12)
+		p[0x04] = strings = GEN_OEM_STRINGS;
+	else if (type == 127)
+		p[2] = p[3] = 0xFF;
+	t->len += length;
+
+	/* Strings, in order of their fields */
+	for (i = 0; i < strings; i++)
+	{
+		const char *s = NULL;
+
+		if (tpl != NULL && i == 0 && tpl->string1 != NULL)
+			s = tpl->string1;
+		else if (tpl != NULL)
+			s = gen_vendor_string(type, tpl->string[i]);
+		if (gen_string(t, s) < 0)
+			return -1;
+	}
+
+	/* A double NUL ends the structure, which is a single one if needed */
+	if ((p = gen_reserve(t, 2)) == NULL)
+		return -1;
+	p[0] = p[1] = '\0';
+	t->len += strings ? 1 : 2;
+	t->count++;
+
+	return 0;
+}
+
+/* First structure at or after n with a string field, or count */
+static unsigned long gen_find_string(const struct gen_table *t,
+				     unsigned long n)
+{
+	for (; n < t->count; n++)
+	{
+		const u8 *p = t->buf + t->offset[n];
+		const struct gen_template *tpl = gen_template(p[0]);
+
+		if (tpl != NULL && tpl->string[0])
+			return n;
+	}
+
+	return t->count;
+}
+
+static unsigned long gen_corrupt_at(const struct gen_table *t,
+				    unsigned int bit)
+{
+	unsigned int i;
+
+	for (i = 0; !(bit & (1 << i)); i++)
+		;
+	/* ~0 means the middle of the table */
+	if (opt.corrupt_at[i] == ~0UL)
+		return t->count / 2;
+	return opt.corrupt_at[i];
+}
+
+/* Returns -1 if a corruption can't be applied */
+static int gen_corrupt(struct gen_table *t)
+{
+	unsigned long n;
+	u8 *p;
+
+	if (opt.corrupt & CORRUPT_STRING)
+	{
+		n = gen_find_string(t, gen_corrupt_at(t, CORRUPT_STRING));
+		if (n >= t->count)
+		{
+			fprintf(stderr, "No structure with strings to corrupt\n");
+			return -1;
+		}
+		p = t->buf + t->offset[n];
+		p[gen_template(p[0])->string[0]] = 0xFF;
+	}
+
+	if (opt.corrupt & CORRUPT_HANDLE)
+	{
+		n = gen_corrupt_at(t, CORRUPT_HANDLE);
+		if (n == 0 || n >= t->count)
+		{
+			fprintf(stderr, "Can't duplicate the handle of structure %lu\n", n);
+			return -1;
+		}
+		p = t->buf + t->offset[n];
+		memcpy(p + 2, t->buf + t->offset[n - 1] + 2, 2);
+	}
+
+	if (opt.corrupt & CORRUPT_LENGTH)
+	{
+		n = gen_corrupt_at(t, CORRUPT_LENGTH);
+		if (n >= t->count)
+		{
+			fprintf(stderr, "Can't corrupt the length of structure %lu\n", n);
+			return -1;
+		}
+		t->buf[t->offset[n] + 1] = 3;
+	}
+
+	/* Cut the last structure (before the end-of-table one) in half */
+	if (opt.corrupt & CORRUPT_TRUNCATE)
+	{
+		n = t->count - 1;
+		if (!(opt.corrupt & CORRUPT_EOT))
+			n--;
+		if (n >= t->count)
+		{
+			fprintf(stderr, "No structure to truncate\n");
+			return -1;
+		}
+		t->len = t->offset[n] + t->buf[t->offset[n] + 1] / 2;
+		t->count = n + 1;
+	}
+
+	return 0;
+}
+
+static int gen_table(struct gen_table *t)
+{
+	unsigned long first[256], total = 0;
+	unsigned int type;
+
+	/* Number of the first structure of each type, and handle */
+	for (type = 0; type < 256; type++)
+	{
+		if (type == 127)
+			continue;
+		first[type] = total;
+		total += opt.count[type];
+	}
+	first[127] = total;
+	total += opt.count[127];
+
+	t->offset = malloc((total ? total : 1) * sizeof(size_t));
+	if (t->offset == NULL)
+	{
+		perror("malloc");
+		return -1;
+	}
+
+	/* Types in increasing order, except for the end-of-table one */
+	for (type = 0; type < 256; type++)
+	{
+		unsigned long n;
+
+		if (type == 127)
+			continue;
+		for (n = 0; n < opt.count[type]; n++)
+			if (gen_structure(t, type, n, first) < 0)
+				return -1;
+	}
+	if (opt.count[127] && gen_structure(t, 127, 0, first) < 0)
+		return -1;
+
+	return gen_corrupt(t);
+}
+
+/* Write the entry point and the table, as dmi_table_dump() does */
+static int gen_write(const struct gen_table *t)
+{
+	u8 ep[32];
+	int fd;
+	FILE *f;
+
+	memset(ep, 0, sizeof(ep));
+	memcpy(ep, "_SM3_", 5);
+	ep[0x06] = 0x18;
+	ep[0x07] = opt.version >> 16;
+	ep[0x08] = opt.version >> 8;
+	ep[0x09] = opt.version;
+	ep[0x0A] = 0x01;
+	ep[0x0C] = t->len;
+	ep[0x0D] = t->len >> 8;
+	ep[0x0E] = t->len >> 16;
+	ep[0x0F] = t->len >> 24;
+	ep[0x10] = 32;
+	ep[0x05] = -(u8)(ep[0x00] + ep[0x01] + ep[0x02] + ep[0x03] + ep[0x04]
+			 + ep[0x06] + ep[0x07] + ep[0x08] + ep[0x09] + ep[0x0A]
+			 + ep[0x0C] + ep[0x0D] + ep[0x0E] + ep[0x0F] + ep[0x10]);
+	if (opt.corrupt & CORRUPT_CHECKSUM)
+		ep[0x05]++;
+
+	fd = open(opt.file, O_WRONLY|O_CREAT|O_EXCL, 0666);
+	if (fd == -1)
+	{
+		fprintf(stderr, "%s: ", opt.file);
+		perror("open");
+		return -1;
+	}
+
+	f = fdopen(fd, "wb");
+	if (!f)
+	{
+		fprintf(stderr, "%s: ", opt.file);
+		perror("fdopen");
+		close(fd);
+		return -1;
+	}
+
+	if (fwrite(ep, sizeof(ep), 1, f) != 1
+	 || (t->len && fwrite(t->buf, t->len, 1, f) != 1))
+	{
+		fprintf(stderr, "%s: ", opt.file);
+		perror("fwrite");
+		fclose(f);
+		return -1;
+	}
+
+	if (fclose(f))
+	{
+		fprintf(stderr, "%s: ", opt.file);
+		perror("fclose");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Command line options handling
+ */
+
+/* TYPE:COUNT, returns -1 on error */
+static int parse_opt_type(const char *arg)
+{
+	unsigned long type, count;
+	const char *p;
+	char *next;
+
+	type = strtoul(arg, &next, 0);
+	if (next == arg || *next != ':' || type > 0xFF)
+		goto invalid;
+	p = next + 1;
+	count = strtoul(p, &next, 0);
+	if (next == p || *next != '\0' || count > 1000000)
+		goto invalid;
+
+	opt.count[type] = count;
+	opt.types = 1;
+	return 0;
+
+invalid:
+	fprintf(stderr, "Invalid type specification: %s\n", arg);
+	fprintf(stderr, "Expected TYPE:COUNT, with COUNT up to 1000000\n");
+	return -1;
+}
+
+/* MIN[-MAX], returns -1 on error */
+static int parse_opt_string_size(const char *arg)
+{
+	unsigned long min, max;
+	const char *p = arg;
+	char *next;
+
+	min = max = strtoul(p, &next, 0);
+	if (next != p && *next == '-')
+	{
+		p = next + 1;
+		max = strtoul(p, &next, 0);
+	}
+	if (next == p || *next != '\0' || min == 0 || max < min || max > 4096)
+	{
+		fprintf(stderr, "Invalid string size: %s\n", arg);
+		return -1;
+	}
+
+	opt.string_min = min;
+	opt.string_max = max;
+	return 0;
+}
+
+/* MAJOR.MINOR[.DOCREV], returns -1 on error */
+static int parse_opt_smbios_version(const char *arg)
+{
+	unsigned long v[3] = { 0, 0, 0 };
+	const char *p = arg;
+	char *next;
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		v[i] = strtoul(p, &next, 10);
+		if (next == p || v[i] > 0xFF)
+			goto invalid;
+		if (*next == '\0' && i >= 1)
+			break;
+		if (*next != '.')
+			goto invalid;
+		p = next + 1;
+	}
+	if (i == 3 || v[0] < 3)
+		goto invalid;
+
+	opt.version = (v[0] << 16) | (v[1] << 8) | v[2];
+	return 0;
+
+invalid:
+	fprintf(stderr, "Invalid SMBIOS version: %s\n", arg);
+	fprintf(stderr, "Expected MAJOR.MINOR[.DOCREV], 3.0 or later\n");
+	return -1;
+}
+
+static int parse_opt_vendor(const char *arg)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(vendor); i++)
+	{
+		if (!strcasecmp(arg, vendor[i].name))
+		{
+			opt.vendor = &vendor[i];
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "Invalid vendor: %s\n", arg);
+	fprintf(stderr, "Valid vendors are:");
+	for (i = 0; i < ARRAY_SIZE(vendor); i++)
+		fprintf(stderr, " %s", vendor[i].name);
+	fprintf(stderr, "\n");
+	return -1;
+}
+
+/* KIND[:N], returns -1 on error */
+static int parse_opt_corrupt(const char *arg)
+{
+	const char *colon = strchr(arg, ':');
+	size_t len = colon ? (size_t)(colon - arg) : strlen(arg);
+	unsigned int i, bit;
+	unsigned long n = ~0UL;
+	char *next;
+
+	if (colon != NULL)
+	{
+		n = strtoul(colon + 1, &next, 0);
+		if (next == colon + 1 || *next != '\0')
+		{
+			fprintf(stderr, "Invalid structure number: %s\n", colon + 1);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(corruption); i++)
+	{
+		if (strlen(corruption[i].keyword) == len
+		 && !strncasecmp(arg, corruption[i].keyword, len))
+		{
+			opt.corrupt |= corruption[i].bit;
+			for (bit = 0; !(corruption[i].bit & (1 << bit)); bit++)
+				;
+			opt.corrupt_at[bit] = n;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "Invalid corruption: %s\n", arg);
+	fprintf(stderr, "Valid corruptions are:");
+	for (i = 0; i < ARRAY_SIZE(corruption); i++)
+		fprintf(stderr, " %s", corruption[i].keyword);
+	fprintf(stderr, "\n");
+	return -1;
+}
+
+static int parse_command_line(int argc, char * const argv[])
+{
+	int option;
+	unsigned long seed;
+	char *next;
+	const char *optstring = "c:hr:s:t:v:V";
+	struct option longopts[] = {
+		{ "corrupt", required_argument, NULL, 'c' },
+		{ "help", no_argument, NULL, 'h' },
+		{ "seed", required_argument, NULL, 'r' },
+		{ "string-size", required_argument, NULL, 's' },
+		{ "smbios-version", required_argument, NULL, 'S' },
+		{ "type", required_argument, NULL, 't' },
+		{ "vendor", required_argument, NULL, 'v' },
+		{ "version", no_argument, NULL, 'V' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	while ((option = getopt_long(argc, argv, optstring, longopts, NULL)) != -1)
+		switch (option)
+		{
+			case 'c':
+				if (parse_opt_corrupt(optarg) < 0)
+					return -1;
+				break;
+			case 'h':
+				opt.flags |= FLAG_HELP;
+				break;
+			case 'r':
+				seed = strtoul(optarg, &next, 0);
+				if (next == optarg || *next != '\0')
+				{
+					fprintf(stderr, "Invalid seed: %s\n", optarg);
+					return -1;
+				}
+				/* xorshift32 gets stuck at 0 */
+				opt.seed = seed ? seed : 1;
+				break;
+			case 's':
+				if (parse_opt_string_size(optarg) < 0)
+					return -1;
+				break;
+			case 'S':
+				if (parse_opt_smbios_version(optarg) < 0)
+					return -1;
+				break;
+			case 't':
+				if (parse_opt_type(optarg) < 0)
+					return -1;
+				break;
+			case 'v':
+				if (parse_opt_vendor(optarg) < 0)
+					return -1;
+				break;
+			case 'V':
+				opt.flags |= FLAG_VERSION;
+				break;
+			case '?':
+				return -1;
+		}
+
+	if (opt.flags & (FLAG_HELP | FLAG_VERSION))
+		return 0;
+
+	if (optind != argc - 1)
+	{
+		fprintf(stderr, "Exactly one output file expected\n");
+		return -1;
+	}
+	opt.file = argv[optind];
+
+	return 0;
+}
+
+static void print_help(void)
+{
+	static const char *help =
+		"Usage: smbios-gen [OPTIONS] FILE\n"
+		"Write a made up SMBIOS table to FILE, in the format of dmidecode --dump-bin\n"
+		"Options are:\n"
+		" -t, --type TYPE:COUNT  Generate COUNT structures of type TYPE\n"
+		" -s, --string-size MIN[-MAX]\n"
+		"                        Length of the generated strings (default: 16)\n"
+		" -v, --vendor VENDOR    Mimic a vendor (acer, dell, hp, hpe, ibm, lenovo)\n"
+		" -c, --corrupt KIND[:N] Break the table on purpose, at structure N\n"
+		"                        (length, string, handle, eot, truncate, checksum)\n"
+		"     --smbios-version VERSION\n"
+		"                        SMBIOS version of the entry point (default: 3.7.0)\n"
+		" -r, --seed N           Seed of the pseudo-random contents (default: 1)\n"
+		" -h, --help             Display this help text and exit\n"
+		" -V, --version          Display the version and exit\n";
+
+	printf("%s", help);
+}
+
+int main(int argc, char * const argv[])
+{
+	struct gen_table t;
+	unsigned int i;
+	unsigned long total = 0;
+
+	if (sizeof(u8) != 1 || sizeof(u16) != 2 || sizeof(u32) != 4)
+	{
+		fprintf(stderr, "%s: compiler incompatibility\n", argv[0]);
+		exit(255);
+	}
+
+	/* Set default option values */
+	opt.flags = 0;
+	opt.version = 0x030700;
+	opt.string_min = opt.string_max = 16;
+	opt.seed = 1;
+
+	if (parse_command_line(argc, argv) < 0)
+		exit(2);
+
+	if (opt.flags & FLAG_HELP)
+	{
+		print_help();
+		return 0;
+	}
+
+	if (opt.flags & FLAG_VERSION)
+	{
+		printf("%s\n", VERSION);
+		return 0;
+	}
+
+	if (!opt.types)
+	{
+		for (i = 0; i < ARRAY_SIZE(default_types); i++)
+			opt.count[default_types[i].type] = default_types[i].count;
+		if (opt.vendor != NULL)
+			for (i = 0; i < ARRAY_SIZE(opt.vendor->oem) && opt.vendor->oem[i]; i++)
+				opt.count[opt.vendor->oem[i]] = 1;
+	}
+
+	/* dmidecode recognizes the vendor from the BIOS and system entries */
+	if (opt.vendor != NULL)
+	{
+		if (!opt.count[0])
+			opt.count[0] = 1;
+		if (!opt.count[1])
+			opt.count[1] = 1;
+	}
+
+	/* The end-of-table structure comes last, exactly once */
+	opt.count[127] = !(opt.corrupt & CORRUPT_EOT);
+
+	for (i = 0; i < 256; i++)
+		total += opt.count[i];
+	if (total > 16 * 1024 * 1024)
+	{
+		fprintf(stderr, "Too many structures (%lu)\n", total);
+		exit(2);
+	}
+
+	memset(&t, 0, sizeof(t));
+	rnd_state = opt.seed;
+	if (gen_table(&t) < 0 || gen_write(&t) < 0)
+	{
+		free(t.offset);
+		free(t.buf);
+		exit(1);
+	}
+
+	free(t.offset);
+	free(t.buf);
+
+	return 0;
+}
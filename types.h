@@ -1,8 +1,6 @@
 #ifndef TYPES_H
 #define TYPES_H
 
-#include "config.h"
-
 typedef unsigned char u8;
 typedef unsigned short u16;
 typedef signed short i16;
@@ -14,10 +12,16 @@ typedef unsigned int u32;
  * - Define BIGENDIAN on big-endian systems.
  * - Define ALIGNMENT_WORKAROUND if your system doesn't support
  *   non-aligned memory access. In this case, we use a slower, but safer,
- *   memory access method. This should be done automatically in config.h
- *   for architectures which need it.
+ *   memory access method. This is done automatically below for
+ *   architectures which need it (not in config.h, as this header is
+ *   installed along with libdmidecode).
  */
 
+/* Use memory alignment workaround or not */
+#if defined(__ia64__) || defined(__arm__)
+#define ALIGNMENT_WORKAROUND
+#endif
+
 #ifdef BIGENDIAN
 typedef struct {
 	u32 h;
@@ -44,8 +44,15 @@
 #include <fcntl.h>
 #include <errno.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "types.h"
 #include "util.h"
+#include "probes.h"
 
 static int myread(int fd, u8 *buf, size_t count, const char *prefix)
 {
@@ -101,6 +108,8 @@ void *read_file(off_t base, size_t *max_len, const char *filename)
 	int fd;
 	u8 *p;
 
+	DMI_PROBE3(read_file_start, base, *max_len, filename);
+
 	/*
 	 * Don't print error message on missing file, as we will try to read
 	 * files that may or may not be present.
@@ -109,6 +118,7 @@ void *read_file(off_t base, size_t *max_len, const char *filename)
 	{
 		if (errno != ENOENT)
 			perror(filename);
+		DMI_PROBE3(read_file_done, base, *max_len, 0);
 		return NULL;
 	}
 
@@ -152,9 +162,76 @@ void *read_file(off_t base, size_t *max_len, const char *filename)
 	if (close(fd) == -1)
 		perror(filename);
 
+	DMI_PROBE3(read_file_done, base, *max_len, p != NULL);
 	return p;
 }
 
+/*
+ * Map a regular file read-only, starting at offset base. This is the
+ * zero-copy version of read_file(): max_len is trimmed the same way, but
+ * nothing is printed on failure, so that the caller can fall back to
+ * read_file() and let it report errors. The view must be released with
+ * unmap_file().
+ */
+void *map_file(off_t base, size_t *max_len, const char *filename)
+{
+#ifdef USE_MMAP
+	struct stat statbuf;
+	off_t mmoffset;
+	void *mmp;
+	int fd;
+
+	if ((fd = open(filename, O_RDONLY)) == -1)
+		return NULL;
+
+	/* Only regular files can be safely mapped up to their size */
+	if (fstat(fd, &statbuf) == -1 || !S_ISREG(statbuf.st_mode)
+	 || base >= statbuf.st_size || *max_len == 0)
+	{
+		close(fd);
+		return NULL;
+	}
+	if (*max_len > (size_t)statbuf.st_size - base)
+		*max_len = statbuf.st_size - base;
+
+#ifdef _SC_PAGESIZE
+	mmoffset = base % sysconf(_SC_PAGESIZE);
+#else
+	mmoffset = base % getpagesize();
+#endif /* _SC_PAGESIZE */
+	mmp = mmap(NULL, mmoffset + *max_len, PROT_READ, MAP_PRIVATE, fd,
+		   base - mmoffset);
+	close(fd);
+	if (mmp == MAP_FAILED)
+		return NULL;
+
+	return (u8 *)mmp + mmoffset;
+#else
+	(void)base;
+	(void)max_len;
+	(void)filename;
+	return NULL;
+#endif /* USE_MMAP */
+}
+
+void unmap_file(void *p, size_t len)
+{
+#ifdef USE_MMAP
+	size_t mmoffset;
+
+#ifdef _SC_PAGESIZE
+	mmoffset = (size_t)p % sysconf(_SC_PAGESIZE);
+#else
+	mmoffset = (size_t)p % getpagesize();
+#endif /* _SC_PAGESIZE */
+	if (munmap((u8 *)p - mmoffset, mmoffset + len) == -1)
+		perror("munmap");
+#else
+	(void)p;
+	(void)len;
+#endif /* USE_MMAP */
+}
+
 #ifdef USE_MMAP
 static void safe_memcpy(void *dest, const void *src, size_t n)
 {
@@ -183,6 +260,8 @@ void *mem_chunk(off_t base, size_t len, const char *devmem)
 	void *mmp;
 #endif
 
+	DMI_PROBE3(mem_chunk_start, base, len, devmem);
+
 	/*
 	 * Safety check: if running as root, devmem is expected to be a
 	 * character device file.
@@ -193,7 +272,10 @@ void *mem_chunk(off_t base, size_t len, const char *devmem)
 	{
 		fprintf(stderr, "Can't read memory from %s\n", devmem);
 		if (fd == -1)
+		{
+			DMI_PROBE3(mem_chunk_done, base, len, 0);
 			return NULL;
+		}
 		goto out;
 	}
 
@@ -259,9 +341,68 @@ void *mem_chunk(off_t base, size_t len, const char *devmem)
 	if (close(fd) == -1)
 		perror(devmem);
 
+	DMI_PROBE3(mem_chunk_done, base, len, p != NULL);
 	return p;
 }
 
+/*
+ * Find the first pair of consecutive NUL bytes in a buffer, such as the
+ * terminator of an SMBIOS string set. Blocks of the buffer are checked
+ * with vector instructions where available, the remainder is checked
+ * one byte at a time.
+ *
+ * Returns the offset of the first NUL byte of the pair, or len if there
+ * is no such pair.
+ */
+size_t find_double_nul(const u8 *buf, size_t len)
+{
+	size_t i = 0;
+
+#if defined(__AVX2__)
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (; i + 33 <= len; i += 32)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i *)(const void *)(buf + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(const void *)(buf + i + 1));
+		u32 mask = _mm256_movemask_epi8(_mm256_and_si256(
+			_mm256_cmpeq_epi8(a, zero), _mm256_cmpeq_epi8(b, zero)));
+
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#elif defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; i + 17 <= len; i += 16)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *)(const void *)(buf + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(const void *)(buf + i + 1));
+		u32 mask = _mm_movemask_epi8(_mm_and_si128(
+			_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)));
+
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	for (; i + 17 <= len; i += 16)
+	{
+		uint8x16_t a = vceqzq_u8(vld1q_u8(buf + i));
+		uint8x16_t b = vceqzq_u8(vld1q_u8(buf + i + 1));
+
+		/* Let the scalar loop below locate the pair in this block */
+		if (vmaxvq_u8(vandq_u8(a, b)))
+			break;
+	}
+#endif
+
+	for (; i + 1 < len; i++)
+		if (buf[i] == 0 && buf[i + 1] == 0)
+			return i;
+
+	return len;
+}
+
 /* Returns end - start + 1, assuming start < end */
 u64 u64_range(u64 start, u64 end)
 {
@@ -277,3 +418,98 @@ u64 u64_range(u64 start, u64 end)
 
 	return res;
 }
+
+/*
+ * Hexadecimal dumps
+ *
+ * Bytes are converted with tables of their two hexadecimal digits, and
+ * rows are built whole in the caller's buffer, so that they can be
+ * written out in one go.
+ */
+
+#define HEX_UPPER(c) c "0" c "1" c "2" c "3" c "4" c "5" c "6" c "7" \
+		     c "8" c "9" c "A" c "B" c "C" c "D" c "E" c "F"
+#define HEX_LOWER(c) c "0" c "1" c "2" c "3" c "4" c "5" c "6" c "7" \
+		     c "8" c "9" c "a" c "b" c "c" c "d" c "e" c "f"
+
+static const char hex_upper[] =
+	HEX_UPPER("0") HEX_UPPER("1") HEX_UPPER("2") HEX_UPPER("3")
+	HEX_UPPER("4") HEX_UPPER("5") HEX_UPPER("6") HEX_UPPER("7")
+	HEX_UPPER("8") HEX_UPPER("9") HEX_UPPER("A") HEX_UPPER("B")
+	HEX_UPPER("C") HEX_UPPER("D") HEX_UPPER("E") HEX_UPPER("F");
+static const char hex_lower[] =
+	HEX_LOWER("0") HEX_LOWER("1") HEX_LOWER("2") HEX_LOWER("3")
+	HEX_LOWER("4") HEX_LOWER("5") HEX_LOWER("6") HEX_LOWER("7")
+	HEX_LOWER("8") HEX_LOWER("9") HEX_LOWER("a") HEX_LOWER("b")
+	HEX_LOWER("c") HEX_LOWER("d") HEX_LOWER("e") HEX_LOWER("f");
+
+/*
+ * Write len bytes as uppercase hexadecimal, separated by spaces, and
+ * terminated with a NUL byte. out must have room for 3 * len + 1 bytes.
+ * Returns the length written, not counting the NUL byte.
+ */
+size_t hex_bytes(char *out, const u8 *p, size_t len)
+{
+	char *q = out;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		memcpy(q, hex_upper + 2 * p[i], 2);
+		q[2] = ' ';
+		q += 3;
+	}
+	if (q != out)
+		q--;
+	*q = '\0';
+
+	return q - out;
+}
+
+/*
+ * Write len bytes as ASCII characters, with non-printable ones replaced
+ * by dots. No NUL byte is added. Returns len.
+ */
+size_t hex_ascii(char *out, const u8 *p, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		out[i] = (p[i] >= 32 && p[i] < 127) ? p[i] : '.';
+
+	return len;
+}
+
+/*
+ * Write a row of up to 16 bytes at offset off in the layout of xxd(1),
+ * new line included, so that it can be turned back into binary with
+ * xxd -r. out must have room for HEX_XXD_ROW bytes. Returns the length
+ * written, no NUL byte is added.
+ */
+size_t hex_xxd_row(char *out, u32 off, const u8 *p, size_t len)
+{
+	char *q = out;
+	size_t i;
+
+	for (i = 0; i < 4; i++, q += 2)
+		memcpy(q, hex_lower + 2 * ((off >> (24 - 8 * i)) & 0xFF), 2);
+	*q++ = ':';
+	*q++ = ' ';
+
+	for (i = 0; i < 16; i++)
+	{
+		if (i < len)
+			memcpy(q, hex_lower + 2 * p[i], 2);
+		else
+			q[0] = q[1] = ' ';
+		q += 2;
+		if (i & 1)
+			*q++ = ' ';
+	}
+	*q++ = ' ';
+
+	q += hex_ascii(q, p, len);
+	*q++ = '\n';
+
+	return q - out;
+}
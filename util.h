@@ -26,5 +26,15 @@
 
 int checksum(const u8 *buf, size_t len);
 void *read_file(off_t base, size_t *len, const char *filename);
+void *map_file(off_t base, size_t *max_len, const char *filename);
+void unmap_file(void *p, size_t len);
 void *mem_chunk(off_t base, size_t len, const char *devmem);
+size_t find_double_nul(const u8 *buf, size_t len);
 u64 u64_range(u64 start, u64 end);
+
+/* Longest row written by hex_xxd_row() */
+#define HEX_XXD_ROW 68
+
+size_t hex_bytes(char *out, const u8 *p, size_t len);
+size_t hex_ascii(char *out, const u8 *p, size_t len);
+size_t hex_xxd_row(char *out, u32 off, const u8 *p, size_t len);
@@ -63,25 +63,28 @@ static void print_entry(const char *name, const u8 *p, size_t len)
 
 static void dump(const u8 *p, u8 len)
 {
-	int done, i, min;
+	char row[3 + 1 + 47 + 5 + 16 + 2];
+	int done, min;
+	size_t n;
+	u8 off;
 
 	for (done = 0; done < len; done += 16)
 	{
-		printf("%02X:", done);
+		off = done;
+		n = hex_bytes(row, &off, 1);
+		row[n++] = ':';
+		row[n++] = ' ';
 		min = (len - done < 16) ? len - done : 16;
 
-		/* As hexadecimal first */
-		for (i = 0; i < min; i++)
-			printf(" %02X", p[done + i]);
-		for (; i < 16; i++) /* Complete line if needed */
-			printf("   ");
-		printf("     ");
+		/* As hexadecimal first, line completed if needed */
+		n += hex_bytes(row + n, p + done, min);
+		memset(row + n, ' ', 3 * (16 - min) + 5);
+		n += 3 * (16 - min) + 5;
 
 		/* And now as text, with ASCII filtering */
-		for (i = 0; i < min; i++)
-			printf("%c", (p[done + i] >= 32 && p[done + i] < 127) ?
-				p[done + i] : '.');
-		printf("\n");
+		n += hex_ascii(row + n, p + done, min);
+		row[n++] = '\n';
+		fwrite(row, 1, n, stdout);
 	}
 }
 